@@ -0,0 +1,166 @@
+#include "adapterindex.h"
+#include "adaptertrimmer.h"
+#include "filterresult.h"
+#include <string.h>
+
+ReadSeeds::ReadSeeds(const char* data, int len) {
+    reset(data, len);
+}
+
+void ReadSeeds::reset(const char* data, int len) {
+    memset(mHead, -1, sizeof(int) * 256);
+    if(len < 4)
+        return;
+    mNext.resize(len - 3);
+    int code = 0;
+    // the number of the ACGT bases in a row
+    int valid = 0;
+    for(int i=0; i<len; i++) {
+        int base = AdapterIndex::baseCode(data[i]);
+        if(base < 0) {
+            valid = 0;
+            continue;
+        }
+        code = ((code << 2) | base) & 0xFF;
+        valid++;
+        if(valid >= 4) {
+            mNext[i - 3] = mHead[code];
+            mHead[code] = i - 3;
+        }
+    }
+}
+
+AdapterIndex::AdapterIndex(const vector<string>& adapters) {
+    for(int a=0; a<adapters.size(); a++) {
+        const string& adapter = adapters[a];
+        bool alwaysCompared = false;
+        vector<uint8> blocks;
+        for(int t=0; (t + 1) * 4 <= adapter.length(); t++) {
+            int code = 0;
+            for(int i=t*4; i<t*4+4; i++) {
+                int base = baseCode(adapter[i]);
+                if(base < 0)
+                    alwaysCompared = true;
+                code = (code << 2) | (base & 0x03);
+            }
+            blocks.push_back(code);
+        }
+        // the bases of the last incomplete block are not in any block
+        for(int i=blocks.size()*4; i<adapter.length(); i++) {
+            if(baseCode(adapter[i]) < 0)
+                alwaysCompared = true;
+        }
+        mBlocks.push_back(blocks);
+        mLength.push_back(adapter.length());
+        mAlwaysCompared.push_back(alwaysCompared);
+    }
+}
+
+int AdapterIndex::alignmentStart(int alen) {
+    if(alen >= 16)
+        return -4;
+    else if(alen >= 12)
+        return -3;
+    else if(alen >= 8)
+        return -2;
+    return 0;
+}
+
+bool AdapterIndex::mayMatch(int adapter, ReadSeeds& seeds, int len, int matchReq) {
+    int alen = mLength[adapter];
+    if(alen < matchReq)
+        return false;
+    int start = alignmentStart(alen);
+    int end = len - matchReq;
+    if(start >= end)
+        return false;
+    if(mAlwaysCompared[adapter])
+        return true;
+    // an alignment before the read start needs 2 exact blocks, which is only sure if it compares 12 bases or more
+    if(start < 0 && min(len + 1, alen) < 12)
+        return true;
+
+    // the alignment positions of the exact blocks
+    int hitPos[ADAPTER_INDEX_MAX_HITS];
+    int hits = 0;
+    const vector<uint8>& blocks = mBlocks[adapter];
+    for(int t=0; t<blocks.size(); t++) {
+        for(int r = seeds.first(blocks[t]); r >= 0; r = seeds.next(r)) {
+            // the 4-mer is cropped out of the read
+            if(r + 4 > len)
+                continue;
+            int pos = r - t * 4;
+            if(pos < start || pos >= end)
+                continue;
+            int cmplen = min(len - pos, alen);
+            int required = cmplen / 4 - cmplen / 8 - (pos < 0 ? 1 : 0);
+            int exact = 1;
+            for(int i=0; i<hits; i++)
+                exact += hitPos[i] == pos;
+            if(exact >= required || hits == ADAPTER_INDEX_MAX_HITS)
+                return true;
+            hitPos[hits++] = pos;
+        }
+    }
+    return false;
+}
+
+bool AdapterIndex::test() {
+    unsigned int seed = 7;
+    const char bases[] = "ACGT";
+    vector<string> adapters;
+    for(int a=0; a<300; a++) {
+        seed = seed * 1103515245 + 12345;
+        string adapter(6 + (seed >> 16) % 55, 'A');
+        for(int i=0; i<adapter.length(); i++) {
+            seed = seed * 1103515245 + 12345;
+            adapter[i] = bases[(seed >> 16) % 4];
+        }
+        // some adapters have N or lowercase bases
+        if(a % 50 == 0)
+            adapter[adapter.length() / 2] = (a % 100 == 0) ? 'N' : 'c';
+        adapters.push_back(adapter);
+    }
+    AdapterIndex index(adapters);
+
+    Options opt;
+    FilterResult fr(&opt, false);
+    long compared = 0;
+    // the seeds are reused by the reads of different lengths, like the ones of a thread
+    ReadSeeds reused;
+    for(int n=0; n<3000; n++) {
+        seed = seed * 1103515245 + 12345;
+        int len = (seed >> 16) % 160;
+        string seq(len, 'A');
+        for(int i=0; i<len; i++) {
+            seed = seed * 1103515245 + 12345;
+            seq[i] = (seed >> 16) % 97 == 0 ? 'N' : bases[(seed >> 16) % 4];
+        }
+        // most reads have an adapter planted with some mismatches, and it can start before the read or end after it
+        seed = seed * 1103515245 + 12345;
+        if(n % 4 != 0 && len > 0) {
+            const string& adapter = adapters[(seed >> 16) % adapters.size()];
+            seed = seed * 1103515245 + 12345;
+            int pos = (int)((seed >> 16) % (len + 4)) - 4;
+            for(int i=max(0, -pos); i<adapter.length() && pos + i < len; i++) {
+                seed = seed * 1103515245 + 12345;
+                seq[pos + i] = (seed >> 16) % 12 == 0 ? bases[(seed >> 20) % 4] : adapter[i];
+            }
+        }
+        string qual(len, 'I');
+        Read r1("@name", seq, "+", qual);
+        Read r2("@name", seq, "+", qual);
+        bool trimmed1 = AdapterTrimmer::trimByMultiSequences(&r1, &fr, adapters);
+        bool trimmed2 = AdapterTrimmer::trimByMultiSequences(&r2, &fr, adapters, false, true, &index, n % 2 ? &reused : NULL);
+        if(trimmed1 != trimmed2 || r1.mSeq.mStr != r2.mSeq.mStr || r1.mQuality != r2.mQuality) {
+            cerr << "AdapterIndex::test: different trimming of " << seq << endl;
+            return false;
+        }
+
+        ReadSeeds seeds(seq.c_str(), len);
+        for(int a=0; a<adapters.size(); a++)
+            compared += index.mayMatch(a, seeds, len, 5);
+    }
+    // the index should skip most of the adapters, though the short ones and the alignments near the read end need few exact blocks
+    return compared < 3000L * adapters.size() / 4;
+}
@@ -0,0 +1,65 @@
+#ifndef ADAPTER_INDEX_H
+#define ADAPTER_INDEX_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include "common.h"
+
+using namespace std;
+
+// the max number of 4-mer hits of an adapter kept for a read, the adapter is simply compared if it has more
+#define ADAPTER_INDEX_MAX_HITS 64
+
+// the positions of the 4-mers (ACGT only) of a read, made once for a read and used for all the adapters
+// the read can be cropped after that, since a position is only used if its 4-mer is still in the read
+class ReadSeeds{
+public:
+    ReadSeeds() {}
+    ReadSeeds(const char* data, int len);
+    // index another read, the memory of the last one is reused
+    void reset(const char* data, int len);
+    // -1 if there is no more position of the 4-mer
+    inline int first(int code) {return mHead[code];}
+    inline int next(int pos) {return mNext[pos];}
+
+private:
+    int mHead[256];
+    vector<int> mNext;
+};
+
+// the adapters of --adapter_fasta compiled to the 4-mer codes of their blocks, the 4 bases at 4t
+// one mismatch is allowed for each 8 bases of an alignment, so if it compares the bases [0, c) of the adapter,
+// at least c/4 - c/8 of its blocks are exact, and one less if the first block is out of the read.
+// an adapter is only compared with a read if one of its alignments has enough exact blocks, so no match is missed
+class AdapterIndex{
+public:
+    AdapterIndex(const vector<string>& adapters);
+
+    // false if the adapter can't be found in the first len bases of the read by AdapterTrimmer::trimBySequence()
+    bool mayMatch(int adapter, ReadSeeds& seeds, int len, int matchReq);
+    int size() {return mLength.size();}
+
+    // the first alignment of an adapter, which is negative since the Illumina adapter dimer
+    // usually has the first A skipped as A-tailing
+    static int alignmentStart(int alen);
+    // the 2-bit code of a base, -1 if it's not ACGT
+    // it has no switch on the base, which would be mispredicted for most bases of a read
+    static inline int baseCode(char base) {
+        unsigned int i = (unsigned char)base - 'A';
+        // A, C, G and T are bits 0, 2, 6 and 19 counting from A
+        if(i >= 20 || ((0x80045 >> i) & 0x01) == 0)
+            return -1;
+        return ((base >> 1) ^ (base >> 2)) & 0x03;
+    }
+    static bool test();
+
+private:
+    vector<vector<uint8> > mBlocks;
+    vector<int> mLength;
+    // the adapters with other bases than ACGT are always compared
+    vector<bool> mAlwaysCompared;
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "adaptertrimmer.h"
+#include "simd.h"
 
 AdapterTrimmer::AdapterTrimmer(){
 }
@@ -34,10 +35,8 @@ bool AdapterTrimmer::trimByOverlapAnalysis(Read* r1, Read* r2, FilterResult* fr,
             r2->reverseComplement()->print();
             cerr <<endl;
         }
-        r1->mSeq.mStr = r1->mSeq.mStr.substr(0, len1);
-        r1->mQuality = r1->mQuality.substr(0, len1);
-        r2->mSeq.mStr = r2->mSeq.mStr.substr(0, len2);
-        r2->mQuality = r2->mQuality.substr(0, len2);
+        r1->crop(0, len1);
+        r2->crop(0, len2);
 
         fr->addAdapterTrimmed(adapter1, adapter2);
         return true;
@@ -45,7 +44,7 @@ bool AdapterTrimmer::trimByOverlapAnalysis(Read* r1, Read* r2, FilterResult* fr,
     return false;
 }
 
-bool AdapterTrimmer::trimByMultiSequences(Read* r, FilterResult* fr, vector<string>& adapterList, bool isR2, bool incTrimmedCounter) {
+bool AdapterTrimmer::trimByMultiSequences(Read* r, FilterResult* fr, vector<string>& adapterList, bool isR2, bool incTrimmedCounter, AdapterIndex* index, ReadSeeds* seeds) {
     int matchReq = 4;
     if(adapterList.size() > 16)
         matchReq = 5;
@@ -53,8 +52,26 @@ bool AdapterTrimmer::trimByMultiSequences(Read* r, FilterResult* fr, vector<stri
         matchReq = 6;
     bool trimmed = false;
 
-    string originalSeq = r->mSeq.mStr;
+    // the read is only indexed once, and it's still valid after the read is cropped by an adapter
+    // the seeds of the thread are reused if given, so nothing is allocated for a read
+    ReadSeeds localSeeds;
+    if(index == NULL) {
+        seeds = NULL;
+    } else {
+        if(seeds == NULL)
+            seeds = &localSeeds;
+        seeds->reset(r->mSeq.mStr.c_str(), r->length());
+    }
+    // the original sequence is only copied if an adapter is compared
+    string originalSeq;
+    bool copied = false;
     for(int i=0; i<adapterList.size(); i++) {
+        if(seeds && !index->mayMatch(i, *seeds, r->length(), matchReq))
+            continue;
+        if(!copied) {
+            originalSeq = r->mSeq.mStr;
+            copied = true;
+        }
         trimmed |= trimBySequence(r, NULL, adapterList[i], isR2, matchReq);
     }
 
@@ -70,8 +87,6 @@ bool AdapterTrimmer::trimByMultiSequences(Read* r, FilterResult* fr, vector<stri
 }
 
 bool AdapterTrimmer::trimBySequence(Read* r, FilterResult* fr, string& adapterseq, bool isR2, int matchReq) {
-    const int allowOneMismatchForEach = 8;
-
     int rlen = r->length();
     int alen = adapterseq.length();
 
@@ -81,50 +96,24 @@ bool AdapterTrimmer::trimBySequence(Read* r, FilterResult* fr, string& adapterse
     if(alen < matchReq)
         return false;
 
-    int pos=0;
-    bool found = false;
-    int start = 0;
-    if(alen >= 16)
-        start = -4;
-    else if(alen >= 12)
-        start = -3;
-    else if(alen >= 8)
-        start = -2;
     // we start from negative numbers since the Illumina adapter dimer usually have the first A skipped as A-tailing
-    for(pos = start; pos<rlen-matchReq; pos++) {
-        int cmplen = min(rlen - pos, alen);
-        int allowedMismatch = cmplen/allowOneMismatchForEach;
-        int mismatch = 0;
-        bool matched = true;
-        for(int i=max(0, -pos); i<cmplen; i++) {
-            if( adata[i] != rdata[i+pos] ){
-                mismatch++;
-                if(mismatch > allowedMismatch) {
-                    matched = false;
-                    break;
-                }
-            }
-        }
-        if(matched) {
-            found = true;
-            break;
-        }
-
-    }
+    // one mismatch is allowed for each 8 bases, and each alignment is compared by SIMD if supported
+    int start = AdapterIndex::alignmentStart(alen);
+    int end = rlen - matchReq;
+    int pos = Simd::findAdapter(rdata, rlen, adata, alen, start, end);
+    bool found = pos < end;
 
     if(found) {
         if(pos < 0) {
             string adapter = adapterseq.substr(0, alen+pos);
-            r->mSeq.mStr.resize(0);
-            r->mQuality.resize(0);
+            r->resize(0);
             if(fr) {
                 fr->addAdapterTrimmed(adapter, isR2);
             }
 
         } else {
             string adapter = r->mSeq.mStr.substr(pos, rlen-pos);
-            r->mSeq.mStr = r->mSeq.mStr.substr(0, pos);
-            r->mQuality = r->mQuality.substr(0, pos);
+            r->crop(0, pos);
             if(fr) {
                 fr->addAdapterTrimmed(adapter, isR2);
             }
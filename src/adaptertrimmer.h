@@ -7,6 +7,7 @@
 #include "overlapanalysis.h"
 #include "filterresult.h"
 #include "options.h"
+#include "adapterindex.h"
 
 using namespace std;
 
@@ -18,7 +19,8 @@ public:
     static bool trimByOverlapAnalysis(Read* r1, Read* r2, FilterResult* fr, int diffLimit, int overlapRequire, double diffPercentLimit);
     static bool trimByOverlapAnalysis(Read* r1, Read* r2, FilterResult* fr, OverlapResult ov, int frontTrimmed1 = 0, int frontTrimmed2 = 0);
     static bool trimBySequence(Read* r1, FilterResult* fr, string& adapter, bool isR2 = false, int matchReq = 4);
-    static bool trimByMultiSequences(Read* r1, FilterResult* fr, vector<string>& adapterList, bool isR2 = false, bool incTrimmedCounter = true);
+    // the adapters that can't match the read are skipped by the index if it's given, the index should be made of adapterList
+    static bool trimByMultiSequences(Read* r1, FilterResult* fr, vector<string>& adapterList, bool isR2 = false, bool incTrimmedCounter = true, AdapterIndex* index = NULL, ReadSeeds* seeds = NULL);
     static bool test();
 
 
@@ -17,10 +17,16 @@ int BaseCorrector::correctByOverlapAnalysis(Read* r1, Read* r2, FilterResult* fr
     // we only correct overlap
     if(ov.diff == 0 || !ov.overlapped)
         return 0;
+    // the bases of a gapped overlap are only paired if the indel is at one position
+    if(ov.gap_pos == -2)
+        return 0;
 
     int ol = ov.overlap_len;
     int start1 = max(0, ov.offset);
     int start2 = r2->length() -  max(0, -ov.offset) - 1;
+    // the bases of read2 inserted (> 0) or deleted (< 0) after the first gapPos bases of the overlap
+    int delta = ov.overlap_len2 - ov.overlap_len;
+    int gapPos = ov.gap_pos < 0 ? ol : ov.gap_pos;
 
     const char* seq1 = r1->mSeq.mStr.c_str();
     const char* seq2 = r2->mSeq.mStr.c_str();
@@ -35,14 +41,16 @@ int BaseCorrector::correctByOverlapAnalysis(Read* r1, Read* r2, FilterResult* fr
     bool r1Corrected = false;
     bool r2Corrected = false;
     for(int i=0; i<ol; i++) {
+        // the bases of read1 deleted from read2 have no pair
+        if(i >= gapPos && i < gapPos - delta)
+            continue;
         int p1 = start1 + i;
-        int p2 = start2 - i;
+        int p2 = start2 - (i < gapPos ? i : i + delta);
 
         if(seq1[p1] != complement(seq2[p2])) {
             if(qual1[p1] >= GOOD_QUAL && qual2[p2] <= BAD_QUAL) {
                 // use R1
-                r2->mSeq.mStr[p2] = complement(seq1[p1]);
-                r2->mQuality[p2] = qual1[p1];
+                r2->setBase(p2, complement(seq1[p1]), qual1[p1]);
                 corrected++;
                 r2Corrected = true;
                 if(fr) {
@@ -50,8 +58,7 @@ int BaseCorrector::correctByOverlapAnalysis(Read* r1, Read* r2, FilterResult* fr
                 }
             } else if(qual2[p2] >= GOOD_QUAL && qual1[p1] <= BAD_QUAL) {
                 // use R2
-                r1->mSeq.mStr[p1] = complement(seq2[p2]);
-                r1->mQuality[p1] = qual2[p2];
+                r1->setBase(p1, complement(seq2[p2]), qual2[p2]);
                 corrected++;
                 r1Corrected = true;
                 if(fr) {
@@ -63,8 +70,8 @@ int BaseCorrector::correctByOverlapAnalysis(Read* r1, Read* r2, FilterResult* fr
         }
     }
 
-    // should never happen
-    if(uncorrected + corrected != ov.diff) {
+    // should never happen, the indel bases are also differences
+    if(uncorrected + corrected + abs(delta) != ov.diff) {
         static bool warned = false;
         if(!warned){
             cerr << "WARNING: the algorithm is wrong! uncorrected + corrected != ov.diff" << endl;
@@ -103,5 +110,27 @@ bool BaseCorrector::test() {
     if(r2.mQuality != "EEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEE")
         return false;
 
+    // read2 has 2 more bases of the G homopolymer, and the low quality mismatches on each side of it
+    string fragment = "GATTACAGGCTTACCGATCGGTACCATGCAAGTCCGTAGCTAGGGGGTTCAGTCAACGTTGCAAGCTTGACCTAGGATCCGTATCGACGTCAGTCTAGCATCGAGG";
+    string tail = fragment.substr(20);
+    tail.insert(tail.find("GGGGG"), "GG");
+    tail[10] = 'T';
+    tail[60] = 'T';
+    Read g1("@name", fragment.substr(0, 80), "+", string(80, 'E'));
+    Read g2("@name", "", "+", "");
+    g2.mSeq = Sequence(tail).reverseComplement();
+    g2.mQuality = string(tail.length(), 'E');
+    g2.mQuality[tail.length() - 1 - 10] = '/';
+    g2.mQuality[tail.length() - 1 - 60] = '/';
+    Sequence rcg2 = ~g2.mSeq;
+    OverlapGapBuffer buffer;
+    OverlapResult ov = OverlapAnalysis::analyzeGapped(g1.mSeq.mStr.c_str(), g1.length(), rcg2.mStr.c_str(), rcg2.length(), 5, 30, 0.2, &buffer);
+    if(!ov.overlapped || ov.diff != 4 || ov.gap_pos < 0 || correctByOverlapAnalysis(&g1, &g2, NULL, ov) != 2)
+        return false;
+    string corrected = fragment.substr(20);
+    corrected.insert(corrected.find("GGGGG"), "GG");
+    if(g2.mSeq.reverseComplement().mStr != corrected || g1.mSeq.mStr != fragment.substr(0, 80))
+        return false;
+
     return true;
 }
\ No newline at end of file
@@ -0,0 +1,43 @@
+#include "bufferpool.h"
+
+BufferPool::BufferPool(size_t reserve, int limit){
+    mReserve = reserve;
+    mLimit = limit;
+}
+
+BufferPool::~BufferPool() {
+    for(int i=0; i<mBuffers.size(); i++) {
+        delete mBuffers[i];
+    }
+    mBuffers.clear();
+}
+
+string* BufferPool::get() {
+    string* data = NULL;
+    mMtx.lock();
+    if(!mBuffers.empty()) {
+        data = mBuffers.back();
+        mBuffers.pop_back();
+    }
+    mMtx.unlock();
+
+    if(data == NULL) {
+        data = new string();
+        data->reserve(mReserve);
+    }
+    return data;
+}
+
+void BufferPool::recycle(string* data) {
+    data->clear();
+    mMtx.lock();
+    if(mBuffers.size() < mLimit) {
+        mBuffers.push_back(data);
+        data = NULL;
+    }
+    mMtx.unlock();
+
+    // the pool is full
+    if(data != NULL)
+        delete data;
+}
@@ -0,0 +1,31 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <mutex>
+
+using namespace std;
+
+// a thread-safe pool of output buffers
+// the written buffers are kept here to be reused, so their memory is not allocated again
+class BufferPool{
+public:
+    BufferPool(size_t reserve, int limit);
+    ~BufferPool();
+
+    // get an empty buffer, which is recycled from the written ones if possible
+    string* get();
+    // give back a buffer, it will be deleted if the pool is full
+    void recycle(string* data);
+
+private:
+    vector<string*> mBuffers;
+    size_t mReserve;
+    int mLimit;
+    mutex mMtx;
+};
+
+#endif
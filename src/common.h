@@ -36,6 +36,15 @@ static const int PACK_SIZE = 1000;
 // if the number of in memory packs is full, the producer thread should sleep
 static const int PACK_IN_MEM_LIMIT = 500;
 
+// the written output buffers are recycled by each writer thread
+// this number limit the number of idle buffers kept by one writer
+static const int OUTPUT_BUFFER_POOL_LIMIT = 64;
+
+// the pipe buffer size requested when writing to STDOUT
+static const int STDOUT_PIPE_SIZE = 1024*1024;
+// the maximum number of buffers coalesced to one writev call
+static const int WRITER_IOV_LIMIT = 64;
+
 // if read number is more than this, warn it
 static const int WARN_STANDALONE_READ_LIMIT = 10000;
 
@@ -50,6 +59,7 @@ static const int FAIL_LENGTH = 16;
 static const int FAIL_TOO_LONG = 17;
 static const int FAIL_QUALITY = 20;
 static const int FAIL_COMPLEXITY = 24;
+static const int FAIL_DUPLICATE = 28;
 
 // how many types in total we support
 static const int FILTER_RESULT_TYPES = 32;
@@ -62,7 +72,7 @@ const static char* FAILED_TYPES[FILTER_RESULT_TYPES] = {
 	"failed_too_short", "failed_too_long", "", "",
 	"failed_quality_filter", "", "", "",
 	"failed_low_complexity", "", "", "",
-	"", "", "", ""
+	"failed_duplicated", "", "", ""
 };
 
 
@@ -0,0 +1,149 @@
+#include "dedupset.h"
+#include "util.h"
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+DedupSet::DedupSet(long memoryMB){
+    // the slot number is the largest power of 2 that fits in the budget, a slot takes 16 bytes
+    long slots = 1;
+    while(slots * 2 * 16 <= memoryMB * 1024 * 1024)
+        slots *= 2;
+    mMask = slots - 1;
+    mMaxSize = slots * DEDUP_MAX_LOAD;
+    mSlots = (uint64*)calloc(slots * 2, sizeof(uint64));
+    if(mSlots == NULL)
+        error_exit("failed to allocate " + to_string(memoryMB) + " MB memory for deduplication, please use a smaller --dedup_memory");
+    mSize = 0;
+    mFull = false;
+}
+
+DedupSet::~DedupSet() {
+    free(mSlots);
+}
+
+static inline uint64 rotl(uint64 x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// the finalizer of MurmurHash3
+static inline uint64 fmix(uint64 k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+static void hashBytes(const char* data, int len, uint64& a, uint64& b) {
+    // two lanes with different multipliers, 8 bytes a time
+    int i = 0;
+    for(; i + 8 <= len; i += 8) {
+        uint64 w;
+        memcpy(&w, data + i, 8);
+        a = rotl((a ^ w) * 0x9e3779b97f4a7c15ULL, 31);
+        b = rotl((b ^ w) * 0xc2b2ae3d27d4eb4fULL, 29);
+    }
+    uint64 w = 0;
+    memcpy(&w, data + i, len - i);
+    a = rotl((a ^ w ^ len) * 0x9e3779b97f4a7c15ULL, 31);
+    b = rotl((b ^ w ^ len) * 0xc2b2ae3d27d4eb4fULL, 29);
+}
+
+void DedupSet::fingerprint(const char* data1, int len1, const char* data2, int len2, uint64& high, uint64& low) {
+    uint64 a = 0x243f6a8885a308d3ULL;
+    uint64 b = 0x13198a2e03707344ULL;
+    // the length of each read is mixed, so a pair is not the same as its concatenation
+    hashBytes(data1, len1, a, b);
+    if(data2)
+        hashBytes(data2, len2, a, b);
+    high = fmix(a + b);
+    low = fmix(b ^ rotl(a, 17));
+    if(high == 0)
+        high = 1;
+    if(low == 0)
+        low = 1;
+}
+
+bool DedupSet::add(const char* data1, int len1, const char* data2, int len2) {
+    uint64 high, low;
+    fingerprint(data1, len1, data2, len2, high, low);
+    return addFingerprint(high, low);
+}
+
+bool DedupSet::addFingerprint(uint64 high, uint64 low) {
+    uint64 pos = high & mMask;
+    while(true) {
+        uint64* slot = mSlots + pos * 2;
+        uint64 claimed = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+        if(claimed == 0) {
+            // the read is kept but not added if the set is full
+            if(mSize >= mMaxSize) {
+                bool wasFull = mFull.exchange(true);
+                if(!wasFull)
+                    cerr << "WARNING: the deduplication set is full, the reads after now are not deduplicated. Please increase --dedup_memory." << endl;
+                return true;
+            }
+            if(__atomic_compare_exchange_n(slot, &claimed, high, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                __atomic_store_n(slot + 1, low, __ATOMIC_RELEASE);
+                mSize++;
+                return true;
+            }
+            // another thread claimed it first, and claimed is its high word now
+        }
+        if(claimed == high) {
+            // wait for the claiming thread to publish the low word
+            uint64 published;
+            while((published = __atomic_load_n(slot + 1, __ATOMIC_ACQUIRE)) == 0)
+                this_thread::yield();
+            if(published == low)
+                return false;
+        }
+        pos = (pos + 1) & mMask;
+    }
+}
+
+bool DedupSet::test() {
+    DedupSet set(1);
+    if(!set.add("ACGTACGT", 8) || set.add("ACGTACGT", 8) || !set.add("ACGTACGA", 8))
+        return false;
+    // the pairs are different from each other and from the SE reads of their concatenations
+    if(!set.add("ACGT", 4, "ACGT", 4) || !set.add("ACG", 3, "TACGT", 5) || set.add("ACGT", 4, "ACGT", 4))
+        return false;
+    if(set.size() != 4)
+        return false;
+
+    // the threads add a same list of reads, and each read is new for only one thread
+    DedupSet shared(1);
+    vector<string> reads;
+    for(int i=0; i<10000; i++)
+        reads.push_back("READ" + to_string(i * 7919));
+    atomic_long added(0);
+    vector<thread*> threads;
+    for(int t=0; t<4; t++) {
+        threads.push_back(new thread([&shared, &reads, &added]() {
+            for(int i=0; i<reads.size(); i++) {
+                if(shared.add(reads[i].c_str(), reads[i].length()))
+                    added++;
+            }
+        }));
+    }
+    for(int t=0; t<threads.size(); t++) {
+        threads[t]->join();
+        delete threads[t];
+    }
+    if(added != 10000 || shared.size() != 10000 || shared.isFull())
+        return false;
+
+    // 1MB has 65536 slots, and 49152 of them can be used
+    for(int i=10000; i<60000; i++) {
+        string read = "READ" + to_string(i * 7919);
+        shared.add(read.c_str(), read.length());
+    }
+    if(!shared.isFull() || shared.size() != 49152)
+        return false;
+    // the ones in the set are still found, and the new ones are kept
+    return !shared.add(reads[0].c_str(), reads[0].length()) && shared.add("NEW", 3);
+}
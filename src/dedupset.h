@@ -0,0 +1,43 @@
+#ifndef DEDUP_SET_H
+#define DEDUP_SET_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include "common.h"
+
+using namespace std;
+
+// a slot is not used if the set is loaded to this ratio, so the probing is always short
+#define DEDUP_MAX_LOAD 0.75
+
+// the set of 128-bit fingerprints of the reads (pairs) seen, for deduplication
+// it's an open addressing hash table shared by all the worker threads without locking:
+// a slot is claimed by CAS on its high word, and then its low word is published
+// the memory is bounded, and the set stops adding fingerprints when it's full
+class DedupSet{
+public:
+    DedupSet(long memoryMB);
+    ~DedupSet();
+
+    // true if the read (pair) is seen for the first time, data2 is NULL for SE data
+    bool add(const char* data1, int len1, const char* data2 = NULL, int len2 = 0);
+    bool isFull() {return mFull;}
+    long size() {return mSize;}
+
+    static void fingerprint(const char* data1, int len1, const char* data2, int len2, uint64& high, uint64& low);
+    static bool test();
+
+private:
+    bool addFingerprint(uint64 high, uint64 low);
+
+private:
+    // two words per slot, 0 means empty, so the fingerprints never have 0 words
+    uint64* mSlots;
+    uint64 mMask;
+    long mMaxSize;
+    atomic_long mSize;
+    atomic_bool mFull;
+};
+
+#endif
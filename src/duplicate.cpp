@@ -9,8 +9,8 @@ Duplicate::Duplicate(Options* opt) {
     mKeyLenInBit = 1<<(2*mKeyLenInBase);
     mDups = new uint64[mKeyLenInBit];
     memset(mDups, 0, sizeof(uint64)*mKeyLenInBit);
-    mCounts = new uint16[mKeyLenInBit];
-    memset(mCounts, 0, sizeof(uint16)*mKeyLenInBit);
+    mCounts = new uint32[mKeyLenInBit];
+    memset(mCounts, 0, sizeof(uint32)*mKeyLenInBit);
     mGC = new uint8[mKeyLenInBit];
     memset(mGC, 0, sizeof(uint8)*mKeyLenInBit);
 }
@@ -18,6 +18,7 @@ Duplicate::Duplicate(Options* opt) {
 Duplicate::~Duplicate(){
     delete[] mDups;
     delete[] mCounts;
+    delete[] mGC;
 }
 
 uint64 Duplicate::seq2int(const char* data, int start, int keylen, bool& valid) {
@@ -47,30 +48,49 @@ uint64 Duplicate::seq2int(const char* data, int start, int keylen, bool& valid)
     return ret;
 }
 
-void Duplicate::addRecord(uint32 key, uint64 kmer32, uint8 gc) {
-    if(mCounts[key] == 0) {
-        mCounts[key] = 1;
+uint8 Duplicate::gcRatio(const char* data1, int len1, const char* data2, int len2) {
+    int gc = 0;
+    for(int i=0; i<len1; i++) {
+        if(data1[i] == 'G' || data1[i] == 'C')
+            gc++;
+    }
+    for(int i=0; i<len2; i++) {
+        if(data2[i] == 'G' || data2[i] == 'C')
+            gc++;
+    }
+    return (uint8)round(255.0 * (double) gc / (double)(len1 + len2));
+}
+
+void Duplicate::addRecord(uint32 key, uint64 kmer32, const char* data1, int len1, const char* data2, int len2) {
+    unique_lock<mutex> guard(mLocks[key % DUP_LOCK_STRIPES]);
+    // the GC ratio is only needed if the record replaces or matches the slot
+    if(mCounts[key] > 0 && mDups[key] < kmer32)
+        return;
+    // the bases are scanned without holding the stripe, so the slot is checked again after locking
+    guard.unlock();
+    uint8 gc = gcRatio(data1, len1, data2, len2);
+    guard.lock();
+    if(mCounts[key] == 0 || mDups[key] > kmer32) {
         mDups[key] = kmer32;
+        mCounts[key] = 1;
         mGC[key] = gc;
-    } else {
-        if(mDups[key] == kmer32)
-            mCounts[key]++;
-        else if(mDups[key] > kmer32) {
-            mDups[key] = kmer32;
-            mCounts[key] = 1;
-            mGC[key] = gc;
-        }
+    } else if(mDups[key] == kmer32) {
+        mCounts[key]++;
+        mGC[key] = min(mGC[key], gc);
     }
 }
 
 void Duplicate::statRead(Read* r) {
-    if(r->length() < 32)
+    statRead(r->mSeq.mStr.c_str(), r->length());
+}
+
+void Duplicate::statRead(const char* data, int len) {
+    if(len < 32)
         return;
 
     int start1 = 0;
-    int start2 = max(0, r->length() - 32 - 5);
+    int start2 = max(0, len - 32 - 5);
 
-    const char* data = r->mSeq.mStr.c_str();
     bool valid = true;
 
     uint64 ret = seq2int(data, start1, mKeyLenInBase, valid);
@@ -82,27 +102,17 @@ void Duplicate::statRead(Read* r) {
     if(!valid)
         return;
 
-    int gc = 0;
-
-    // not calculated
-    if(mCounts[key] == 0) {
-        for(int i=0; i<r->length(); i++) {
-            if(data[i] == 'C' || data[i] == 'T')
-                gc++;
-        }
-    }
-
-    gc = round(255.0 * (double) gc / (double) r->length());
-
-    addRecord(key, kmer32, (uint8)gc);
+    addRecord(key, kmer32, data, len);
 }
 
 void Duplicate::statPair(Read* r1, Read* r2) {
-    if(r1->length() < 32 || r2->length() < 32)
+    statPair(r1->mSeq.mStr.c_str(), r1->length(), r2->mSeq.mStr.c_str(), r2->length());
+}
+
+void Duplicate::statPair(const char* data1, int len1, const char* data2, int len2) {
+    if(len1 < 32 || len2 < 32)
         return;
 
-    const char* data1 = r1->mSeq.mStr.c_str();
-    const char* data2 = r2->mSeq.mStr.c_str();
     bool valid = true;
 
     uint64 ret = seq2int(data1, 0, mKeyLenInBase, valid);
@@ -114,23 +124,7 @@ void Duplicate::statPair(Read* r1, Read* r2) {
     if(!valid)
         return;
 
-    int gc = 0;
-
-    // not calculated
-    if(mCounts[key] == 0) {
-        for(int i=0; i<r1->length(); i++) {
-            if(data1[i] == 'G' || data1[i] == 'C')
-                gc++;
-        }
-        for(int i=0; i<r2->length(); i++) {
-            if(data2[i] == 'G' || data2[i] == 'C')
-                gc++;
-        }
-    }
-
-    gc = round(255.0 * (double) gc / (double)( r1->length() + r2->length()));
-
-    addRecord(key, kmer32, gc);
+    addRecord(key, kmer32, data1, len1, data2, len2);
 }
 
 double Duplicate::statAll(int* hist, double* meanGC, int histSize) {
@@ -139,7 +133,7 @@ double Duplicate::statAll(int* hist, double* meanGC, int histSize) {
     int* gcStatNum = new int[histSize];
     memset(gcStatNum, 0, sizeof(int)*histSize);
     for(int key=0; key<mKeyLenInBit; key++) {
-        int count = mCounts[key];
+        long count = mCounts[key];
         double gc = mGC[key];
 
         if(count > 0) {
@@ -171,4 +165,47 @@ double Duplicate::statAll(int* hist, double* meanGC, int histSize) {
         return 0.0;
     else
         return (double)dupNum / (double)totalNum;
-}
\ No newline at end of file
+}
+bool Duplicate::test() {
+    Options opt;
+    opt.duplicate.keylen = 4;
+    // the kmer32 of a SE read starts at 3 here, and the GC ratio is of the whole read
+    string seqs[5] = {
+        "ACGTACGTACGTACGTACGTACGTACGTACGTACGTACGT",
+        "ACGTTTTTTTTTTTTTTTTTTTTTACGTACGTACGTACGT",
+        "ACGTAAAAACGTACGTACGTACGTACGTACGTACGTACGT",
+        "CCCCGGGGACGTACGTACGTACGTACGTACGTACGTACGT",
+        "ACGTAAAAACGTACGTACGTACGTACGTACGTACGTCCCC"
+    };
+    // the records are added in two orders, and the results should be the same
+    int order[2][8] = {{0, 1, 2, 3, 0, 1, 4, 2}, {2, 0, 1, 4, 3, 2, 1, 0}};
+    int hist[2][4];
+    double meanGC[2][4];
+    double rate[2];
+    for(int o=0; o<2; o++) {
+        Duplicate dup(&opt);
+        for(int i=0; i<8; i++)
+            dup.statRead(seqs[order[o][i]].c_str(), seqs[order[o][i]].length());
+        memset(hist[o], 0, sizeof(int) * 4);
+        memset(meanGC[o], 0, sizeof(double) * 4);
+        rate[o] = dup.statAll(hist[o], meanGC[o], 4);
+    }
+    for(int i=0; i<4; i++) {
+        if(hist[0][i] != hist[1][i] || meanGC[0][i] != meanGC[1][i])
+            return false;
+    }
+    // the key ACGT keeps the smallest kmer32 of the 3rd and 5th reads, which has 3 copies
+    // and the GC ratio of them is the one of the 3rd read
+    if(rate[0] != rate[1] || rate[0] != 0.5 || hist[0][1] != 1 || hist[0][3] != 1)
+        return false;
+    if(meanGC[0][3] != round(255.0 * 18 / 40) / 255.0)
+        return false;
+
+    // the counts don't wrap at 65536
+    Duplicate dup(&opt);
+    for(int i=0; i<70000; i++)
+        dup.statRead(seqs[0].c_str(), seqs[0].length());
+    memset(hist[0], 0, sizeof(int) * 4);
+    rate[0] = dup.statAll(hist[0], meanGC[0], 4);
+    return hist[0][3] == 1 && rate[0] == 69999.0 / 70000.0;
+}
@@ -4,12 +4,19 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
+#include <mutex>
 #include "read.h"
 #include "options.h"
 #include "common.h"
 
 using namespace std;
 
+// the keys are locked by stripes, so the threads rarely wait for each other
+#define DUP_LOCK_STRIPES 1024
+
+// the key of a record is its first bases, and each key keeps the smallest kmer32 (of the tail) seen with its count
+// a slot is only changed under the lock of its stripe, and the result doesn't depend on the order of the records,
+// so the duplication rate is the same for any thread number
 class Duplicate{
 public:
     Duplicate(Options* opt);
@@ -17,20 +24,30 @@ public:
 
     void statRead(Read* r1);
     void statPair(Read* r1, Read* r2);
+    // the same as above, for the records not parsed to Read
+    void statRead(const char* data, int len);
+    void statPair(const char* data1, int len1, const char* data2, int len2);
     uint64 seq2int(const char* data, int start, int keylen, bool& valid);
-    void addRecord(uint32 key, uint64 kmer32, uint8 gc);
+    // data2 is NULL for SE data, the GC ratio is only counted if the slot needs it
+    void addRecord(uint32 key, uint64 kmer32, const char* data1, int len1, const char* data2 = NULL, int len2 = 0);
 
     // make histogram and get duplication rate
     double statAll(int* hist, double* meanGC, int histSize);
 
+    // the GC ratio of the read (pair) scaled to 0~255
+    static uint8 gcRatio(const char* data1, int len1, const char* data2, int len2);
+
+    static bool test();
+
 private:
     Options* mOptions;
     int mKeyLenInBase;
     int mKeyLenInBit;
     uint64* mDups;
-    uint16* mCounts;
+    uint32* mCounts;
+    // the min GC ratio of the records with the kmer32 in mDups
     uint8* mGC;
-    
+    mutex mLocks[DUP_LOCK_STRIPES];
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,174 @@
+#include "dupsketch.h"
+#include "duplicate.h"
+#include "dedupset.h"
+#include <memory.h>
+#include <math.h>
+#include <algorithm>
+
+DupSketch::DupSketch(int size) {
+    mSize = size;
+    mThreshold = 0xFFFFFFFFFFFFFFFFULL;
+    mTotal = 0;
+}
+
+void DupSketch::statRead(Read* r) {
+    statRead(r->mSeq.mStr.c_str(), r->length());
+}
+
+void DupSketch::statRead(const char* data, int len) {
+    if(len == 0)
+        return;
+    uint64 high, low;
+    DedupSet::fingerprint(data, len, NULL, 0, high, low);
+    add(high, data, len, NULL, 0);
+}
+
+void DupSketch::statPair(Read* r1, Read* r2) {
+    statPair(r1->mSeq.mStr.c_str(), r1->length(), r2->mSeq.mStr.c_str(), r2->length());
+}
+
+void DupSketch::statPair(const char* data1, int len1, const char* data2, int len2) {
+    if(len1 + len2 == 0)
+        return;
+    uint64 high, low;
+    DedupSet::fingerprint(data1, len1, data2, len2, high, low);
+    add(high, data1, len1, data2, len2);
+}
+
+void DupSketch::add(uint64 hash, const char* data1, int len1, const char* data2, int len2) {
+    mTotal++;
+    if(hash > mThreshold)
+        return;
+    DupSketchEntry e;
+    e.hash = hash;
+    e.count = 1;
+    e.gc = Duplicate::gcRatio(data1, len1, data2, len2);
+    mEntries.push_back(e);
+    if(mEntries.size() >= 2 * mSize)
+        compact();
+}
+
+static bool entryLess(const DupSketchEntry& a, const DupSketchEntry& b) {
+    return a.hash < b.hash;
+}
+
+void DupSketch::compact() {
+    sort(mEntries.begin(), mEntries.end(), entryLess);
+    int n = 0;
+    for(int i=0; i<mEntries.size(); i++) {
+        if(n > 0 && mEntries[n-1].hash == mEntries[i].hash)
+            mEntries[n-1].count += mEntries[i].count;
+        else
+            mEntries[n++] = mEntries[i];
+    }
+    if(n >= mSize) {
+        n = mSize;
+        mThreshold = mEntries[n-1].hash;
+    }
+    mEntries.resize(n);
+}
+
+DupSketch* DupSketch::merge(vector<DupSketch*>& list) {
+    if(list.size() == 0)
+        return NULL;
+    DupSketch* sketch = new DupSketch(list[0]->mSize);
+    for(int i=0; i<list.size(); i++) {
+        sketch->mEntries.insert(sketch->mEntries.end(), list[i]->mEntries.begin(), list[i]->mEntries.end());
+        sketch->mTotal += list[i]->mTotal;
+    }
+    sketch->compact();
+    return sketch;
+}
+
+double DupSketch::statAll(int* hist, double* meanGC, int histSize) {
+    compact();
+    if(mEntries.size() == 0)
+        return 0.0;
+
+    // the sketch is exact if it's not full, otherwise the distinct number is estimated by the k-th smallest fingerprint
+    double distinct = mEntries.size();
+    if(mEntries.size() == mSize)
+        distinct = min((double)mTotal, (mSize - 1) / ((double)mThreshold / 18446744073709551616.0));
+
+    long* sampleNum = new long[histSize];
+    memset(sampleNum, 0, sizeof(long)*histSize);
+    double* gcSum = new double[histSize];
+    memset(gcSum, 0, sizeof(double)*histSize);
+    for(int i=0; i<mEntries.size(); i++) {
+        int bin = min((long)mEntries[i].count, (long)histSize - 1);
+        sampleNum[bin]++;
+        gcSum[bin] += mEntries[i].gc;
+    }
+
+    // the sampled histogram is scaled to the estimated distinct number
+    double scale = distinct / mEntries.size();
+    for(int i=0; i<histSize; i++) {
+        if(sampleNum[i] > 0) {
+            hist[i] += (int)round(sampleNum[i] * scale);
+            meanGC[i] = gcSum[i] / 255.0 / sampleNum[i];
+        }
+    }
+
+    delete[] sampleNum;
+    delete[] gcSum;
+
+    return 1.0 - distinct / (double)mTotal;
+}
+
+bool DupSketch::test() {
+    // the 20 reads of 40 bp, the i-th read is repeated (i % 4 + 1) times
+    vector<string> reads;
+    for(int i=0; i<20; i++) {
+        string read = "ACGTACGTACGTACGTACGTACGTACGTACGTACGTACGT";
+        read[i] = 'N';
+        for(int c=0; c<i % 4 + 1; c++)
+            reads.push_back(read);
+    }
+    // the sketch is exact if it has room for all the distinct reads
+    DupSketch exact(64);
+    for(int i=0; i<reads.size(); i++)
+        exact.statRead(reads[i].c_str(), reads[i].length());
+    int hist[8];
+    double meanGC[8];
+    memset(hist, 0, sizeof(int) * 8);
+    memset(meanGC, 0, sizeof(double) * 8);
+    double rate = exact.statAll(hist, meanGC, 8);
+    if(exact.totalRecords() != 50 || fabs(rate - 30.0 / 50.0) > 1e-9)
+        return false;
+    if(hist[1] != 5 || hist[2] != 5 || hist[3] != 5 || hist[4] != 5 || hist[5] != 0)
+        return false;
+    // the reads repeated once have an A replaced by N
+    if(fabs(meanGC[1] - round(255.0 * 20 / 40) / 255.0) > 1e-9)
+        return false;
+
+    // the merged sketches of the threads are the same as the one of a single thread
+    DupSketch single(256);
+    DupSketch* parts[3] = {new DupSketch(256), new DupSketch(256), new DupSketch(256)};
+    long total = 0;
+    long distinct = 0;
+    for(int i=0; i<20000; i++) {
+        string read = "READ" + to_string(i * 7919);
+        distinct++;
+        for(int c=0; c<i % 4 + 1; c++) {
+            single.statRead(read.c_str(), read.length());
+            parts[(i + c) % 3]->statRead(read.c_str(), read.length());
+            total++;
+        }
+    }
+    vector<DupSketch*> list(parts, parts + 3);
+    DupSketch* merged = DupSketch::merge(list);
+    for(int i=0; i<3; i++)
+        delete parts[i];
+    int mergedHist[8];
+    memset(hist, 0, sizeof(int) * 8);
+    memset(mergedHist, 0, sizeof(int) * 8);
+    rate = single.statAll(hist, meanGC, 8);
+    double mergedRate = merged->statAll(mergedHist, meanGC, 8);
+    delete merged;
+    if(rate != mergedRate || memcmp(hist, mergedHist, sizeof(int) * 8) != 0)
+        return false;
+
+    // the standard error of the distinct number is about 1/sqrt(256)
+    double realRate = 1.0 - (double)distinct / total;
+    return fabs(rate - realRate) < 0.05 && hist[1] > 3000 && hist[1] < 7000;
+}
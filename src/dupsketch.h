@@ -0,0 +1,56 @@
+#ifndef DUP_SKETCH_H
+#define DUP_SKETCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "read.h"
+#include "common.h"
+
+using namespace std;
+
+// the number of the smallest fingerprints kept, a thread takes 2MB at most
+#define DUP_SKETCH_SIZE 65536
+
+struct DupSketchEntry {
+    uint64 hash;
+    uint32 count;
+    // the GC ratio of the read (pair) scaled to 0~255
+    uint8 gc;
+};
+
+// the bottom-k (KMV) sketch of the fingerprints of the whole reads (pairs)
+// the k smallest fingerprints are a uniform sample of the distinct reads, and their counts are exact,
+// so the number of distinct reads is estimated by the k-th smallest one, and the histogram by the sample
+// each thread has its own sketch, and the merged sketch is the same as the one made by a single thread
+class DupSketch{
+public:
+    DupSketch(int size = DUP_SKETCH_SIZE);
+
+    void statRead(Read* r1);
+    void statPair(Read* r1, Read* r2);
+    // the same as above, for the records not parsed to Read
+    void statRead(const char* data, int len);
+    void statPair(const char* data1, int len1, const char* data2, int len2);
+
+    // make histogram and get duplication rate, the same as Duplicate::statAll
+    double statAll(int* hist, double* meanGC, int histSize);
+    long totalRecords() {return mTotal;}
+
+    static DupSketch* merge(vector<DupSketch*>& list);
+    static bool test();
+
+private:
+    void add(uint64 hash, const char* data1, int len1, const char* data2, int len2);
+    // sort the entries, sum the counts of the same fingerprints, and keep the smallest mSize ones
+    void compact();
+
+private:
+    int mSize;
+    // the entries <= mThreshold are collected, and compacted when there are 2 * mSize of them
+    vector<DupSketchEntry> mEntries;
+    uint64 mThreshold;
+    long mTotal;
+};
+
+#endif
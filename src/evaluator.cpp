@@ -62,106 +62,6 @@ int Evaluator::computeSeqLen(string filename) {
     return seqlen;
 }
 
-void Evaluator::computeOverRepSeq(string filename, map<string, long>& hotseqs, int seqlen) {
-    FastqReader reader(filename);
-
-    map<string, long> seqCounts;
-
-    const long BASE_LIMIT = 151 * 10000;
-    long records = 0;
-    long bases = 0;
-    bool reachedEOF = false;
-
-    while(bases < BASE_LIMIT) {
-        Read* r = reader.read();
-        if(!r) {
-            reachedEOF = true;
-            break;
-        }
-        int rlen = r->length();
-        bases += rlen;
-        records ++;
-        // 10, 20, 40, 80, 150
-
-        int steps[5] = {10, 20, 40, 100, min(150,seqlen-2)};
-        
-        for(int s=0; s<5; s++) {
-            int step = steps[s];
-            for(int i=0; i<rlen-step; i++) {
-                string seq = r->mSeq.mStr.substr(i, step);
-                if(seqCounts.count(seq)>0)
-                    seqCounts[seq]++;
-                else
-                    seqCounts[seq]=1;
-            }
-        }
-
-        delete r;
-    }
-    
-    map<string, long>::iterator iter;
-    for(iter = seqCounts.begin(); iter!=seqCounts.end(); iter++) {
-        string seq = iter->first;
-        long count = iter->second;
-
-        if(seq.length() >= seqlen-1) {
-            if(count >= 3) {
-                hotseqs[seq]=count;
-            }
-        } else if(seq.length() >= 100) {
-            if(count >= 5) {
-                hotseqs[seq]=count;
-            }
-        } else if(seq.length() >= 40) {
-            if(count >= 20) {
-                hotseqs[seq]=count;
-            }
-        } else if(seq.length() >= 20) {
-            if(count >= 100) {
-                hotseqs[seq]=count;
-            }
-        } else if(seq.length() >= 10) {
-            if(count >= 500) {
-                hotseqs[seq]=count;
-            }
-        }
-    }
-
-    // remove substrings
-    map<string, long>::iterator iter2;
-    iter = hotseqs.begin(); 
-    while(iter!=hotseqs.end()) {
-        string seq = iter->first;
-        long count = iter->second;
-        bool isSubString = false;
-        for(iter2 = hotseqs.begin(); iter2!=hotseqs.end(); iter2++) {
-            string seq2 = iter2->first;
-            long count2 = iter2->second;
-            if(seq != seq2 && seq2.find(seq) != string::npos && count / count2 < 10) {
-                isSubString = true;
-                break;
-            }
-        }
-        if(isSubString) {
-            hotseqs.erase(iter++);
-        } else {
-            iter++;
-        }
-    }
-
-    // output for test
-    /*for(iter = hotseqs.begin(); iter!=hotseqs.end(); iter++) {
-        cerr << iter->first << ": " << iter->second << endl;
-    }*/
-}
-
-void Evaluator::evaluateOverRepSeqs() {
-    if(!mOptions->in1.empty())
-        computeOverRepSeq(mOptions->in1, mOptions->overRepSeqs1, mOptions->seqLen1);
-    if(!mOptions->in2.empty())
-        computeOverRepSeq(mOptions->in2, mOptions->overRepSeqs2, mOptions->seqLen2);
-}
-
 void Evaluator::evaluateReadNum(long& readNum) {
     FastqReader reader(mOptions->in1);
 
@@ -397,8 +297,8 @@ string Evaluator::evalAdapterAndReadNumDepreciated(long& readNum) {
         finalAdapter.resize(60);
     string matchedAdapter = matchKnownAdapter(finalAdapter);
     if(!matchedAdapter.empty()) {
-        map<string, string> knownAdapters = getKnownAdapter();
-        cerr << knownAdapters[matchedAdapter] << ": " << matchedAdapter << endl;
+        const map<string, string>& knownAdapters = getKnownAdapter();
+        cerr << knownAdapters.at(matchedAdapter) << ": " << matchedAdapter << endl;
         return matchedAdapter;
     } else {
         cerr << finalAdapter << endl;
@@ -616,8 +516,8 @@ string Evaluator::getAdapterWithSeed(int seed, Read** loadedReads, long records,
 
     string matchedAdapter = matchKnownAdapter(adapter);
     if(!matchedAdapter.empty()) {
-        map<string, string> knownAdapters = getKnownAdapter();
-        cerr << knownAdapters[matchedAdapter] << endl << matchedAdapter << endl;
+        const map<string, string>& knownAdapters = getKnownAdapter();
+        cerr << knownAdapters.at(matchedAdapter) << endl << matchedAdapter << endl;
         return matchedAdapter;
     } else {
         if(reachedLeaf) {
@@ -630,11 +530,10 @@ string Evaluator::getAdapterWithSeed(int seed, Read** loadedReads, long records,
 }
 
 string Evaluator::matchKnownAdapter(string seq) {
-    map<string, string> knownAdapters = getKnownAdapter();
-    map<string, string>::iterator iter;
+    const map<string, string>& knownAdapters = getKnownAdapter();
+    map<string, string>::const_iterator iter;
     for(iter = knownAdapters.begin(); iter != knownAdapters.end(); iter++) {
-        string adapter = iter->first;
-        string desc = iter->second;
+        const string& adapter = iter->first;
         if(seq.length()<adapter.length()) {
             continue;
         }
@@ -20,8 +20,6 @@ public:
     string evalAdapterAndReadNum(long& readNum, bool isR2);
     bool isTwoColorSystem();
     void evaluateSeqLen();
-    void evaluateOverRepSeqs();
-    void computeOverRepSeq(string filename, map<string, long>& hotseqs, int seqLen);
     int computeSeqLen(string filename);
 
     static bool test();
@@ -65,6 +65,25 @@ void FastqReader::init(){
 	readToBuf();
 }
 
+int FastqReader::readRaw(char* buf, int size) {
+	// the data already in mBuf is returned first
+	if(mBufUsedLen < mBufDataLen) {
+		int len = min(size, mBufDataLen - mBufUsedLen);
+		memcpy(buf, mBuf + mBufUsedLen, len);
+		mBufUsedLen += len;
+		return len;
+	}
+	int len = 0;
+	if(mZipped) {
+		len = gzread(mZipFile, buf, size);
+		if(len < 0)
+			error_exit("Error to read gzip file: " + mFilename);
+	} else {
+		len = fread(buf, 1, size, mFile);
+	}
+	return len;
+}
+
 void FastqReader::getBytes(size_t& bytesRead, size_t& bytesTotal) {
 	if(mZipped) {
 		bytesRead = gzoffset(mZipFile);
@@ -91,20 +110,24 @@ void FastqReader::clearLineBreaks(char* line) {
 	}
 }
 
+// the offset of the first '\r' or '\n' in data, or len if there is none
+// memchr is much faster than checking byte by byte for the long reads
+static int findLineEnd(const char* data, int len) {
+	if(len <= 0)
+		return 0;
+	const char* lf = (const char*)memchr(data, '\n', len);
+	int end = lf ? lf - data : len;
+	const char* cr = (const char*)memchr(data, '\r', end);
+	return cr ? cr - data : end;
+}
+
 string FastqReader::getLine(){
 	static int c=0;
 	c++;
 	int copied = 0;
 
 	int start = mBufUsedLen;
-	int end = start;
-
-	while(end < mBufDataLen) {
-		if(mBuf[end] != '\r' && mBuf[end] != '\n')
-			end++;
-		else
-			break;
-	}
+	int end = start + findLineEnd(mBuf + start, mBufDataLen - start);
 
 	// this line well contained in this buf, or this is the last buf
 	if(end < mBufDataLen || mBufDataLen < FQ_BUF_SIZE) {
@@ -128,13 +151,7 @@ string FastqReader::getLine(){
 	while(true) {
 		readToBuf();
 		start = 0;
-		end = 0;
-		while(end < mBufDataLen) {
-			if(mBuf[end] != '\r' && mBuf[end] != '\n')
-				end++;
-			else
-				break;
-		}
+		end = findLineEnd(mBuf, mBufDataLen);
 		// this line well contained in this buf, we need to read new buf
 		if(end < mBufDataLen || mBufDataLen < FQ_BUF_SIZE) {
 			int len = end - start;
@@ -24,6 +24,9 @@ public:
 	//this function is not thread-safe
 	//do not call read() of a same FastqReader object from different threads concurrently
 	Read* read();
+	// read the raw data to buf and return the bytes read, 0 means the end of file
+	// it should not be mixed with read() on a same FastqReader object
+	int readRaw(char* buf, int size);
 	bool eof();
 	bool hasNoLineBreakAtEnd();
 
@@ -17,35 +17,15 @@ int Filter::passFilter(Read* r) {
     }
 
     int rlen = r->length();
-    int lowQualNum = 0;
-    int nBaseNum = 0;
-    int totalQual = 0;
-
-    // need to recalculate lowQualNum and nBaseNum if the corresponding filters are enabled
-    if(mOptions->qualfilter.enabled || mOptions->lengthFilter.enabled) {
-        const char* seqstr = r->mSeq.mStr.c_str();
-        const char* qualstr = r->mQuality.c_str();
-
-        for(int i=0; i<rlen; i++) {
-            char base = seqstr[i];
-            char qual = qualstr[i];
-
-            totalQual += qual - 33;
-
-            if(qual < mOptions->qualfilter.qualifiedQual)
-                lowQualNum ++;
-
-            if(base == 'N')
-                nBaseNum++;
-        }
-    }
 
     if(mOptions->qualfilter.enabled) {
-        if(lowQualNum > (mOptions->qualfilter.unqualifiedPercentLimit * rlen / 100.0) )
+        // usually counted by the pre-filtering stats and updated by trimming, so the read is not scanned again
+        ReadProfile& profile = r->profile(mOptions->qualfilter.qualifiedQual);
+        if(profile.lowQual > (mOptions->qualfilter.unqualifiedPercentLimit * rlen / 100.0) )
             return FAIL_QUALITY;
-        else if(mOptions->qualfilter.avgQualReq > 0 && (totalQual / rlen)<mOptions->qualfilter.avgQualReq)
+        else if(mOptions->qualfilter.avgQualReq > 0 && (profile.totalQual / rlen)<mOptions->qualfilter.avgQualReq)
             return FAIL_QUALITY;
-        else if(nBaseNum > mOptions->qualfilter.nBaseLimit )
+        else if(profile.nBase > mOptions->qualfilter.nBaseLimit )
             return FAIL_N_BASE;
     }
 
@@ -65,15 +45,10 @@ int Filter::passFilter(Read* r) {
 }
 
 bool Filter::passLowComplexityFilter(Read* r) {
-    int diff = 0;
     int length = r->length();
     if(length <= 1)
         return false;
-    const char* data = r->mSeq.mStr.c_str();
-    for(int i=0; i<length-1; i++) {
-        if(data[i] != data[i+1])
-            diff++;
-    }
+    int diff = r->profile(mOptions->qualfilter.qualifiedQual).diff;
     if( (double)diff/(double)(length-1) >= mOptions->complexityFilter.threshold )
         return true;
     else
@@ -95,8 +70,7 @@ Read* Filter::trimAndCut(Read* r, int front, int tail, int& frontTrimmed) {
         r->resize(rlen);
         return r;
     } else if(!mOptions->qualityCut.enabledFront && !mOptions->qualityCut.enabledTail && !mOptions->qualityCut.enabledRight){
-        r->mSeq.mStr = r->mSeq.mStr.substr(front, rlen);
-        r->mQuality = r->mQuality.substr(front, rlen);
+        r->crop(front, rlen);
         frontTrimmed  = front;
         return r;
     }
@@ -209,8 +183,7 @@ Read* Filter::trimAndCut(Read* r, int front, int tail, int& frontTrimmed) {
     if(rlen <= 0 || front >= l-1)
         return NULL;
 
-    r->mSeq.mStr = r->mSeq.mStr.substr(front, rlen);
-    r->mQuality = r->mQuality.substr(front, rlen);
+    r->crop(front, rlen);
 
     frontTrimmed = front;
 
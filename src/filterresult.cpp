@@ -178,6 +178,9 @@ void FilterResult::print() {
     if(mOptions->complexityFilter.enabled) {
         cerr <<  "reads failed due to low complexity: " << mFilterReadStats[FAIL_COMPLEXITY] << endl;
     }
+    if(mOptions->dedup.enabled) {
+        cerr <<  "reads failed due to duplication: " << mFilterReadStats[FAIL_DUPLICATE] << endl;
+    }
     if(mOptions->adapter.enabled) {
         cerr <<  "reads with adapter trimmed: " << mTrimmedAdapterRead << endl;
         cerr <<  "bases trimmed due to adapters: " << mTrimmedAdapterBases << endl;
@@ -204,6 +207,8 @@ void FilterResult::reportJson(ofstream& ofs, string padding) {
     ofs << padding << "\t" << "\"too_many_N_reads\": " << mFilterReadStats[FAIL_N_BASE] << "," << endl;
     if(mOptions->complexityFilter.enabled)
         ofs << padding << "\t" << "\"low_complexity_reads\": " << mFilterReadStats[FAIL_COMPLEXITY] << "," << endl;
+    if(mOptions->dedup.enabled)
+        ofs << padding << "\t" << "\"duplicated_reads\": " << mFilterReadStats[FAIL_DUPLICATE] << "," << endl;
     ofs << padding << "\t" << "\"too_short_reads\": " << mFilterReadStats[FAIL_LENGTH] << "," << endl;
     ofs << padding << "\t" << "\"too_long_reads\": " << mFilterReadStats[FAIL_TOO_LONG] << endl;
 
@@ -330,6 +335,8 @@ void FilterResult::reportHtml(ofstream& ofs, long totalReads, long totalBases) {
     }
     if(mOptions->complexityFilter.enabled)
         HtmlReporter::outputRow(ofs, "reads with low complexity:", HtmlReporter::formatNumber(mFilterReadStats[FAIL_COMPLEXITY]) + " (" + to_string(mFilterReadStats[FAIL_COMPLEXITY] * 100.0 / total) + "%)");
+    if(mOptions->dedup.enabled)
+        HtmlReporter::outputRow(ofs, "reads duplicated:", HtmlReporter::formatNumber(mFilterReadStats[FAIL_DUPLICATE]) + " (" + to_string(mFilterReadStats[FAIL_DUPLICATE] * 100.0 / total) + "%)");
     ofs << "</table>\n";
 }
 
@@ -19,7 +19,7 @@ void HtmlReporter::setDupHist(int* dupHist, double* dupMeanGC, double dupRate) {
     mDupRate = dupRate;
 }
 
-void HtmlReporter::setInsertHist(atomic_long* insertHist, int insertSizePeak) {
+void HtmlReporter::setInsertHist(long* insertHist, int insertSizePeak) {
     mInsertHist = insertHist;
     mInsertSizePeak = insertSizePeak;
 }
@@ -130,6 +130,10 @@ void HtmlReporter::printSummary(ofstream& ofs, FilterResult* result, Stats* preS
             dupStr += " (may be overestimated since this is SE data)";
         outputRow(ofs, "duplication rate:", dupStr);
     }
+    if(mOptions->stats.sampling > 1) {
+        string unit = mOptions->stats.byPack ? " packs of " + to_string(PACK_SIZE) + " reads" : " reads";
+        outputRow(ofs, "per-cycle stats sampling:", "1 in " + to_string(mOptions->stats.sampling) + unit + " (the totals are exact)");
+    }
     if(mOptions->isPaired()) {
         outputRow(ofs, "Insert size peak:", mInsertSizePeak);
     }
@@ -18,7 +18,7 @@ public:
     HtmlReporter(Options* opt);
     ~HtmlReporter();
     void setDupHist(int* dupHist, double* dupMeanGC, double dupRate);
-    void setInsertHist(atomic_long* insertHist, int insertSizePeak);
+    void setInsertHist(long* insertHist, int insertSizePeak);
     void report(FilterResult* result, Stats* preStats1, Stats* postStats1, Stats* preStats2 = NULL, Stats* postStats2 = NULL);
 
     static void outputRow(ofstream& ofs, string key, long value);
@@ -40,7 +40,7 @@ private:
     int* mDupHist;
     double* mDupMeanGC;
     double mDupRate;
-    atomic_long* mInsertHist;
+    long* mInsertHist;
     int mInsertSizePeak;
 };
 
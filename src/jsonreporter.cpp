@@ -15,7 +15,7 @@ void JsonReporter::setDupHist(int* dupHist, double* dupMeanGC, double dupRate) {
     mDupRate = dupRate;
 }
 
-void JsonReporter::setInsertHist(atomic_long* insertHist, int insertSizePeak) {
+void JsonReporter::setInsertHist(long* insertHist, int insertSizePeak) {
     mInsertHist = insertHist;
     mInsertSizePeak = insertSizePeak;
 }
@@ -69,6 +69,13 @@ void JsonReporter::report(FilterResult* result, Stats* preStats1, Stats* postSta
     // summary
     ofs << "\t" << "\"summary\": {" << endl;
 
+    // the curves are computed with one in stats_sampling reads, the totals are exact
+    if(mOptions->stats.sampling > 1) {
+        ofs << "\t\t" << "\"stats_sampling\": " << mOptions->stats.sampling << "," << endl;
+        if(mOptions->stats.byPack)
+            ofs << "\t\t" << "\"stats_sampling_pack_size\": " << PACK_SIZE << "," << endl;
+    }
+
     ofs << "\t\t" << "\"before_filtering\": {" << endl;
     ofs << "\t\t\t" << "\"total_reads\":" << pre_total_reads << "," << endl; 
     ofs << "\t\t\t" << "\"total_bases\":" << pre_total_bases << "," << endl; 
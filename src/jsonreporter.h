@@ -19,7 +19,7 @@ public:
     ~JsonReporter();
 
     void setDupHist(int* dupHist, double* dupMeanGC, double dupRate);
-    void setInsertHist(atomic_long* insertHist, int insertSizePeak);
+    void setInsertHist(long* insertHist, int insertSizePeak);
     void report(FilterResult* result, Stats* preStats1, Stats* postStats1, Stats* preStats2 = NULL, Stats* postStats2 = NULL);
 
 private:
@@ -27,7 +27,7 @@ private:
     int* mDupHist;
     double* mDupMeanGC;
     double mDupRate;
-    atomic_long* mInsertHist;
+    long* mInsertHist;
     int mInsertSizePeak;
 };
 
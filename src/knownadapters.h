@@ -8,7 +8,7 @@
 #include <string>
 #include <map>
 
-inline map<string, string> getKnownAdapter() {
+inline map<string, string> makeKnownAdapter() {
     map<string, string> knownAdapters;
 
     knownAdapters["AGATCGGAAGAGCACACGTCTGAACTCCAGTCA"] = ">Illumina TruSeq Adapter Read 1";
@@ -247,4 +247,10 @@ inline map<string, string> getKnownAdapter() {
 	
     return knownAdapters;
 }
+
+// the map is made once and shared, it's never changed after that
+inline const map<string, string>& getKnownAdapter() {
+    static const map<string, string> knownAdapters = makeKnownAdapter();
+    return knownAdapters;
+}
 #endif
\ No newline at end of file
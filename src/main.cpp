@@ -46,10 +46,15 @@ int main(int argc, char* argv[]){
     cmd.add<int>("compression", 'z', "compression level for gzip output (1 ~ 9). 1 is fastest, 9 is smallest, default is 4.", false, 4);
     cmd.add("stdin", 0, "input from STDIN. If the STDIN is interleaved paired-end FASTQ, please also add --interleaved_in.");
     cmd.add("stdout", 0, "stream passing-filters reads to STDOUT. This option will result in interleaved FASTQ output for paired-end output. Disabled by default.");
+    cmd.add("stdout_compress", 0, "compress the STDOUT stream in gzip format, with the compression level set by -z. Disabled by default.");
+    cmd.add<string>("shm_out", 0, "publish passing-filters reads to a POSIX shared memory ring with this name (like /fastp_out) instead of STDOUT, for a consumer on the same host. See fastp_shm_cat for the reference consumer.", false, "");
+    cmd.add<int>("shm_slots", 0, "the number of slots in the shared memory ring, each slot holds a pack of reads, default is 16", false, 16);
+    cmd.add<int>("shm_slot_size", 0, "the size of each slot in the shared memory ring in MB, default is 8", false, 8);
     cmd.add("interleaved_in", 0, "indicate that <in1> is an interleaved FASTQ which contains both read1 and read2. Disabled by default.");
     cmd.add<int>("reads_to_process", 0, "specify how many reads/pairs to be processed. Default 0 means process all reads.", false, 0);
     cmd.add("dont_overwrite", 0, "don't overwrite existing files. Overwritting is allowed by default.");
     cmd.add("fix_mgi_id", 0, "the MGI FASTQ ID format is not compatible with many BAM operation tools, enable this option to fix it.");
+    cmd.add("report_only", 0, "only make the JSON/HTML QC reports of the input, nothing is trimmed, filtered or written. Records are counted without being parsed to reads, so it is much faster. Disabled by default.");
     cmd.add("verbose", 'V', "output verbose log information (i.e. when every 1M reads are processed).");
 
     // adapter
@@ -106,6 +111,10 @@ int main(int argc, char* argv[]){
     cmd.add("low_complexity_filter", 'y', "enable low complexity filter. The complexity is defined as the percentage of base that is different from its next base (base[i] != base[i+1]).");
     cmd.add<int>("complexity_threshold", 'Y', "the threshold for low complexity filter (0~100). Default is 30, which means 30% complexity is required.", false, 30);
 
+    // deduplication
+    cmd.add("dedup", 'D', "enable deduplication to drop the duplicated reads/pairs, the reads (pairs) with exactly the same sequences are duplicated, and only the first one is kept.");
+    cmd.add<int>("dedup_memory", 0, "the memory budget of deduplication in MB (16~1048576), each read/pair takes 16 bytes. If there are too many unique reads, the reads after the budget is used up are not deduplicated. Default is 1024.", false, 1024);
+
     // filter by indexes
     cmd.add<string>("filter_by_index1", 0, "specify a file contains a list of barcodes of index1 to be filtered out, one barcode per line", false, "");
     cmd.add<string>("filter_by_index2", 0, "specify a file contains a list of barcodes of index2 to be filtered out, one barcode per line", false, "");
@@ -116,6 +125,8 @@ int main(int argc, char* argv[]){
     cmd.add<int>("overlap_len_require", 0, "the minimum length to detect overlapped region of PE reads. This will affect overlap analysis based PE merge, adapter trimming and correction. 30 by default.", false, 30);
     cmd.add<int>("overlap_diff_limit", 0, "the maximum number of mismatched bases to detect overlapped region of PE reads. This will affect overlap analysis based PE merge, adapter trimming and correction. 5 by default.", false, 5);
     cmd.add<int>("overlap_diff_percent_limit", 0, "the maximum percentage of mismatched bases to detect overlapped region of PE reads. This will affect overlap analysis based PE merge, adapter trimming and correction. Default 20 means 20%.", false, 20);
+    cmd.add("overlap_prior", 0, "try the offsets of the most frequent insert sizes first in overlap analysis, it's faster but a low complexity pair may get a different one of its overlaps. Default is disabled.");
+    cmd.add("disable_overlap_indel", 0, "don't allow indels (up to 3bp) in the overlapped region for merging and correction. By default, a pair without an overlap is aligned again with the indels.");
 
     // umi
     cmd.add("umi", 'U', "enable unique molecular identifier (UMI) preprocessing");
@@ -129,6 +140,10 @@ int main(int argc, char* argv[]){
     cmd.add<int>("overrepresentation_sampling", 'P', "one in (--overrepresentation_sampling) reads will be computed for overrepresentation analysis (1~10000), smaller is slower, default is 20.", false, 20);
     
     // reporting
+    cmd.add("long_read", 0, "enable long read mode for ONT/PacBio reads, the per-cycle stats are binned by position and the read length/quality histograms are reported. Disabled by default.");
+    cmd.add<int>("stats_sampling", 0, "one in (--stats_sampling) reads will be computed for per-cycle quality/content curves and k-mers (1~10000), while the read/base numbers, Q20/Q30 and GC content are still exact. Default is 1, which means all reads are used.", false, 1);
+    cmd.add("stats_sampling_by_pack", 0, "sample the reads of --stats_sampling by packs of 1000 reads, one in (--stats_sampling) packs is used. Disabled by default.");
+    cmd.add("dup_sketch", 0, "estimate the duplication rate and histogram with per-thread sketches (~2MB each) of the whole reads/pairs, instead of the 176MB table of the read heads. The result is approximate for large data. Disabled by default.");
     cmd.add<string>("json", 'j', "the json format report file name", false, "fastp.json");
     cmd.add<string>("html", 'h', "the html format report file name", false, "fastp.html");
     cmd.add<string>("report_title", 'R', "should be quoted with \' or \", default is \"fastp report\"", false, "fastp report");
@@ -140,6 +155,7 @@ int main(int argc, char* argv[]){
     cmd.add<int>("split", 's', "split output by limiting total split file number with this option (2~999), a sequential number prefix will be added to output name ( 0001.out.fq, 0002.out.fq...), disabled by default", false, 0);
     cmd.add<long>("split_by_lines", 'S', "split output by limiting lines of each file with this option(>=1000), a sequential number prefix will be added to output name ( 0001.out.fq, 0002.out.fq...), disabled by default", false, 0);
     cmd.add<int>("split_prefix_digits", 'd', "the digits for the sequential number padding (1~10), default is 4, so the filename will be padded as 0001.xxx, 0 to disable padding", false, 4);
+    cmd.add<int>("partition", 0, "partition output to this number of files (2~999) by the hash of read name, the reads of a pair are always in a same partition. The file names are prefixed like --split does, disabled by default", false, 0);
 
     // deprecated options
     cmd.add("cut_by_quality5", 0, "DEPRECATED, use --cut_front instead.");
@@ -178,8 +194,14 @@ int main(int argc, char* argv[]){
     opt.dontOverwrite = cmd.exist("dont_overwrite");
     opt.inputFromSTDIN = cmd.exist("stdin");
     opt.outputToSTDOUT = cmd.exist("stdout");
+    opt.compressSTDOUT = cmd.exist("stdout_compress");
+    opt.shm.enabled = cmd.exist("shm_out");
+    opt.shm.name = cmd.get<string>("shm_out");
+    opt.shm.slots = cmd.get<int>("shm_slots");
+    opt.shm.slotSize = cmd.get<int>("shm_slot_size");
     opt.interleavedInput = cmd.exist("interleaved_in");
     opt.verbose = cmd.exist("verbose");
+    opt.reportOnly = cmd.exist("report_only");
     opt.fixMGI = cmd.exist("fix_mgi_id");
 
     // merge PE
@@ -313,11 +335,17 @@ int main(int argc, char* argv[]){
     opt.complexityFilter.enabled = cmd.exist("low_complexity_filter");
     opt.complexityFilter.threshold = (min(100, max(0, cmd.get<int>("complexity_threshold")))) / 100.0;
 
+    // deduplication
+    opt.dedup.enabled = cmd.exist("dedup");
+    opt.dedup.memory = cmd.get<int>("dedup_memory");
+
     // overlap correction
     opt.correction.enabled = cmd.exist("correction");
     opt.overlapRequire = cmd.get<int>("overlap_len_require");
     opt.overlapDiffLimit = cmd.get<int>("overlap_diff_limit");
     opt.overlapDiffPercentLimit = cmd.get<int>("overlap_diff_percent_limit");
+    opt.overlapPrior = cmd.exist("overlap_prior");
+    opt.overlapIndel = !cmd.exist("disable_overlap_indel");
 
     // threading
     opt.thread = cmd.get<int>("thread");
@@ -348,6 +376,10 @@ int main(int argc, char* argv[]){
         opt.split.byFileLines = true;
     }
 
+    // partitioning
+    opt.partition.enabled = cmd.exist("partition");
+    opt.partition.number = cmd.get<int>("partition");
+
     if(opt.inputFromSTDIN || opt.in1=="/dev/stdin") {
         if(opt.split.needEvaluation) {
             error_exit("Splitting by file number is not supported in STDIN mode");
@@ -390,6 +422,12 @@ int main(int argc, char* argv[]){
     opt.overRepAnalysis.enabled = cmd.exist("overrepresentation_analysis");
     opt.overRepAnalysis.sampling = cmd.get<int>("overrepresentation_sampling");
 
+    // per-cycle stats sampling
+    opt.stats.sampling = cmd.get<int>("stats_sampling");
+    opt.stats.byPack = cmd.exist("stats_sampling_by_pack");
+    opt.longRead.enabled = cmd.exist("long_read");
+    opt.duplicate.sketch = cmd.exist("dup_sketch");
+
     // filtering by index
     string blacklist1 = cmd.get<string>("filter_by_index1");
     string blacklist2 = cmd.get<string>("filter_by_index2");
@@ -409,13 +447,17 @@ int main(int argc, char* argv[]){
     Evaluator eva(&opt);
     if(supportEvaluation) {
         eva.evaluateSeqLen();
-
-        if(opt.overRepAnalysis.enabled)
-            eva.evaluateOverRepSeqs();
     }
 
     long readNum = 0;
 
+    // nothing is trimmed in report only mode, so there is no need to detect the adapters
+    if(opt.reportOnly) {
+        opt.adapter.enabled = false;
+        opt.polyGTrim.enabled = false;
+        opt.polyXTrim.enabled = false;
+    }
+
     // using evaluator to guess how many reads in total
     if(opt.shallDetectAdapter(false)) {
         if(!supportEvaluation)
@@ -471,7 +513,7 @@ int main(int argc, char* argv[]){
     }
 
     // using evaluator to check if it's two color system
-    if(!cmd.exist("trim_poly_g") && !cmd.exist("disable_trim_poly_g") && supportEvaluation) {
+    if(!cmd.exist("trim_poly_g") && !cmd.exist("disable_trim_poly_g") && supportEvaluation && !opt.reportOnly) {
         bool twoColorSystem = eva.isTwoColorSystem();
         if(twoColorSystem){
             opt.polyGTrim.enabled = true;
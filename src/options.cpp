@@ -17,13 +17,17 @@ Options::Options(){
     dontOverwrite = false;
     inputFromSTDIN = false;
     outputToSTDOUT = false;
+    compressSTDOUT = false;
     readsToProcess = 0;
     interleavedInput = false;
     insertSizeMax = 512;
     overlapRequire = 30;
     overlapDiffLimit = 5;
     overlapDiffPercentLimit = 20;
+    overlapPrior = false;
+    overlapIndel = true;
     verbose = false;
+    reportOnly = false;
     seqLen1 = 151;
     seqLen2 = 151;
     fixMGI = false;
@@ -36,6 +40,19 @@ bool Options::isPaired() {
     return in2.length() > 0 || interleavedInput;
 }
 
+bool Options::outputToStream() {
+    return outputToSTDOUT || shm.enabled;
+}
+
+string Options::getStreamOutput() {
+    if(outputToSTDOUT)
+        return "/dev/stdout";
+    else if(shm.enabled)
+        return shm.name;
+    else
+        return "";
+}
+
 bool Options::adapterCuttingEnabled() {
     if(adapter.enabled){
         if(isPaired() || !adapter.sequence.empty())
@@ -103,7 +120,7 @@ bool Options::validate() {
         // enable correction if it's not enabled
         if(!correction.enabled)
             correction.enabled = true;
-        if(merge.out.empty() && !outputToSTDOUT && !out1.empty() && out2.empty()) {
+        if(merge.out.empty() && !outputToStream() && !out1.empty() && out2.empty()) {
             cerr << "You specified --out1, but haven't specified --merged_out in merging mode. Using --out1 to store the merged reads to be compatible with fastp 0.19.8" << endl << endl;
             merge.out = out1;
             out1 = "";
@@ -126,8 +143,8 @@ bool Options::validate() {
                 unpaired2 = "";
             }
         }
-        if(merge.out.empty() && !outputToSTDOUT) {
-            error_exit("In merging mode, you should either specify --merged_out or enable --stdout");
+        if(merge.out.empty() && !outputToStream()) {
+            error_exit("In merging mode, you should either specify --merged_out or enable --stdout (or --shm_out)");
         }
         if(!merge.out.empty()) {
             if(merge.out == out1)
@@ -147,17 +164,66 @@ bool Options::validate() {
         }
     }
 
-    // if output to STDOUT, then...
-    if(outputToSTDOUT) {
+    if(reportOnly) {
+        if(!out1.empty() || !out2.empty() || !unpaired1.empty() || !unpaired2.empty() || !failedOut.empty() || !overlappedOut.empty() || !merge.out.empty())
+            error_exit("report only mode (--report_only) cannot work with output files");
+        if(outputToStream())
+            error_exit("report only mode (--report_only) cannot work with stdout or shared memory mode");
+        if(merge.enabled || split.enabled || partition.enabled)
+            error_exit("report only mode (--report_only) cannot work with merging, splitting or partitioning mode");
+        if(dedup.enabled)
+            error_exit("report only mode (--report_only) cannot work with deduplication (--dedup)");
+    }
+
+    if(compressSTDOUT && !outputToSTDOUT) {
+        cerr << "STDOUT output is not enabled (--stdout). Ignoring argument --stdout_compress" << endl;
+        compressSTDOUT = false;
+    }
+
+    if(shm.enabled) {
+        if(outputToSTDOUT)
+            error_exit("shared memory output (--shm_out) cannot work with stdout mode, please choose either.");
+        if(shm.name.empty() || shm.name[0] != '/' || shm.name.find('/', 1) != string::npos || shm.name.length() > 255)
+            error_exit("the shared memory object name (--shm_out) should start with / and contain no other /, like /fastp_out");
+        if(shm.slots < 2 || shm.slots > 1024)
+            error_exit("the slot number of shared memory output (--shm_slots) should be 2 ~ 1024.");
+        if(shm.slotSize < 1 || shm.slotSize > 1024)
+            error_exit("the slot size of shared memory output in MB (--shm_slot_size) should be 1 ~ 1024.");
+    }
+
+    // if output to STDOUT or shared memory, then...
+    if(outputToStream()) {
+        string target = outputToSTDOUT ? "STDOUT" : "shared memory " + shm.name;
         if(split.enabled) {
-            error_exit("splitting mode cannot work with stdout mode");
+            error_exit("splitting mode cannot work with stdout or shared memory mode");
         }
-        cerr << "Streaming uncompressed ";
+        if(partition.enabled) {
+            error_exit("partitioning mode cannot work with stdout or shared memory mode");
+        }
+        if(merge.enabled) {
+            if(!merge.out.empty()) {
+                cerr << "Streaming merged reads to " << target << ". Ignoring argument --merged_out = " << merge.out << endl;
+                merge.out = "";
+            }
+        } else {
+            if(!out1.empty()) {
+                cerr << "Streaming reads to " << target << ". Ignoring argument --out1 = " << out1 << endl;
+                out1 = "";
+            }
+            if(!out2.empty()) {
+                cerr << "Streaming reads to " << target << ". Ignoring argument --out2 = " << out2 << endl;
+                out2 = "";
+            }
+        }
+        if(compressSTDOUT)
+            cerr << "Streaming gzip compressed ";
+        else
+            cerr << "Streaming uncompressed ";
         if(merge.enabled)
             cerr << "merged";
         else if(isPaired())
             cerr << "interleaved";
-        cerr << " reads to STDOUT..." << endl;
+        cerr << " reads to " << target << "..." << endl;
         if(isPaired() && !merge.enabled)
             cerr << "Enable interleaved output mode for paired-end input." << endl;
         cerr << endl;
@@ -319,9 +385,6 @@ bool Options::validate() {
         if(split.byFileNumber) {
             if(split.number < 2 || split.number >= 1000)
                 error_exit("you have enabled splitting output by file number, the number of files (--split) should be 2 ~ 999.");
-            // thread number cannot be more than the number of file to split
-            if(thread > split.number)
-                thread = split.number;
         }
 
         if(split.byFileLines) {
@@ -330,6 +393,17 @@ bool Options::validate() {
         }
     }
 
+    if(partition.enabled) {
+        if(split.enabled)
+            error_exit("partitioning mode (--partition) cannot work with splitting mode (--split or --split_by_lines), please choose either.");
+        if(partition.number < 2 || partition.number >= 1000)
+            error_exit("you have enabled partitioning output, the number of partitions (--partition) should be 2 ~ 999.");
+        if(split.digits < 0 || split.digits > 10)
+            error_exit("you have enabled partitioning output, the digits number of file name prefix (--split_prefix_digits) should be 0 ~ 10.");
+        if(out1.empty())
+            error_exit("you have enabled partitioning output, but no output file is specified by --out1");
+    }
+
     if(qualityCut.enabledFront || qualityCut.enabledTail || qualityCut.enabledRight) {
         if(qualityCut.windowSizeShared < 1 || qualityCut.windowSizeShared > 1000)
             error_exit("the sliding window size for cutting by quality (--cut_window_size) should be between 1~1000.");
@@ -425,6 +499,15 @@ bool Options::validate() {
     if(overRepAnalysis.sampling < 1 || overRepAnalysis.sampling > 10000)
         error_exit("overrepresentation_sampling should be 1~10000");
 
+    if(stats.sampling < 1 || stats.sampling > 10000)
+        error_exit("stats_sampling should be 1~10000");
+
+    if(stats.byPack && stats.sampling == 1)
+        cerr << "WARNING: all reads are used without --stats_sampling, ignoring --stats_sampling_by_pack" << endl;
+
+    if(dedup.enabled && (dedup.memory < 16 || dedup.memory > 1048576))
+        error_exit("dedup_memory should be 16~1048576");
+
     return true;
 }
 
@@ -29,15 +29,30 @@ public:
     string out;
 };
 
+class DedupOptions {
+public:
+    DedupOptions() {
+        enabled = false;
+        memory = 1024;
+    }
+public:
+    bool enabled;
+    // the memory budget of the fingerprint set in MB
+    int memory;
+};
+
 class DuplicationOptions {
 public:
     DuplicationOptions() {
         enabled = true;
+        sketch = false;
         keylen = 12;
         histSize = 32;
     }
 public:
     bool enabled;
+    // estimate by the per-thread sketches of the whole reads instead of the table of 4^keylen keys
+    bool sketch;
     int keylen;
     int histSize;
 };
@@ -77,6 +92,29 @@ public:
     int sampling;
 };
 
+class StatsOptions {
+public:
+    StatsOptions() {
+        sampling = 1;
+        byPack = false;
+    }
+public:
+    // one in (sampling) reads is counted for the per-cycle stats and k-mers
+    int sampling;
+    // the reads are sampled by packs of PACK_SIZE reads, one in (sampling) packs is counted
+    bool byPack;
+};
+
+class LongReadOptions {
+public:
+    LongReadOptions() {
+        enabled = false;
+    }
+public:
+    // the per-cycle stats are binned by position, and the read length/quality histograms are reported
+    bool enabled;
+};
+
 class PolyGTrimmerOptions {
 public:
     PolyGTrimmerOptions() {
@@ -190,12 +228,42 @@ public:
     bool byFileLines;
 };
 
+class SharedMemoryOptions {
+public:
+    SharedMemoryOptions() {
+        enabled = false;
+        slots = 16;
+        slotSize = 8;
+    }
+public:
+    bool enabled;
+    // the POSIX shared memory object name, like /fastp_out
+    string name;
+    // number of slots in the ring
+    int slots;
+    // the size of each slot in MB
+    int slotSize;
+};
+
+class PartitionOptions {
+public:
+    PartitionOptions() {
+        enabled = false;
+        number = 0;
+    }
+public:
+    bool enabled;
+    // number of partitions, each partition is written to a file (or a pair of files for PE data)
+    int number;
+};
+
 class AdapterOptions {
 public:
     AdapterOptions() {
         enabled = true;
         hasSeqR1 = false;
         hasSeqR2 = false;
+        hasFasta = false;
         detectAdapterForPE = false;
     }
 public:
@@ -280,6 +348,9 @@ public:
     Options();
     void init();
     bool isPaired();
+    // the passing reads are streamed to STDOUT or shared memory, interleaved for PE data
+    bool outputToStream();
+    string getStreamOutput();
     bool validate();
     bool adapterCuttingEnabled();
     bool polyXTrimmingEnabled();
@@ -323,6 +394,10 @@ public:
     bool inputFromSTDIN;
     // write STDOUT
     bool outputToSTDOUT;
+    // compress the STDOUT stream in gzip format
+    bool compressSTDOUT;
+    // publish the output to a shared memory ring
+    SharedMemoryOptions shm;
     // the input R1 file is interleaved
     bool interleavedInput;
     // only process first N reads
@@ -341,6 +416,8 @@ public:
     AdapterOptions adapter;
     // multiple file splitting options
     SplitOptions split;
+    // output partitioning by hash of read name
+    PartitionOptions partition;
     // options for quality cutting
     QualityCutOptions qualityCut;
     // options for base correction
@@ -353,8 +430,10 @@ public:
     PolyXTrimmerOptions polyXTrim;
     // for overrepresentation analysis
     OverrepresentedSequenceAnasysOptions overRepAnalysis;
-    map<string, long> overRepSeqs1;
-    map<string, long> overRepSeqs2;
+    // for sampling the per-cycle stats
+    StatsOptions stats;
+    // for long reads like ONT/PacBio
+    LongReadOptions longRead;
     int seqLen1;
     int seqLen2;
     // low complexity filtering
@@ -363,14 +442,22 @@ public:
     IndexFilterOptions indexFilter;
     // options for duplication profiling
     DuplicationOptions duplicate;
+    // drop the exact duplicated reads/pairs
+    DedupOptions dedup;
     // max value of insert size
     int insertSizeMax;
     // overlap analysis threshold
     int overlapRequire;
     int overlapDiffLimit;
     int overlapDiffPercentLimit;
+    // try the offsets of the most frequent insert sizes first
+    bool overlapPrior;
+    // allow indels in the overlap for merging and correction if no ungapped one is found
+    bool overlapIndel;
     // output debug information
     bool verbose;
+    // only make the QC reports of the input, nothing is trimmed, filtered or written
+    bool reportOnly;
     // merge options
     MergeOptions merge;
 
@@ -1,4 +1,7 @@
 #include "overlapanalysis.h"
+#include "simd.h"
+#include "adapterindex.h"
+#include <string.h>
 
 OverlapAnalysis::OverlapAnalysis(){
 }
@@ -14,12 +17,356 @@ OverlapResult OverlapAnalysis::analyze(Read* r1, Read* r2, int overlapDiffLimit,
 // ported from the python code of AfterQC
 OverlapResult OverlapAnalysis::analyze(Sequence& r1, Sequence& r2, int diffLimit, int overlapRequire, double diffPercentLimit) {
     Sequence rcr2 = ~r2;
-    int len1 = r1.length();
-    int len2 = rcr2.length();
     // use the pointer directly for speed
-    const char* str1 = r1.mStr.c_str();
-    const char* str2 = rcr2.mStr.c_str();
+    return analyze(r1.mStr.c_str(), r1.length(), rcr2.mStr.c_str(), rcr2.length(), diffLimit, overlapRequire, diffPercentLimit);
+}
+
+OverlapResult OverlapAnalysis::analyze(const char* str1, int len1, const char* str2, int len2, int diffLimit, int overlapRequire, double diffPercentLimit,
+                                       const int* probes, int probeCount) {
+    // the offsets are compared by the SIMD mismatch counting kernels, with the same rules as analyzeByLoop()
+    OverlapResult ov;
+    ov.overlapped = Simd::findOverlap(str1, len1, str2, len2, diffLimit, overlapRequire, diffPercentLimit, probes, probeCount,
+                                      &ov.offset, &ov.overlap_len, &ov.diff);
+    if(!ov.overlapped)
+        ov.offset = ov.overlap_len = ov.diff = 0;
+    ov.overlap_len2 = ov.overlap_len;
+    ov.gap_pos = -1;
+    return ov;
+}
+
+OverlapGapBuffer::OverlapGapBuffer() {
+    memset(mPositions, 0, sizeof(mPositions));
+    mStamp = 0;
+}
+
+// the bases of str1 before the single indel of the gapped overlap of str1 and str2 with the differences,
+// where the bases of both sides of the indel have the fewest mismatches. -2 if no single indel gives the differences
+static int singleGapPosition(const char* str1, int len1, const char* str2, int len2, int diff) {
+    int delta = len2 - len1;
+    if(delta == 0)
+        return -2;
+    // str1[i] is paired with str2[i] before the indel at p, and with str2[i + delta] after it, from str1[p + skipped]
+    int skipped = max(0, -delta);
+    int after = 0;
+    for(int i=skipped; i<len1; i++)
+        after += str1[i] != str2[i + delta];
+    int before = 0;
+    int best = after;
+    int bestPos = 0;
+    for(int p=1; p<=min(len1, len2); p++) {
+        before += str1[p - 1] != str2[p - 1];
+        after -= str1[p - 1 + skipped] != str2[p - 1 + skipped + delta];
+        if(before + after < best) {
+            best = before + after;
+            bestPos = p;
+        }
+    }
+    return best + abs(delta) == diff ? bestPos : -2;
+}
+
+OverlapResult OverlapAnalysis::analyzeGapped(const char* str1, int len1, const char* str2, int len2, int diffLimit, int overlapRequire, double diffPercentLimit,
+                                             OverlapGapBuffer* buffer) {
+    OverlapResult ov;
+    ov.overlapped = false;
+    ov.offset = ov.overlap_len = ov.overlap_len2 = ov.diff = 0;
+    ov.gap_pos = -1;
+    // the start of the overlap is packed in the states of the band, and the positions of str2 in 16 bits
+    if(len1 - overlapRequire <= 1 || len2 < 6 || len1 > GAP_START_MASK || len2 > 0xFFFF)
+        return ov;
+
+    // the exact 6-mers of str1 vote for the offsets they are found at in str2, the overlap is on a few nearby offsets if it has indels.
+    // the 6-mers of str2 are addressed directly by their 12-bit codes, a repeated 6-mer keeps its last position
+    unsigned int* positions = buffer->mPositions;
+    buffer->mStamp = (buffer->mStamp + 1) & 0xFFFF;
+    if(buffer->mStamp == 0) {
+        memset(positions, 0, sizeof(buffer->mPositions));
+        buffer->mStamp = 1;
+    }
+    unsigned int stamp = buffer->mStamp << 16;
+    unsigned int code = 0;
+    int valid = 0;
+    for(int i=0; i<len2; i++) {
+        int base = AdapterIndex::baseCode(str2[i]);
+        code = ((code << 2) | (base & 0x03)) & 0xFFF;
+        valid = base < 0 ? 0 : valid + 1;
+        if(valid >= 6)
+            positions[code] = stamp | (i - 5);
+    }
+    int limit = len1 - overlapRequire;
+    buffer->mVotes.assign(limit, 0);
+    int* votes = buffer->mVotes.data();
+    code = 0;
+    valid = 0;
+    for(int i=0; i<len1; i++) {
+        int base = AdapterIndex::baseCode(str1[i]);
+        code = ((code << 2) | (base & 0x03)) & 0xFFF;
+        valid = base < 0 ? 0 : valid + 1;
+        unsigned int found = positions[code];
+        int d = i - 5 - (int)(found & 0xFFFF);
+        // the 6-mers not found in str2 and the offsets out of range vote for the offset 0, which is not counted
+        bool counted = valid >= 6 && (found & 0xFFFF0000) == stamp && d > 0 && d < limit;
+        votes[counted ? d : 0]++;
+    }
+    votes[0] = 0;
+    // the band is centered at the offset with the most votes, so the other side of an indel is in the band whichever way it goes.
+    // a quarter of the overlap should be covered by the exact 6-mers of the band
+    int best = 0;
+    for(int d=1; d<limit; d++) {
+        if(votes[d] > votes[best])
+            best = d;
+    }
+    int bestVotes = 0;
+    for(int d=max(1, best - OVERLAP_GAP_BAND); d<=min(limit - 1, best + OVERLAP_GAP_BAND); d++)
+        bestVotes += votes[d];
+    if(best == 0 || bestVotes < (len1 - best) / 4)
+        return ov;
+
+    // the banded alignment with affine gaps, the 7 diagonals around the best offset are aligned by the SIMD kernels.
+    // an accepted path has no more indels than differences, so its cost is no more than 2 * diffLimit
+    if(buffer->mPadded.size() < (size_t)len1 + 2 * OVERLAP_GAP_LANES)
+        buffer->mPadded.resize(len1 + 2 * OVERLAP_GAP_LANES);
+    char* padded = &buffer->mPadded[OVERLAP_GAP_LANES];
+    memcpy(padded, str1, len1);
+    int endRow = 0;
+    int end = Simd::alignBand(padded, len1, str2, len2, best, min(2 * diffLimit, 254), &endRow);
+    if(end >= GAP_STATE_NONE)
+        return ov;
+
+    int start = end & GAP_START_MASK;
+    int diff = (end / GAP_DIFF_UNIT) % (GAP_COST_UNIT / GAP_DIFF_UNIT);
+    int overlapLen = len1 - start;
+    int overlapLimit = min(diffLimit, (int)(overlapLen * diffPercentLimit));
+    if(overlapLen <= overlapRequire || diff > overlapLimit)
+        return ov;
+    ov.overlapped = true;
+    ov.offset = start;
+    ov.overlap_len = overlapLen;
+    ov.overlap_len2 = endRow;
+    ov.diff = diff;
+    ov.gap_pos = singleGapPosition(str1 + start, overlapLen, str2, endRow, diff);
+    return ov;
+}
+
+Read* OverlapAnalysis::merge(Read* r1, Read* r2, OverlapResult ov) {
+    int ol = ov.overlap_len;
+    if(!ov.overlapped)
+        return NULL;
+
+    int len1 = ol + max(0, ov.offset);
+    int len2 = 0; 
+    if(ov.offset > 0)
+        len2 = r2->length() - ov.overlap_len2;
 
+    Read* rr2 = r2->reverseComplement();
+    string mergedSeq = r1->mSeq.mStr.substr(0, len1);
+    if(ov.offset > 0) {
+        mergedSeq += rr2->mSeq.mStr.substr(ov.overlap_len2, len2);
+    }
+
+    string mergedQual = r1->mQuality.substr(0, len1);
+    if(ov.offset > 0) {
+        mergedQual += rr2->mQuality.substr(ov.overlap_len2, len2);
+    }
+
+    delete rr2;
+
+    string name = r1->mName + " merged_" + to_string(len1) + "_" + to_string(len2);
+    Read* mergedRead = new Read(name, mergedSeq, r1->mStrand, mergedQual);
+
+    return mergedRead;
+}
+
+const char* OverlapContext::reverse2(int len2) {
+    if(!mReverseValid || mReverseLen < len2) {
+        mReverse2.resize(len2);
+        Simd::reverseComplement(mRead2->mSeq.mStr.c_str(), &mReverse2[0], len2);
+        mReverseLen = len2;
+        mReverseValid = true;
+    }
+    return mReverse2.c_str() + mReverseLen - len2;
+}
+
+OverlapResult OverlapContext::analyzeGapped(double diffPercentLimit) {
+    int len1 = mRead1->length();
+    int len2 = mRead2->length();
+    if(mGappedValid && mGappedPercent == diffPercentLimit && mGappedLen1 == len1 && mGappedLen2 == len2)
+        return mGappedResult;
+
+    const char* str2 = reverse2(len2);
+    mGappedResult = OverlapAnalysis::analyzeGapped(mRead1->mSeq.mStr.c_str(), len1, str2, len2, mDiffLimit, mOverlapRequire, diffPercentLimit, mGapBuffer);
+    mGappedPercent = diffPercentLimit;
+    mGappedLen1 = len1;
+    mGappedLen2 = len2;
+    mGappedValid = true;
+    return mGappedResult;
+}
+
+OverlapPrior::OverlapPrior() {
+    for(int i=0; i<OVERLAP_PRIOR_PROBES; i++)
+        mInsertSizes[i] = 0;
+    mCount = 0;
+}
+
+void OverlapPrior::update(const long* hist, int size) {
+    // the bins of the top counts are kept in order, a tie is won by the smaller insert size
+    int top[OVERLAP_PRIOR_PROBES];
+    long counts[OVERLAP_PRIOR_PROBES];
+    int count = 0;
+    for(int i=0; i<size; i++) {
+        long c = hist[i];
+        if(c == 0 || (count == OVERLAP_PRIOR_PROBES && c <= counts[count - 1]))
+            continue;
+        int pos = count < OVERLAP_PRIOR_PROBES ? count++ : count - 1;
+        while(pos > 0 && counts[pos - 1] < c) {
+            top[pos] = top[pos - 1];
+            counts[pos] = counts[pos - 1];
+            pos--;
+        }
+        top[pos] = i;
+        counts[pos] = c;
+    }
+    for(int i=0; i<count; i++)
+        mInsertSizes[i].store(top[i], memory_order_relaxed);
+    mCount.store(count, memory_order_release);
+}
+
+int OverlapPrior::offsets(int len2, int frontTrimmed1, int frontTrimmed2, int* offsets) {
+    // the insert size is the distance from the start of read1 to the end of the reverse complement of read2 before trimming
+    int count = mCount.load(memory_order_acquire);
+    for(int i=0; i<count; i++)
+        offsets[i] = mInsertSizes[i].load(memory_order_relaxed) - frontTrimmed1 - frontTrimmed2 - len2;
+    return count;
+}
+
+bool OverlapPrior::test() {
+    OverlapPrior prior;
+    int offsets[OVERLAP_PRIOR_PROBES];
+    if(prior.offsets(100, 0, 0, offsets) != 0)
+        return false;
+
+    // a peak at 180 and a smaller one at 120, and 20 sizes of a same small count
+    long hist[300];
+    for(int i=0; i<300; i++)
+        hist[i] = 0;
+    for(int i=0; i<20; i++)
+        hist[200 + i] = 1;
+    for(int i=-3; i<=3; i++) {
+        hist[180 + i] = 100 - abs(i) * 10;
+        hist[120 + i] = 50 - abs(i) * 10;
+    }
+    prior.update(hist, 300);
+    int count = prior.offsets(100, 5, 3, offsets);
+    if(count != min(34, OVERLAP_PRIOR_PROBES))
+        return false;
+    int expected[16] = {180, 179, 181, 178, 182, 177, 183, 120, 119, 121, 118, 122, 117, 123, 200, 201};
+    for(int i=0; i<min(count, 16); i++) {
+        if(offsets[i] != expected[i] - 5 - 3 - 100)
+            return false;
+    }
+
+    // the pair is found at the same offset with or without the prior
+    Sequence r1("CAGCGCCTACGGGCCCCTTTTTCTGCGCGACCGCGTGGCTGTGGGCGCGGATGCCTTTGAGCGCGGTGACTTCTCACTGCGTATCGAGC");
+    Sequence r2("ACCTCCAGCGGCTCGATACGCAGTGAGAAGTCACCGCGCTCAAAGGCATCCGCGCCCACAGCCACGCGGTCGCGCAGAAAAAGGGGTCC");
+    Sequence rcr2 = ~r2;
+    // the insert size is 89 + 89 - 79 = 99
+    for(int i=0; i<300; i++)
+        hist[i] = i == 99 ? 10 : 0;
+    prior.update(hist, 300);
+    count = prior.offsets(r2.length(), 0, 0, offsets);
+    OverlapResult ov = OverlapAnalysis::analyze(r1.mStr.c_str(), r1.length(), rcr2.mStr.c_str(), rcr2.length(), 2, 30, 0.2, offsets, count);
+    return count == 1 && offsets[0] == 10 && ov.overlapped && ov.offset == 10 && ov.overlap_len == 79 && ov.diff == 1;
+}
+
+OverlapContext::OverlapContext(int diffLimit, int overlapRequire, OverlapPrior* prior, OverlapGapBuffer* gapBuffer) {
+    mDiffLimit = diffLimit;
+    mOverlapRequire = overlapRequire;
+    mPrior = prior;
+    mOwnGapBuffer = gapBuffer == NULL;
+    mGapBuffer = mOwnGapBuffer ? new OverlapGapBuffer() : gapBuffer;
+    reset(NULL, NULL);
+}
+
+OverlapContext::~OverlapContext() {
+    if(mOwnGapBuffer)
+        delete mGapBuffer;
+    mGapBuffer = NULL;
+}
+
+void OverlapContext::reset(Read* r1, Read* r2, int frontTrimmed1, int frontTrimmed2) {
+    mRead1 = r1;
+    mRead2 = r2;
+    mFrontTrimmed1 = frontTrimmed1;
+    mFrontTrimmed2 = frontTrimmed2;
+    mReverseLen = 0;
+    invalidate();
+}
+
+void OverlapContext::invalidate() {
+    mReverseValid = false;
+    mValid[0] = mValid[1] = false;
+    mNextSlot = 0;
+    mGappedValid = false;
+}
+
+OverlapResult OverlapContext::analyze(double diffPercentLimit) {
+    int len1 = mRead1->length();
+    int len2 = mRead2->length();
+    for(int i=0; i<2; i++) {
+        if(mValid[i] && mPercents[i] == diffPercentLimit && mLens1[i] == len1 && mLens2[i] == len2)
+            return mResults[i];
+    }
+
+    const char* str2 = reverse2(len2);
+    int probes[OVERLAP_PRIOR_PROBES];
+    int probeCount = mPrior ? mPrior->offsets(len2, mFrontTrimmed1, mFrontTrimmed2, probes) : 0;
+    OverlapResult ov = OverlapAnalysis::analyze(mRead1->mSeq.mStr.c_str(), len1, str2, len2, mDiffLimit, mOverlapRequire, diffPercentLimit,
+                                                probes, probeCount);
+
+    // the slot of the same diffPercentLimit is replaced, otherwise the older one
+    int slot = mNextSlot;
+    for(int i=0; i<2; i++) {
+        if(mValid[i] && mPercents[i] == diffPercentLimit)
+            slot = i;
+    }
+    mResults[slot] = ov;
+    mPercents[slot] = diffPercentLimit;
+    mLens1[slot] = len1;
+    mLens2[slot] = len2;
+    mValid[slot] = true;
+    mNextSlot = 1 - slot;
+    return ov;
+}
+
+bool OverlapContext::test() {
+    Read r1("@name", "CAGCGCCTACGGGCCCCTTTTTCTGCGCGACCGCGTGGCTGTGGGCGCGGATGCCTTTGAGCGCGGTGACTTCTCACTGCGTATCGAGC", "+",
+            "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF");
+    Read r2("@name", "ACCTCCAGCGGCTCGATACGCAGTGAGAAGTCACCGCGCTCAAAGGCATCCGCGCCCACAGCCACGCGGTCGCGCAGAAAAAGGGGTCC", "+",
+            "#########################################################################################");
+    OverlapContext context(2, 30);
+    context.reset(&r1, &r2);
+    // the results of every diffPercentLimit and read lengths should be the same as the ones computed directly
+    for(int step=0; step<6; step++) {
+        double percents[3] = {0.2, 0.0, 0.2};
+        for(int i=0; i<3; i++) {
+            OverlapResult ov = context.analyze(percents[i]);
+            OverlapResult expected = OverlapAnalysis::analyze(&r1, &r2, 2, 30, percents[i]);
+            if(ov.overlapped != expected.overlapped || ov.offset != expected.offset || ov.overlap_len != expected.overlap_len || ov.diff != expected.diff)
+                return false;
+        }
+        if(step == 2) {
+            // the mismatch is corrected
+            r2.mSeq.mStr[r2.length() - 3] = 'G';
+            context.invalidate();
+        } else {
+            r1.resize(r1.length() - 7);
+            r2.resize(r2.length() - 5);
+        }
+    }
+    return true;
+}
+
+// the byte by byte comparison, which is kept to test the kernels
+static OverlapResult analyzeByLoop(const char* str1, int len1, const char* str2, int len2, int diffLimit, int overlapRequire, double diffPercentLimit) {
     int complete_compare_require = 50;
 
     int overlap_len = 0;
@@ -95,35 +442,6 @@ OverlapResult OverlapAnalysis::analyze(Sequence& r1, Sequence& r2, int diffLimit
     return ov;
 }
 
-Read* OverlapAnalysis::merge(Read* r1, Read* r2, OverlapResult ov) {
-    int ol = ov.overlap_len;
-    if(!ov.overlapped)
-        return NULL;
-
-    int len1 = ol + max(0, ov.offset);
-    int len2 = 0; 
-    if(ov.offset > 0)
-        len2 = r2->length() - ol;
-
-    Read* rr2 = r2->reverseComplement();
-    string mergedSeq = r1->mSeq.mStr.substr(0, len1);
-    if(ov.offset > 0) {
-        mergedSeq += rr2->mSeq.mStr.substr(ol, len2);
-    }
-
-    string mergedQual = r1->mQuality.substr(0, len1);
-    if(ov.offset > 0) {
-        mergedQual += rr2->mQuality.substr(ol, len2);
-    }
-
-    delete rr2;
-
-    string name = r1->mName + " merged_" + to_string(len1) + "_" + to_string(len2);
-    Read* mergedRead = new Read(name, mergedSeq, r1->mStrand, mergedQual);
-
-    return mergedRead;
-}
-
 bool OverlapAnalysis::test(){
     //Sequence r1("CAGCGCCTACGGGCCCCTTTTTCTGCGCGACCGCGTGGCTGTGGGCGCGGATGCCTTTGAGCGCGGTGACTTCTCACTGCGTATCGAGCCGCTGGAGGTCTCCC");
     //Sequence r2("ACCTCCAGCGGCTCGATACGCAGTGAGAAGTCACCGCGCTCAAAGGCATCCGCGCCCACAGCCACGCGGTCGCGCAGAAAAAGGGGCCCGTAGGCGCGGCTCCC");
@@ -141,5 +459,108 @@ bool OverlapAnalysis::test(){
     Read* mergedRead = OverlapAnalysis::merge(&read1, &read2, ov);
     mergedRead->print();
 
-    return ov.overlapped && ov.offset == 10 && ov.overlap_len == 79 && ov.diff == 1;
+    if(!(ov.overlapped && ov.offset == 10 && ov.overlap_len == 79 && ov.diff == 1))
+        return false;
+
+    // the random pairs with str2 moved right or left, and some mismatches around the complete_compare_require bases
+    const char bases[] = "ACGTN";
+    unsigned int seed = 3;
+    for(int n=0; n<5000; n++) {
+        seed = seed * 1103515245 + 12345;
+        int len1 = (seed >> 16) % 160;
+        seed = seed * 1103515245 + 12345;
+        int len2 = (seed >> 16) % 160;
+        seed = seed * 1103515245 + 12345;
+        int offset = (int)((seed >> 16) % (len1 + len2 + 40)) - len2;
+        string str1(len1, 'A');
+        string str2(len2, 'A');
+        for(int i=0; i<len1; i++) {
+            seed = seed * 1103515245 + 12345;
+            str1[i] = bases[(seed >> 16) % 5];
+        }
+        for(int i=0; i<len2; i++) {
+            seed = seed * 1103515245 + 12345;
+            if(offset + i >= 0 && offset + i < len1 && (seed >> 16) % (20 + n % 40) != 0)
+                str2[i] = str1[offset + i];
+            else
+                str2[i] = bases[(seed >> 20) % 4];
+        }
+        int diffLimit = n % 8;
+        int overlapRequire = n % 40;
+        double diffPercentLimit = (n % 5) * 0.05;
+        OverlapResult expected = analyzeByLoop(str1.c_str(), len1, str2.c_str(), len2, diffLimit, overlapRequire, diffPercentLimit);
+        OverlapResult result = analyze(str1.c_str(), len1, str2.c_str(), len2, diffLimit, overlapRequire, diffPercentLimit);
+        if(result.overlapped != expected.overlapped || result.offset != expected.offset
+            || result.overlap_len != expected.overlap_len || result.diff != expected.diff) {
+            cerr << "OverlapAnalysis::test: different overlap of " << str1 << " and " << str2 << endl;
+            return false;
+        }
+    }
+
+    // the pairs of a fragment with an indel in read2 are merged back to the fragment by the gapped overlap
+    OverlapGapBuffer buffer;
+    int merged = 0;
+    for(int n=0; n<1000; n++) {
+        seed = seed * 1103515245 + 12345;
+        int insert = 160 + (seed >> 16) % 100;
+        string fragment(insert, 'A');
+        for(int i=0; i<insert; i++) {
+            seed = seed * 1103515245 + 12345;
+            fragment[i] = bases[(seed >> 16) % 4];
+        }
+        // a homopolymer of 1 to 3 bases is inserted to or deleted from read2 in the first 50 bases of the overlap
+        string tail = fragment.substr(insert - 150, 150);
+        seed = seed * 1103515245 + 12345;
+        int indel = 1 + (seed >> 16) % 3;
+        int pos = 10 + (seed >> 20) % 30;
+        if(n % 2 == 0)
+            tail.insert(pos, indel, tail[pos]);
+        else
+            tail.erase(pos, indel);
+        Read read1("@name", fragment.substr(0, 150), "+", string(150, 'I'));
+        Read read2("@name", string(), "+", string());
+        Read* rc = new Read("@name", tail, "+", string(tail.length(), 'I'));
+        read2.mSeq = rc->mSeq.reverseComplement();
+        read2.mQuality = string(tail.length(), 'I');
+        delete rc;
+        if(analyze(&read1, &read2, 5, 30, 0.2).overlapped)
+            continue;
+        Sequence rcr2 = ~read2.mSeq;
+        OverlapResult ov = analyzeGapped(read1.mSeq.mStr.c_str(), 150, rcr2.mStr.c_str(), rcr2.length(), 5, 30, 0.2, &buffer);
+        if(!ov.overlapped || ov.offset != insert - 150 || ov.diff != indel || ov.overlap_len2 - ov.overlap_len != (n % 2 == 0 ? indel : -indel))
+            return false;
+        // the bases on both sides of the indel are the same
+        if(ov.gap_pos < 0)
+            return false;
+        int delta = ov.overlap_len2 - ov.overlap_len;
+        for(int i=0; i<ov.overlap_len; i++) {
+            if(i >= ov.gap_pos && i < ov.gap_pos - delta)
+                continue;
+            int j = i < ov.gap_pos ? i : i + delta;
+            if(read1.mSeq.mStr[ov.offset + i] != rcr2.mStr[j])
+                return false;
+        }
+        Read* mergedRead = merge(&read1, &read2, ov);
+        bool same = mergedRead->mSeq.mStr == fragment;
+        delete mergedRead;
+        if(!same)
+            return false;
+        merged++;
+    }
+    if(merged < 500)
+        return false;
+
+    // the pairs of different fragments are not merged
+    for(int n=0; n<1000; n++) {
+        string str1(150, 'A');
+        string str2(150, 'A');
+        for(int i=0; i<150; i++) {
+            seed = seed * 1103515245 + 12345;
+            str1[i] = bases[(seed >> 16) % 4];
+            str2[i] = bases[(seed >> 20) % 4];
+        }
+        if(analyzeGapped(str1.c_str(), 150, str2.c_str(), 150, 5, 30, 0.2, &buffer).overlapped)
+            return false;
+    }
+    return true;
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <string>
 #include <vector>
+#include <atomic>
 #include "common.h"
 #include "options.h"
 #include "read.h"
@@ -17,7 +18,27 @@ public:
     bool overlapped;
     int offset;
     int overlap_len;
+    // the overlapped bases of read2, which are different from overlap_len if the overlap has indels
+    int overlap_len2;
     int diff;
+    // the bases of read1 in the overlap before the indel of a gapped overlap, which has overlap_len2 - overlap_len bases inserted to read2 there
+    // (or deleted if negative). -1 if the overlap has no indel, and -2 if its indels are not at a single position
+    int gap_pos;
+};
+
+// the buffers of OverlapAnalysis::analyzeGapped() kept for the next pairs, one for each thread
+class OverlapGapBuffer{
+public:
+    OverlapGapBuffer();
+
+public:
+    // the last position of each 6-mer of str2, with the stamp of the pair in the high 16 bits, so it's only cleared when the stamp wraps
+    unsigned int mPositions[4096];
+    unsigned int mStamp;
+    // the votes of the offsets
+    vector<int> mVotes;
+    // str1 with the guard bytes read by the band kernels
+    string mPadded;
 };
 
 class OverlapAnalysis{
@@ -27,6 +48,13 @@ public:
 
     static OverlapResult analyze(Sequence&  r1, Sequence&  r2, int diffLimit, int overlapRequire, double diffPercentLimit);
     static OverlapResult analyze(Read* r1, Read* r2, int diffLimit, int overlapRequire, double diffPercentLimit);
+    // str2 is the reverse complement of read2, the probes are the offsets tried before the others
+    static OverlapResult analyze(const char* str1, int len1, const char* str2, int len2, int diffLimit, int overlapRequire, double diffPercentLimit,
+                                 const int* probes = NULL, int probeCount = 0);
+    // the gapped overlap of read2 moved right (offset > 0), which allows indels but no more than the allowed differences
+    // (mismatches and indel bases) in the whole overlap. it's used for merging and correction when no ungapped overlap is found
+    static OverlapResult analyzeGapped(const char* str1, int len1, const char* str2, int len2, int diffLimit, int overlapRequire, double diffPercentLimit,
+                                       OverlapGapBuffer* buffer);
     static Read* merge(Read* r1, Read* r2, OverlapResult ov);
 
 public:
@@ -34,4 +62,78 @@ public:
 
 };
 
+// the number of the most frequent insert sizes tried first
+#define OVERLAP_PRIOR_PROBES 64
+
+// the most frequent insert sizes learned from the insert size histogram, their offsets are tried before scanning all the offsets.
+// it's updated by one thread and read by all, and a reader may get a mix of two updates, which is still a valid list to try
+class OverlapPrior{
+public:
+    OverlapPrior();
+    // the insert sizes of hist[0, size) are ranked by their counts
+    void update(const long* hist, int size);
+    // the offsets of read2 for the likely insert sizes, from the most likely one, returns the count
+    int offsets(int len2, int frontTrimmed1, int frontTrimmed2, int* offsets);
+
+public:
+    static bool test();
+
+private:
+    atomic_int mInsertSizes[OVERLAP_PRIOR_PROBES];
+    atomic_int mCount;
+};
+
+// the overlap of a read pair shared by the adapter trimmer, the base corrector, the insert size stats, the overlapped output and the merger
+// a result is computed again only if the read lengths are changed or invalidate() is called,
+// since the reads are only cropped at the tail after the pair is set
+class OverlapContext{
+public:
+    // the gap buffer is the one of the thread, a new one is used if it's NULL
+    OverlapContext(int diffLimit, int overlapRequire, OverlapPrior* prior = NULL, OverlapGapBuffer* gapBuffer = NULL);
+    ~OverlapContext();
+
+    // a new pair, the buffer of the reverse complement is kept for the next pairs
+    // the front trimmed lengths are only used to find the offsets of the prior
+    void reset(Read* r1, Read* r2, int frontTrimmed1 = 0, int frontTrimmed2 = 0);
+    OverlapResult analyze(double diffPercentLimit);
+    // see OverlapAnalysis::analyzeGapped(), the last result is cached like the ones of analyze()
+    OverlapResult analyzeGapped(double diffPercentLimit);
+    // called if the bases are changed without changing the read lengths, like the base correction
+    void invalidate();
+
+public:
+    static bool test();
+
+private:
+    // the reverse complement of read2 of the length
+    const char* reverse2(int len2);
+
+private:
+    Read* mRead1;
+    Read* mRead2;
+    int mFrontTrimmed1;
+    int mFrontTrimmed2;
+    int mDiffLimit;
+    int mOverlapRequire;
+    OverlapPrior* mPrior;
+    // the reverse complement of read2 when it was mReverseLen long, its tail is the one of a cropped read2
+    string mReverse2;
+    int mReverseLen;
+    bool mReverseValid;
+    // the results of different diffPercentLimit, the overlapped output uses 0
+    OverlapResult mResults[2];
+    double mPercents[2];
+    int mLens1[2];
+    int mLens2[2];
+    bool mValid[2];
+    int mNextSlot;
+    OverlapResult mGappedResult;
+    double mGappedPercent;
+    int mGappedLen1;
+    int mGappedLen2;
+    bool mGappedValid;
+    OverlapGapBuffer* mGapBuffer;
+    bool mOwnGapBuffer;
+};
+
 #endif
\ No newline at end of file
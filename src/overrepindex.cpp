@@ -0,0 +1,119 @@
+#include "overrepindex.h"
+#include <string.h>
+
+OverRepIndex::OverRepIndex(){
+}
+
+uint64_t OverRepIndex::hash(const char* data, int len) {
+    uint64_t h = 0;
+    for(int i=0; i<len; i++)
+        h = h * OVER_REP_HASH_BASE + (unsigned char)data[i];
+    return h;
+}
+
+void OverRepIndex::add(const string& seq, int id) {
+    int len = seq.length();
+    if(len == 0)
+        return;
+
+    if(mTables.count(len) == 0) {
+        uint64_t power = 1;
+        for(int i=0; i<len; i++)
+            power *= OVER_REP_HASH_BASE;
+        mTables[len].power = power;
+    }
+
+    mTables[len].seqs[hash(seq.c_str(), len)].push_back(mSeqs.size());
+    mSeqs.push_back(seq);
+    mIds.push_back(id);
+}
+
+vector<int> OverRepIndex::lengths() {
+    vector<int> result;
+    map<int, Table>::iterator iter;
+    for(iter = mTables.begin(); iter != mTables.end(); iter++)
+        result.push_back(iter->first);
+    return result;
+}
+
+void OverRepIndex::match(const char* data, int dataLen, int len, vector<OverRepHit>& hits, bool overlapping) {
+    hits.clear();
+    if(len <= 0 || dataLen < len)
+        return;
+    map<int, Table>::iterator iter = mTables.find(len);
+    if(iter == mTables.end())
+        return;
+    Table& table = iter->second;
+
+    uint64_t h = hash(data, len);
+    // the first window that can be a hit
+    int next = 0;
+    for(int i=0; i + len <= dataLen; i++) {
+        if(i > 0)
+            h = h * OVER_REP_HASH_BASE + (unsigned char)data[i + len - 1] - (unsigned char)data[i - 1] * table.power;
+        if(i < next)
+            continue;
+
+        unordered_map<uint64_t, vector<int>>::iterator found = table.seqs.find(h);
+        if(found == table.seqs.end())
+            continue;
+        vector<int>& candidates = found->second;
+        for(int c=0; c<candidates.size(); c++) {
+            int s = candidates[c];
+            if(memcmp(data + i, mSeqs[s].c_str(), len) == 0) {
+                OverRepHit hit = {i, mIds[s]};
+                hits.push_back(hit);
+                if(!overlapping)
+                    next = i + len + 1;
+                break;
+            }
+        }
+    }
+}
+
+bool OverRepIndex::test() {
+    OverRepIndex index;
+    index.add("ACGTACGTAA", 0);
+    index.add("TTTTTTTTTT", 1);
+    index.add("CCCCCCCCCCCCCCCCCCCC", 2);
+    index.add("NNNNNNNNNN", 3);
+
+    string data = "GACGTACGTAATTTTTTTTTTTTNNNNNNNNNNCCCCCCCCCCCCCCCCCCCCG";
+    vector<OverRepHit> hits;
+
+    // the window at 11 starts at the base right after the hit at 1, so TTTTTTTTTT is found at 12
+    index.match(data.c_str(), data.length(), 10, hits);
+    if(hits.size() != 3)
+        return false;
+    if(hits[0].pos != 1 || hits[0].id != 0)
+        return false;
+    if(hits[1].pos != 12 || hits[1].id != 1)
+        return false;
+    if(hits[2].pos != 23 || hits[2].id != 3)
+        return false;
+
+    index.match(data.c_str(), data.length(), 20, hits);
+    if(hits.size() != 1 || hits[0].pos != 33 || hits[0].id != 2)
+        return false;
+
+    // the window of the last bases is not in data
+    index.match(data.c_str(), data.length() - 1, 20, hits);
+    if(hits.size() != 1)
+        return false;
+    index.match(data.c_str(), data.length() - 2, 20, hits);
+    if(hits.size() != 0)
+        return false;
+
+    index.match(data.c_str(), data.length(), 40, hits);
+    if(!hits.empty())
+        return false;
+
+    // all the three TTTTTTTTTT in the 12 Ts are found if overlapping is allowed
+    index.match(data.c_str(), data.length(), 10, hits, true);
+    int polyT = 0;
+    for(int h=0; h<hits.size(); h++) {
+        if(hits[h].id == 1)
+            polyT++;
+    }
+    return hits.size() == 5 && polyT == 3;
+}
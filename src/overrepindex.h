@@ -0,0 +1,56 @@
+#ifndef OVER_REP_INDEX_H
+#define OVER_REP_INDEX_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+
+using namespace std;
+
+// an odd base, so the rolling hash doesn't lose the high bits
+#define OVER_REP_HASH_BASE 0x100000001b3ULL
+
+// a hit of a hot sequence in a read, id is the one given when the sequence is added
+struct OverRepHit {
+    int pos;
+    int id;
+};
+
+// the hot sequences of overrepresentation analysis, indexed by their rolling hash
+// the sequences of each length have a hash table, so a read is scanned for a length in one linear pass
+// instead of looking up every substring
+class OverRepIndex{
+public:
+    OverRepIndex();
+
+    void add(const string& seq, int id);
+    bool empty() {return mSeqs.empty();}
+
+    // find the hot sequences of length len in data[0, dataLen)
+    // the windows are checked from left to right, and a window is skipped if it overlaps the last hit
+    // or the base right after the last hit, so the hits of a same length don't overlap
+    // if overlapping is true, no window is skipped, so all the occurrences are found
+    void match(const char* data, int dataLen, int len, vector<OverRepHit>& hits, bool overlapping = false);
+    // the lengths of the added sequences
+    vector<int> lengths();
+
+    // polynomial hash of the bytes, it can be rolled by one base in constant time
+    static uint64_t hash(const char* data, int len);
+    static bool test();
+
+private:
+    struct Table {
+        // OVER_REP_HASH_BASE ^ len, to remove the leftmost base when rolling
+        uint64_t power;
+        unordered_map<uint64_t, vector<int>> seqs;
+    };
+    map<int, Table> mTables;
+    vector<string> mSeqs;
+    vector<int> mIds;
+};
+
+#endif
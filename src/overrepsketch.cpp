@@ -0,0 +1,405 @@
+#include "overrepsketch.h"
+#include "overrepindex.h"
+#include <string.h>
+#include <algorithm>
+
+OverRepSketch::OverRepSketch(int seqLen, int distLen, int capacity){
+    mSeqLen = seqLen;
+    mDistLen = distLen;
+    mCapacity = capacity;
+    mReads = 0;
+    mPower = 1;
+    for(int i=0; i<mSeqLen; i++)
+        mPower *= OVER_REP_HASH_BASE;
+    mFilter = new uint32_t[1 << OVER_REP_FILTER_BITS];
+    memset(mFilter, 0, sizeof(uint32_t) * (1 << OVER_REP_FILTER_BITS));
+    allocate();
+}
+
+OverRepSketch::~OverRepSketch() {
+    release();
+    delete[] mFilter;
+}
+
+void OverRepSketch::allocate() {
+    mSize = 0;
+    mSeqs = new char[mCapacity * mSeqLen];
+    mHashes = new uint64_t[mCapacity];
+    mCounts = new long[mCapacity];
+    mErrors = new long[mCapacity];
+    mSparseStarts = new OverRepStart[mCapacity * OVER_REP_SPARSE_STARTS];
+    mSparseNum = new int[mCapacity]();
+    mStartRows = new uint32_t*[mCapacity]();
+    mLastRead = new long[mCapacity];
+    mNextStart = new int[mCapacity];
+    mHeap = new int[mCapacity];
+    mHeapPos = new int[mCapacity];
+    mSlotOfHash.clear();
+    mSlotOfHash.reserve(mCapacity * 2);
+}
+
+void OverRepSketch::release() {
+    delete[] mSeqs;
+    delete[] mHashes;
+    delete[] mCounts;
+    delete[] mErrors;
+    for(int s=0; s<mCapacity; s++)
+        delete[] mStartRows[s];
+    delete[] mSparseStarts;
+    delete[] mSparseNum;
+    delete[] mStartRows;
+    delete[] mLastRead;
+    delete[] mNextStart;
+    delete[] mHeap;
+    delete[] mHeapPos;
+}
+
+void OverRepSketch::addStart(int slot, int pos, uint32_t count) {
+    uint32_t* row = mStartRows[slot];
+    if(row) {
+        row[pos] += count;
+        return;
+    }
+    OverRepStart* sparse = mSparseStarts + slot * OVER_REP_SPARSE_STARTS;
+    int num = mSparseNum[slot];
+    for(int k=0; k<num; k++) {
+        if(sparse[k].pos == pos) {
+            sparse[k].count += count;
+            return;
+        }
+    }
+    if(num < OVER_REP_SPARSE_STARTS) {
+        sparse[num].pos = pos;
+        sparse[num].count = count;
+        mSparseNum[slot]++;
+        return;
+    }
+    // too many positions, the slot gets a full row
+    row = new uint32_t[mDistLen]();
+    for(int k=0; k<num; k++)
+        row[sparse[k].pos] += sparse[k].count;
+    row[pos] += count;
+    mStartRows[slot] = row;
+}
+
+void OverRepSketch::clearStarts(int slot) {
+    delete[] mStartRows[slot];
+    mStartRows[slot] = NULL;
+    mSparseNum[slot] = 0;
+}
+
+void OverRepSketch::getStarts(int slot, uint32_t* starts) {
+    if(mStartRows[slot]) {
+        memcpy(starts, mStartRows[slot], sizeof(uint32_t) * mDistLen);
+        return;
+    }
+    memset(starts, 0, sizeof(uint32_t) * mDistLen);
+    OverRepStart* sparse = mSparseStarts + slot * OVER_REP_SPARSE_STARTS;
+    for(int k=0; k<mSparseNum[slot]; k++)
+        starts[sparse[k].pos] += sparse[k].count;
+}
+
+void OverRepSketch::swapHeap(int a, int b) {
+    int slotA = mHeap[a];
+    int slotB = mHeap[b];
+    mHeap[a] = slotB;
+    mHeap[b] = slotA;
+    mHeapPos[slotB] = a;
+    mHeapPos[slotA] = b;
+}
+
+void OverRepSketch::siftUp(int heapPos) {
+    while(heapPos > 0) {
+        int parent = (heapPos - 1) / 2;
+        if(mCounts[mHeap[parent]] <= mCounts[mHeap[heapPos]])
+            break;
+        swapHeap(parent, heapPos);
+        heapPos = parent;
+    }
+}
+
+void OverRepSketch::siftDown(int heapPos) {
+    while(true) {
+        int smallest = heapPos;
+        int left = heapPos * 2 + 1;
+        int right = left + 1;
+        if(left < mSize && mCounts[mHeap[left]] < mCounts[mHeap[smallest]])
+            smallest = left;
+        if(right < mSize && mCounts[mHeap[right]] < mCounts[mHeap[smallest]])
+            smallest = right;
+        if(smallest == heapPos)
+            break;
+        swapHeap(smallest, heapPos);
+        heapPos = smallest;
+    }
+}
+
+bool OverRepSketch::seenRecently(uint64_t hash) {
+    uint32_t& seen = mFilter[hash & ((1 << OVER_REP_FILTER_BITS) - 1)];
+    uint32_t fingerprint = hash >> 32;
+    if(seen == fingerprint)
+        return true;
+    seen = fingerprint;
+    return false;
+}
+
+void OverRepSketch::add(const char* data, int dataLen) {
+    mReads++;
+    if(mSeqLen <= 0 || dataLen < mSeqLen)
+        return;
+
+    uint64_t h = OverRepIndex::hash(data, mSeqLen);
+    for(int i=0; i + mSeqLen <= dataLen; i++) {
+        if(i > 0)
+            h = h * OVER_REP_HASH_BASE + (unsigned char)data[i + mSeqLen - 1] - (unsigned char)data[i - 1] * mPower;
+
+        int slot;
+        unordered_map<uint64_t, int>::iterator found = mSlotOfHash.find(h);
+        if(found != mSlotOfHash.end()) {
+            slot = found->second;
+            // a hash collision, it's so rare that the window is just skipped
+            if(memcmp(mSeqs + slot * mSeqLen, data + i, mSeqLen) != 0)
+                continue;
+            if(mLastRead[slot] == mReads && i < mNextStart[slot])
+                continue;
+            mCounts[slot]++;
+            siftDown(mHeapPos[slot]);
+        } else if(!seenRecently(h)) {
+            continue;
+        } else if(!isFull()) {
+            slot = mSize;
+            mSize++;
+            memcpy(mSeqs + slot * mSeqLen, data + i, mSeqLen);
+            mHashes[slot] = h;
+            // it has been seen once before
+            mCounts[slot] = 2;
+            mErrors[slot] = 0;
+            mHeap[slot] = slot;
+            mHeapPos[slot] = slot;
+            mSlotOfHash[h] = slot;
+            siftUp(slot);
+        } else {
+            // replace the least counted sequence
+            slot = mHeap[0];
+            mSlotOfHash.erase(mHashes[slot]);
+            memcpy(mSeqs + slot * mSeqLen, data + i, mSeqLen);
+            mHashes[slot] = h;
+            mErrors[slot] = mCounts[slot];
+            mCounts[slot] += 2;
+            clearStarts(slot);
+            mSlotOfHash[h] = slot;
+            siftDown(0);
+        }
+
+        if(i < mDistLen)
+            addStart(slot, i, 1);
+        mLastRead[slot] = mReads;
+        mNextStart[slot] = i + mSeqLen + 1;
+    }
+}
+
+void OverRepSketch::merge(OverRepSketch* other) {
+    // a sequence missing in a full sketch can have a count up to the min count of that sketch
+    long minThis = minCount();
+    long minOther = other->minCount();
+
+    struct Item {
+        long count;
+        long error;
+        int slotThis;
+        int slotOther;
+    };
+    vector<Item> items;
+    vector<bool> otherMatched(other->mSize, false);
+    for(int s=0; s<mSize; s++) {
+        Item item = {mCounts[s] + minOther, mErrors[s] + minOther, s, -1};
+        unordered_map<uint64_t, int>::iterator found = other->mSlotOfHash.find(mHashes[s]);
+        if(found != other->mSlotOfHash.end() && memcmp(mSeqs + s * mSeqLen, other->mSeqs + found->second * mSeqLen, mSeqLen) == 0) {
+            int o = found->second;
+            item.count = mCounts[s] + other->mCounts[o];
+            item.error = mErrors[s] + other->mErrors[o];
+            item.slotOther = o;
+            otherMatched[o] = true;
+        }
+        items.push_back(item);
+    }
+    for(int o=0; o<other->mSize; o++) {
+        if(otherMatched[o])
+            continue;
+        Item item = {other->mCounts[o] + minThis, other->mErrors[o] + minThis, -1, o};
+        items.push_back(item);
+    }
+
+    // keep the most counted ones
+    sort(items.begin(), items.end(), [](const Item& a, const Item& b) {return a.count > b.count;});
+    if(items.size() > mCapacity)
+        items.resize(mCapacity);
+
+    char* oldSeqs = mSeqs;
+    uint64_t* oldHashes = mHashes;
+    OverRepStart* oldSparseStarts = mSparseStarts;
+    int* oldSparseNum = mSparseNum;
+    uint32_t** oldStartRows = mStartRows;
+    delete[] mCounts;
+    delete[] mErrors;
+    delete[] mHeap;
+    delete[] mHeapPos;
+    allocate();
+
+    for(int i=0; i<items.size(); i++) {
+        Item& item = items[i];
+        int slot = mSize;
+        mSize++;
+        if(item.slotThis >= 0) {
+            memcpy(mSeqs + slot * mSeqLen, oldSeqs + item.slotThis * mSeqLen, mSeqLen);
+            mHashes[slot] = oldHashes[item.slotThis];
+            // the full row is moved to the new slot
+            mStartRows[slot] = oldStartRows[item.slotThis];
+            oldStartRows[item.slotThis] = NULL;
+            if(!mStartRows[slot]) {
+                memcpy(mSparseStarts + slot * OVER_REP_SPARSE_STARTS, oldSparseStarts + item.slotThis * OVER_REP_SPARSE_STARTS, sizeof(OverRepStart) * OVER_REP_SPARSE_STARTS);
+                mSparseNum[slot] = oldSparseNum[item.slotThis];
+            }
+        } else {
+            memcpy(mSeqs + slot * mSeqLen, other->mSeqs + item.slotOther * mSeqLen, mSeqLen);
+            mHashes[slot] = other->mHashes[item.slotOther];
+        }
+        if(item.slotOther >= 0) {
+            int o = item.slotOther;
+            if(other->mStartRows[o]) {
+                for(int p=0; p<mDistLen; p++) {
+                    if(other->mStartRows[o][p])
+                        addStart(slot, p, other->mStartRows[o][p]);
+                }
+            } else {
+                OverRepStart* sparse = other->mSparseStarts + o * OVER_REP_SPARSE_STARTS;
+                for(int k=0; k<other->mSparseNum[o]; k++)
+                    addStart(slot, sparse[k].pos, sparse[k].count);
+            }
+        }
+        mCounts[slot] = item.count;
+        mErrors[slot] = item.error;
+        mLastRead[slot] = -1;
+        mHeap[slot] = slot;
+        mHeapPos[slot] = slot;
+        mSlotOfHash[mHashes[slot]] = slot;
+    }
+    for(int i=mSize/2 - 1; i>=0; i--)
+        siftDown(i);
+
+    delete[] oldSeqs;
+    delete[] oldHashes;
+    for(int s=0; s<mCapacity; s++)
+        delete[] oldStartRows[s];
+    delete[] oldSparseStarts;
+    delete[] oldSparseNum;
+    delete[] oldStartRows;
+}
+
+string OverRepSketch::getSeq(int i) {
+    return string(mSeqs + i * mSeqLen, mSeqLen);
+}
+
+long OverRepSketch::getCount(int i) {
+    return mCounts[i] - mErrors[i];
+}
+
+void OverRepSketch::getDist(int i, long* dist) {
+    // a position is covered by the occurrences starting in (p - seqLen, p]
+    vector<uint32_t> starts(mDistLen);
+    getStarts(i, starts.data());
+    long covered = 0;
+    for(int p=0; p<mDistLen; p++) {
+        covered += starts[p];
+        if(p >= mSeqLen)
+            covered -= starts[p - mSeqLen];
+        dist[p] = covered;
+    }
+}
+
+bool OverRepSketch::test() {
+    OverRepSketch sketch(4, 10, 32);
+    // ACGT is in every read, GACG is in two reads, and the other windows are seen only once so they are not tracked
+    sketch.add("ACGTTTCA", 8);
+    sketch.add("GACGTCCC", 8);
+    sketch.add("GGACGTAA", 8);
+    sketch.add("ACGTGGGG", 8);
+
+    int acgt = -1;
+    for(int i=0; i<sketch.size(); i++) {
+        if(sketch.getSeq(i) == "ACGT")
+            acgt = i;
+    }
+    if(sketch.size() != 2 || acgt < 0 || sketch.getCount(acgt) != 4)
+        return false;
+
+    // the first occurrence is counted but not in the distribution
+    long dist[10];
+    sketch.getDist(acgt, dist);
+    long expectedDist[10] = {1, 2, 3, 3, 2, 1, 0, 0, 0, 0};
+    for(int p=0; p<10; p++) {
+        if(dist[p] != expectedDist[p])
+            return false;
+    }
+
+    // the merged sketch has the exact count of ACGT
+    OverRepSketch other(4, 10, 32);
+    other.add("TTACGTTT", 8);
+    other.add("CCACGTCC", 8);
+    sketch.merge(&other);
+    bool merged = false;
+    for(int i=0; i<sketch.size(); i++) {
+        if(sketch.getSeq(i) == "ACGT")
+            merged = sketch.getCount(i) == 6;
+    }
+    if(!merged || sketch.size() != 2)
+        return false;
+
+    // ACGT starts at more positions than the sparse pairs of a slot, and the full row is merged with the sparse pairs
+    OverRepSketch wide(4, 30, 32);
+    OverRepSketch wideOther(4, 30, 32);
+    long starts[30] = {0};
+    for(int p=0; p<12; p++) {
+        string read(30, 'T');
+        read.replace(p * 2, 4, "ACGT");
+        wide.add(read.c_str(), 30);
+        if(p > 0)
+            starts[p * 2]++;
+    }
+    for(int p=5; p>0; p-=2) {
+        string read(30, 'T');
+        read.replace(p, 4, "ACGT");
+        wideOther.add(read.c_str(), 30);
+        if(p < 5)
+            starts[p]++;
+    }
+    wide.merge(&wideOther);
+    bool found = false;
+    for(int i=0; i<wide.size(); i++) {
+        if(wide.getSeq(i) != "ACGT")
+            continue;
+        found = true;
+        long wideDist[30];
+        wide.getDist(i, wideDist);
+        long covered = 0;
+        for(int p=0; p<30; p++) {
+            covered += starts[p] - (p >= 4 ? starts[p - 4] : 0);
+            if(wideDist[p] != covered)
+                return false;
+        }
+    }
+    if(!found)
+        return false;
+
+    // the windows of the other read keep replacing each other, but GGGG is never replaced
+    OverRepSketch small(4, 10, 2);
+    for(int i=0; i<10; i++)
+        small.add("GGGG", 4);
+    small.add("ACGTTGCA", 8);
+    small.add("ACGTTGCA", 8);
+    for(int i=0; i<small.size(); i++) {
+        if(small.getSeq(i) == "GGGG")
+            return small.getCount(i) == 10;
+    }
+    return false;
+}
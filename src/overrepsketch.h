@@ -0,0 +1,99 @@
+#ifndef OVER_REP_SKETCH_H
+#define OVER_REP_SKETCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+using namespace std;
+
+#define OVER_REP_SKETCH_CAPACITY 1024
+#define OVER_REP_FILTER_BITS 14
+// the starts of a slot are kept as (position, count) pairs until it has more positions than this
+#define OVER_REP_SPARSE_STARTS 8
+
+struct OverRepStart {
+    int pos;
+    uint32_t count;
+};
+
+// a SpaceSaving summary of all the sequences of one length, to find the overrepresented ones in one pass
+// at most capacity sequences are tracked, a new sequence replaces the least counted one and inherits its count as error
+// so the count minus error is a lower bound of the real count, and a sequence taking more than 1/capacity
+// of all the windows is always tracked
+// the sketches of different threads can be merged, so each thread keeps its own sketch without locking
+class OverRepSketch{
+public:
+    // distLen is the number of cycles for the position distribution
+    OverRepSketch(int seqLen, int distLen, int capacity = OVER_REP_SKETCH_CAPACITY);
+    ~OverRepSketch();
+
+    // count the windows of length seqLen in data, like a sequence found at i, its next occurrence
+    // is only counted from i + seqLen + 1
+    void add(const char* data, int dataLen);
+    // merge the sketch of another thread, which should have the same seqLen and distLen
+    void merge(OverRepSketch* other);
+
+    int seqLen() {return mSeqLen;}
+    int size() {return mSize;}
+    string getSeq(int i);
+    // the lower bound of the count of the i-th sequence
+    long getCount(int i);
+    // the coverage of the i-th sequence over cycles, dist should have distLen elements
+    void getDist(int i, long* dist);
+
+    static bool test();
+
+private:
+    bool seenRecently(uint64_t hash);
+    void siftUp(int heapPos);
+    void siftDown(int heapPos);
+    void swapHeap(int a, int b);
+    bool isFull() {return mSize >= mCapacity;}
+    long minCount() {return isFull() ? mCounts[mHeap[0]] : 0;}
+    void allocate();
+    void release();
+    void addStart(int slot, int pos, uint32_t count);
+    void clearStarts(int slot);
+    // the starts of a slot over the cycles, starts should have distLen elements
+    void getStarts(int slot, uint32_t* starts);
+
+private:
+    int mSeqLen;
+    int mDistLen;
+    int mCapacity;
+    int mSize;
+    // OVER_REP_HASH_BASE ^ seqLen, to remove the leftmost base when rolling
+    uint64_t mPower;
+
+    // the data of slot s are mSeqs[s * mSeqLen], mCounts[s], mErrors[s]...
+    char* mSeqs;
+    uint64_t* mHashes;
+    long* mCounts;
+    long* mErrors;
+    // the number of occurrences starting at each cycle, most slots only have a few positions, so they are kept
+    // in mSparseStarts (OVER_REP_SPARSE_STARTS for each slot), and a slot with more positions gets a row of mDistLen
+    OverRepStart* mSparseStarts;
+    int* mSparseNum;
+    uint32_t** mStartRows;
+    // the read and the position where the next occurrence can start, the overlapping ones are not counted
+    long* mLastRead;
+    int* mNextStart;
+    // the number of reads added
+    long mReads;
+
+    // a min-heap of the slots by count, and the position of each slot in it
+    int* mHeap;
+    int* mHeapPos;
+    unordered_map<uint64_t, int> mSlotOfHash;
+
+    // the recently seen windows, indexed by the low bits of hash, storing the high bits
+    // a window is tracked only if it's seen again before being overwritten, so the unique windows don't
+    // keep replacing the tracked sequences
+    uint32_t* mFilter;
+};
+
+#endif
@@ -0,0 +1,152 @@
+#include "partitionwriter.h"
+#include "util.h"
+#include <functional>
+
+PartitionWriter::PartitionWriter(Options* opt, bool paired){
+    mOptions = opt;
+    mNumber = opt->partition.number;
+    mPaired = paired;
+    mClosed = false;
+    // a pack is distributed to all partitions, so each buffer only holds a part of it
+    mBufferPool = new BufferPool(WriterThread::getBufferReserve(opt) / mNumber, OUTPUT_BUFFER_POOL_LIMIT * 2);
+
+    for(int i=0; i<mNumber; i++) {
+        WriterThread* writer1 = new WriterThread(mOptions, prefix_number(mOptions->out1, i, mOptions->split.digits), mBufferPool);
+        mWriters1.push_back(writer1);
+        mThreads.push_back(new std::thread(std::bind(&PartitionWriter::writeTask, this, writer1)));
+        if(mPaired) {
+            WriterThread* writer2 = new WriterThread(mOptions, prefix_number(mOptions->out2, i, mOptions->split.digits), mBufferPool);
+            mWriters2.push_back(writer2);
+            mThreads.push_back(new std::thread(std::bind(&PartitionWriter::writeTask, this, writer2)));
+        }
+    }
+}
+
+PartitionWriter::~PartitionWriter() {
+    close();
+    for(int i=0; i<mThreads.size(); i++)
+        delete mThreads[i];
+    for(int i=0; i<mWriters1.size(); i++)
+        delete mWriters1[i];
+    for(int i=0; i<mWriters2.size(); i++)
+        delete mWriters2[i];
+    delete mBufferPool;
+}
+
+int PartitionWriter::getPartition(const string& name, int number) {
+    // the name ends at the first space or tab, the comments are not included
+    int len = 0;
+    while(len < name.length() && name[len] != ' ' && name[len] != '\t')
+        len++;
+    // remove the /1 /2 suffix of the old Illumina read names
+    if(len >= 2 && name[len-2] == '/' && (name[len-1] == '1' || name[len-1] == '2'))
+        len -= 2;
+
+    // FNV-1a hash, it's stable across platforms and runs
+    uint64_t hash = 14695981039346656037ULL;
+    for(int i=0; i<len; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 1099511628211ULL;
+    }
+    // the low bits of FNV are not well mixed, which makes the partitions unbalanced for similar names
+    // so mix it with the finalizer of MurmurHash3
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash % number;
+}
+
+string* PartitionWriter::getBuffer(vector<string*>& buffers, int partition) {
+    if(buffers.size() < mNumber)
+        buffers.resize(mNumber, NULL);
+    if(buffers[partition] == NULL)
+        buffers[partition] = mBufferPool->get();
+    return buffers[partition];
+}
+
+void PartitionWriter::input(vector<string*>& buffers1) {
+    input(buffers1, mWriters1);
+}
+
+void PartitionWriter::input(vector<string*>& buffers1, vector<string*>& buffers2) {
+    input(buffers1, mWriters1);
+    input(buffers2, mWriters2);
+}
+
+void PartitionWriter::input(vector<string*>& buffers, vector<WriterThread*>& writers) {
+    for(int i=0; i<buffers.size(); i++) {
+        if(buffers[i] == NULL)
+            continue;
+        // no writer if it's PE data but only --out1 is specified
+        if(buffers[i]->empty() || writers.empty())
+            mBufferPool->recycle(buffers[i]);
+        else
+            writers[i]->input(buffers[i]);
+    }
+    buffers.clear();
+}
+
+long PartitionWriter::bufferLength() {
+    long len = 0;
+    for(int i=0; i<mWriters1.size(); i++)
+        len = max(len, mWriters1[i]->bufferLength());
+    for(int i=0; i<mWriters2.size(); i++)
+        len = max(len, mWriters2[i]->bufferLength());
+    return len;
+}
+
+void PartitionWriter::close() {
+    if(mClosed)
+        return;
+    mClosed = true;
+
+    for(int i=0; i<mWriters1.size(); i++)
+        mWriters1[i]->setInputCompleted();
+    for(int i=0; i<mWriters2.size(); i++)
+        mWriters2[i]->setInputCompleted();
+    for(int i=0; i<mThreads.size(); i++)
+        mThreads[i]->join();
+}
+
+void PartitionWriter::writeTask(WriterThread* writer) {
+    while(true) {
+        if(writer->isCompleted()){
+            // last check for possible threading related issue
+            writer->output();
+            break;
+        }
+        writer->output();
+    }
+
+    if(mOptions->verbose) {
+        string msg = writer->getFilename() + " writer finished";
+        loginfo(msg);
+    }
+}
+
+bool PartitionWriter::test() {
+    // the reads of a pair are in a same partition
+    if(getPartition("@NB551106:9:H5Y5GBGX2:1:22306:18653:13119 1:N:0:GATCAG", 16)
+        != getPartition("@NB551106:9:H5Y5GBGX2:1:22306:18653:13119 2:N:0:GATCAG", 16))
+        return false;
+    if(getPartition("@SRR1234.1/1", 16) != getPartition("@SRR1234.1/2", 16))
+        return false;
+    if(getPartition("@SRR1234.1/1", 16) != getPartition("@SRR1234.1", 16))
+        return false;
+
+    // the reads are distributed to all partitions
+    int counts[4] = {0};
+    for(int i=0; i<4000; i++) {
+        int p = getPartition("@NB500713:64:HFKJJBGXY:1:11102:10000:" + to_string(10000 + i) + " 1:N:0", 4);
+        if(p < 0 || p >= 4)
+            return false;
+        counts[p]++;
+    }
+    for(int p=0; p<4; p++) {
+        if(counts[p] < 800 || counts[p] > 1200)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,56 @@
+#ifndef PARTITION_WRITER_H
+#define PARTITION_WRITER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include "options.h"
+#include "writerthread.h"
+#include "bufferpool.h"
+
+using namespace std;
+
+// write the output to N partitions by the hash of read name
+// so the reads of a same name always go to a same partition, and the pairs are kept together
+// each partition has its own writer thread, so the partitions are compressed in parallel
+class PartitionWriter{
+public:
+    PartitionWriter(Options* opt, bool paired = false);
+    ~PartitionWriter();
+
+    // the partition of a read, computed from its name without the comments and the /1 /2 suffix
+    static int getPartition(const string& name, int number);
+
+    // get the buffer of the partition in buffers, a new one is obtained from the pool if it's not there
+    string* getBuffer(vector<string*>& buffers, int partition);
+
+    // hand over all the buffers to the writers of their partitions, and clear buffers
+    // this function is not thread-safe, the callers should make sure only one thread calls it at a time
+    void input(vector<string*>& buffers1);
+    void input(vector<string*>& buffers1, vector<string*>& buffers2);
+
+    // the number of buffers that have not been written yet
+    long bufferLength();
+    // finish writing all partitions
+    void close();
+
+    static bool test();
+
+private:
+    void input(vector<string*>& buffers, vector<WriterThread*>& writers);
+    void writeTask(WriterThread* writer);
+
+private:
+    Options* mOptions;
+    int mNumber;
+    bool mPaired;
+    bool mClosed;
+    BufferPool* mBufferPool;
+    vector<WriterThread*> mWriters1;
+    vector<WriterThread*> mWriters2;
+    vector<std::thread*> mThreads;
+};
+
+#endif
@@ -24,10 +24,11 @@ PairEndProcessor::PairEndProcessor(Options* opt){
     mUmiProcessor = new UmiProcessor(opt);
 
     int isizeBufLen = mOptions->insertSizeMax + 1;
-    mInsertSizeHist = new atomic_long[isizeBufLen];
-    memset(mInsertSizeHist, 0, sizeof(atomic_long)*isizeBufLen);
+    mInsertSizeHist = new long[isizeBufLen]();
     mLeftWriter =  NULL;
     mRightWriter = NULL;
+    mSplitWriter = NULL;
+    mPartitionWriter = NULL;
     mUnpairedLeftWriter =  NULL;
     mUnpairedRightWriter = NULL;
     mMergedWriter = NULL;
@@ -35,17 +36,46 @@ PairEndProcessor::PairEndProcessor(Options* opt){
     mOverlappedWriter = NULL;
 
     mDuplicate = NULL;
-    if(mOptions->duplicate.enabled) {
+    if(mOptions->duplicate.enabled && !mOptions->duplicate.sketch) {
         mDuplicate = new Duplicate(mOptions);
     }
+
+    mDedupSet = NULL;
+    if(mOptions->dedup.enabled) {
+        mDedupSet = new DedupSet(mOptions->dedup.memory);
+    }
+
+    // the adapters of the FASTA file are indexed once for all the reads
+    mAdapterIndex = NULL;
+    if(mOptions->adapter.hasFasta) {
+        mAdapterIndex = new AdapterIndex(mOptions->adapter.seqsInFasta);
+    }
+
+    // the likely insert sizes are learned from the insert size histogram
+    mOverlapPrior = NULL;
+    if(mOptions->overlapPrior) {
+        mOverlapPrior = new OverlapPrior();
+    }
 }
 
 PairEndProcessor::~PairEndProcessor() {
-    delete mInsertSizeHist;
+    delete[] mInsertSizeHist;
     if(mDuplicate) {
         delete mDuplicate;
         mDuplicate = NULL;
     }
+    if(mDedupSet) {
+        delete mDedupSet;
+        mDedupSet = NULL;
+    }
+    if(mAdapterIndex) {
+        delete mAdapterIndex;
+        mAdapterIndex = NULL;
+    }
+    if(mOverlapPrior) {
+        delete mOverlapPrior;
+        mOverlapPrior = NULL;
+    }
 }
 
 void PairEndProcessor::initOutput() {
@@ -66,8 +96,27 @@ void PairEndProcessor::initOutput() {
     if(!mOptions->overlappedOut.empty())
         mOverlappedWriter = new WriterThread(mOptions, mOptions->overlappedOut);
 
+    // STDOUT or shared memory is written by a writer thread like files, so the workers don't block on it
+    // it's the merged reads in merging mode, otherwise the interleaved pairs
+    if(mOptions->outputToStream()) {
+        if(mOptions->merge.enabled)
+            mMergedWriter = new WriterThread(mOptions, mOptions->getStreamOutput());
+        else
+            mLeftWriter = new WriterThread(mOptions, mOptions->getStreamOutput());
+    }
+
     if(mOptions->out1.empty())
         return;
+
+    if(mOptions->split.enabled) {
+        mSplitWriter = new SplitWriter(mOptions, !mOptions->out2.empty());
+        return;
+    }
+
+    if(mOptions->partition.enabled) {
+        mPartitionWriter = new PartitionWriter(mOptions, !mOptions->out2.empty());
+        return;
+    }
     
     mLeftWriter = new WriterThread(mOptions, mOptions->out1);
     if(!mOptions->out2.empty())
@@ -83,6 +132,14 @@ void PairEndProcessor::closeOutput() {
         delete mRightWriter;
         mRightWriter = NULL;
     }
+    if(mSplitWriter) {
+        delete mSplitWriter;
+        mSplitWriter = NULL;
+    }
+    if(mPartitionWriter) {
+        delete mPartitionWriter;
+        mPartitionWriter = NULL;
+    }
     if(mMergedWriter) {
         delete mMergedWriter;
         mMergedWriter = NULL;
@@ -105,18 +162,9 @@ void PairEndProcessor::closeOutput() {
     }
 }
 
-void PairEndProcessor::initConfig(ThreadConfig* config) {
-    if(mOptions->out1.empty())
-        return;
-    if(mOptions->split.enabled) {
-        config->initWriterForSplit();
-    }
-}
-
 
 bool PairEndProcessor::process(){
-    if(!mOptions->split.enabled)
-        initOutput();
+    initOutput();
 
     initPackRepository();
     std::thread producer(std::bind(&PairEndProcessor::producerTask, this));
@@ -126,7 +174,6 @@ bool PairEndProcessor::process(){
     ThreadConfig** configs = new ThreadConfig*[mOptions->thread];
     for(int t=0; t<mOptions->thread; t++){
         configs[t] = new ThreadConfig(mOptions, t, true);
-        initConfig(configs[t]);
     }
 
     std::thread** threads = new thread*[mOptions->thread];
@@ -161,22 +208,25 @@ bool PairEndProcessor::process(){
         threads[t]->join();
     }
 
-    if(!mOptions->split.enabled) {
-        if(leftWriterThread)
-            leftWriterThread->join();
-        if(rightWriterThread)
-            rightWriterThread->join();
-        if(unpairedLeftWriterThread)
-            unpairedLeftWriterThread->join();
-        if(unpairedRightWriterThread)
-            unpairedRightWriterThread->join();
-        if(mergedWriterThread)
-            mergedWriterThread->join();
-        if(failedWriterThread)
-            failedWriterThread->join();
-        if(overlappedWriterThread)
-            overlappedWriterThread->join();
-    }
+    if(leftWriterThread)
+        leftWriterThread->join();
+    if(rightWriterThread)
+        rightWriterThread->join();
+    if(unpairedLeftWriterThread)
+        unpairedLeftWriterThread->join();
+    if(unpairedRightWriterThread)
+        unpairedRightWriterThread->join();
+    if(mergedWriterThread)
+        mergedWriterThread->join();
+    if(failedWriterThread)
+        failedWriterThread->join();
+    if(overlappedWriterThread)
+        overlappedWriterThread->join();
+    // wait for all split files or partitions to be written
+    if(mSplitWriter)
+        mSplitWriter->close();
+    if(mPartitionWriter)
+        mPartitionWriter->close();
 
     if(mOptions->verbose)
         loginfo("start to generate reports\n");
@@ -199,6 +249,12 @@ bool PairEndProcessor::process(){
     Stats* finalPreStats2 = Stats::merge(preStats2);
     Stats* finalPostStats2 = Stats::merge(postStats2);
     FilterResult* finalFilterResult = FilterResult::merge(filterResults);
+    // the insert sizes are counted by all the threads
+    for(int t=0; t<mOptions->thread; t++) {
+        long* hist = configs[t]->getInsertSizeHist();
+        for(int i=0; i<=mOptions->insertSizeMax; i++)
+            mInsertSizeHist[i] += hist[i];
+    }
 
     cerr << "Read1 before filtering:"<<endl;
     finalPreStats1->print();
@@ -230,7 +286,16 @@ bool PairEndProcessor::process(){
         memset(dupHist, 0, sizeof(int) * mOptions->duplicate.histSize);
         dupMeanGC = new double[mOptions->duplicate.histSize];
         memset(dupMeanGC, 0, sizeof(double) * mOptions->duplicate.histSize);
-        dupRate = mDuplicate->statAll(dupHist, dupMeanGC, mOptions->duplicate.histSize);
+        if(mDuplicate) {
+            dupRate = mDuplicate->statAll(dupHist, dupMeanGC, mOptions->duplicate.histSize);
+        } else {
+            vector<DupSketch*> dupSketches;
+            for(int t=0; t<mOptions->thread; t++)
+                dupSketches.push_back(configs[t]->getDupSketch());
+            DupSketch* dupSketch = DupSketch::merge(dupSketches);
+            dupRate = dupSketch->statAll(dupHist, dupMeanGC, mOptions->duplicate.histSize);
+            delete dupSketch;
+        }
         cerr << endl;
         cerr << "Duplication rate: " << dupRate * 100.0 << "%" << endl;
     }
@@ -301,8 +366,7 @@ bool PairEndProcessor::process(){
     if(overlappedWriterThread)
         delete overlappedWriterThread;
 
-    if(!mOptions->split.enabled)
-        closeOutput();
+    closeOutput();
 
     return true;
 }
@@ -320,20 +384,41 @@ int PairEndProcessor::getPeakInsertSize() {
 }
 
 bool PairEndProcessor::processPairEnd(ReadPairPack* pack, ThreadConfig* config){
-    string outstr1;
-    string outstr2;
-    string unpairedOut1;
-    string unpairedOut2;
-    string singleOutput;
-    string mergedOutput;
-    string failedOut;
-    string overlappedOut;
-    int readPassed = 0;
+    // records are serialized directly into the buffers, which are then handed to the writers
+    // only the outputs of this mode get a buffer, the interleaved pairs of STDOUT (or shm) also go to mLeftWriter
+    bool interleaved = mOptions->outputToStream() && !mOptions->merge.enabled;
+    string* outstr1 = NULL;
+    string* outstr2 = NULL;
+    if(mSplitWriter) {
+        outstr1 = mSplitWriter->getBuffer();
+        outstr2 = mSplitWriter->getBuffer();
+    } else if(!interleaved) {
+        outstr1 = WriterThread::getOutputBuffer(mLeftWriter);
+        outstr2 = WriterThread::getOutputBuffer(mRightWriter);
+    }
+    string* singleOutput = interleaved ? WriterThread::getOutputBuffer(mLeftWriter) : NULL;
+    string* unpairedOut1 = WriterThread::getOutputBuffer(mUnpairedLeftWriter);
+    string* unpairedOut2 = WriterThread::getOutputBuffer(mUnpairedRightWriter ? mUnpairedRightWriter : mUnpairedLeftWriter);
+    string* mergedOutput = WriterThread::getOutputBuffer(mMergedWriter);
+    string* failedOut = WriterThread::getOutputBuffer(mFailedWriter);
+    string* overlappedOut = WriterThread::getOutputBuffer(mOverlappedWriter);
+    // for splitting output, the end offset of each record in outstr1 and outstr2
+    // if splitting by file number, the files are balanced by input reads, so filtered reads are also counted
+    vector<size_t> recordEnds1;
+    vector<size_t> recordEnds2;
+    // for partitioning output, the buffer of each partition
+    vector<string*> partitionOut1;
+    vector<string*> partitionOut2;
     int mergedCount = 0;
+    // the overlap of each pair is computed once, and only again after the reads are changed
+    OverlapContext overlap(mOptions->overlapDiffLimit, mOptions->overlapRequire, mOverlapPrior, config->getOverlapGapBuffer());
     for(int p=0;p<pack->count;p++){
         ReadPair* pair = pack->data[p];
+        // the position of the pair in the input, for sampling the stats
+        long index = pack->index * PACK_SIZE + p;
         Read* or1 = pair->mLeft;
         Read* or2 = pair->mRight;
+        bool pairPassed = false;
 
         int lowQualNum1 = 0;
         int nBaseNum1 = 0;
@@ -341,12 +426,14 @@ bool PairEndProcessor::processPairEnd(ReadPairPack* pack, ThreadConfig* config){
         int nBaseNum2 = 0;
 
         // stats the original read before trimming
-        config->getPreStats1()->statRead(or1);
-        config->getPreStats2()->statRead(or2);
+        config->getPreStats1()->statRead(or1, index);
+        config->getPreStats2()->statRead(or2, index);
 
         // handling the duplication profiling
         if(mDuplicate)
             mDuplicate->statPair(or1, or2);
+        else if(config->getDupSketch())
+            config->getDupSketch()->statPair(or1, or2);
 
         // filter by index
         if(mOptions->indexFilter.enabled && mFilter->filterByIndex(or1, or2)) {
@@ -354,6 +441,21 @@ bool PairEndProcessor::processPairEnd(ReadPairPack* pack, ThreadConfig* config){
             continue;
         }
 
+        // drop the pair if the same read1 and read2 sequences have been seen
+        if(mDedupSet && !mDedupSet->add(or1->mSeq.mStr.c_str(), or1->length(), or2->mSeq.mStr.c_str(), or2->length())) {
+            config->addFilterResult(FAIL_DUPLICATE, 2);
+            if(mFailedWriter) {
+                or1->appendToStringWithTag(failedOut, FAILED_TYPES[FAIL_DUPLICATE]);
+                or2->appendToStringWithTag(failedOut, FAILED_TYPES[FAIL_DUPLICATE]);
+            }
+            if(mSplitWriter && mOptions->split.byFileNumber) {
+                recordEnds1.push_back(outstr1->size());
+                recordEnds2.push_back(outstr2->size());
+            }
+            delete pair;
+            continue;
+        }
+
         // fix MGI
         if(mOptions->fixMGI) {
             or1->fixMGI();
@@ -370,19 +472,22 @@ bool PairEndProcessor::processPairEnd(ReadPairPack* pack, ThreadConfig* config){
         Read* r2 = mFilter->trimAndCut(or2, mOptions->trim.front2, mOptions->trim.tail2, frontTrimmed2);
 
         if(r1 != NULL && r2!=NULL) {
+            overlap.reset(r1, r2, frontTrimmed1, frontTrimmed2);
             if(mOptions->polyGTrim.enabled)
                 PolyX::trimPolyG(r1, r2, config->getFilterResult(), mOptions->polyGTrim.minLen);
         }
         bool isizeEvaluated = false;
         if(r1 != NULL && r2!=NULL && (mOptions->adapter.enabled || mOptions->correction.enabled)){
-            OverlapResult ov = OverlapAnalysis::analyze(r1, r2, mOptions->overlapDiffLimit, mOptions->overlapRequire, mOptions->overlapDiffPercentLimit/100.0);
-            // we only use thread 0 to evaluae ISIZE
-            if(config->getThreadId() == 0) {
-                statInsertSize(r1, r2, ov, frontTrimmed1, frontTrimmed2);
-                isizeEvaluated = true;
-            }
+            OverlapResult ov = overlap.analyze(mOptions->overlapDiffPercentLimit/100.0);
+            statInsertSize(r1, r2, ov, config->getInsertSizeHist(), frontTrimmed1, frontTrimmed2);
+            isizeEvaluated = true;
             if(mOptions->correction.enabled) {
-                BaseCorrector::correctByOverlapAnalysis(r1, r2, config->getFilterResult(), ov);
+                // the pair not overlapped may be overlapped with indels, the adapters are still trimmed by the ungapped overlap
+                OverlapResult correctionOv = ov;
+                if(!ov.overlapped && mOptions->overlapIndel)
+                    correctionOv = overlap.analyzeGapped(mOptions->overlapDiffPercentLimit/100.0);
+                if(BaseCorrector::correctByOverlapAnalysis(r1, r2, config->getFilterResult(), correctionOv) > 0)
+                    overlap.invalidate();
             }
             if(mOptions->adapter.enabled) {
                 bool trimmed = AdapterTrimmer::trimByOverlapAnalysis(r1, r2, config->getFilterResult(), ov, frontTrimmed1, frontTrimmed2);
@@ -395,24 +500,25 @@ bool PairEndProcessor::processPairEnd(ReadPairPack* pack, ThreadConfig* config){
                         trimmed2 = AdapterTrimmer::trimBySequence(r2, config->getFilterResult(), mOptions->adapter.sequenceR2, true);
                 }
                 if(mOptions->adapter.hasFasta) {
-                    AdapterTrimmer::trimByMultiSequences(r1, config->getFilterResult(), mOptions->adapter.seqsInFasta, false, !trimmed1);
-                    AdapterTrimmer::trimByMultiSequences(r2, config->getFilterResult(), mOptions->adapter.seqsInFasta, true, !trimmed2);
+                    AdapterTrimmer::trimByMultiSequences(r1, config->getFilterResult(), mOptions->adapter.seqsInFasta, false, !trimmed1, mAdapterIndex, config->getReadSeeds());
+                    AdapterTrimmer::trimByMultiSequences(r2, config->getFilterResult(), mOptions->adapter.seqsInFasta, true, !trimmed2, mAdapterIndex, config->getReadSeeds());
                 }
             }
         }
 
         if(r1 != NULL && r2!=NULL && mOverlappedWriter) {
-            OverlapResult ov = OverlapAnalysis::analyze(r1, r2, mOptions->overlapDiffLimit, mOptions->overlapRequire, 0);
+            OverlapResult ov = overlap.analyze(0);
             if(ov.overlapped) {
                 Read* overlappedRead = new Read(r1->mName, r1->mSeq.mStr.substr(max(0,ov.offset), ov.overlap_len), r1->mStrand, r1->mQuality.substr(max(0,ov.offset), ov.overlap_len));
-                overlappedOut += overlappedRead->toString();
+                overlappedRead->appendToString(overlappedOut);
                 delete overlappedRead;
             }
         }
 
-        if(config->getThreadId() == 0 && !isizeEvaluated && r1 != NULL && r2!=NULL) {
-            OverlapResult ov = OverlapAnalysis::analyze(r1, r2, mOptions->overlapDiffLimit, mOptions->overlapRequire, mOptions->overlapDiffPercentLimit/100.0);
-            statInsertSize(r1, r2, ov, frontTrimmed1, frontTrimmed2);
+        // every pair is evaluated by the thread processing it, the overlap is reused by merging if the reads are not changed
+        if(!isizeEvaluated && r1 != NULL && r2!=NULL) {
+            OverlapResult ov = overlap.analyze(mOptions->overlapDiffPercentLimit/100.0);
+            statInsertSize(r1, r2, ov, config->getInsertSizeHist(), frontTrimmed1, frontTrimmed2);
             isizeEvaluated = true;
         }
 
@@ -432,15 +538,16 @@ bool PairEndProcessor::processPairEnd(ReadPairPack* pack, ThreadConfig* config){
         // merging mode
         bool mergeProcessed = false;
         if(mOptions->merge.enabled && r1 && r2) {
-            OverlapResult ov = OverlapAnalysis::analyze(r1, r2, mOptions->overlapDiffLimit, mOptions->overlapRequire, mOptions->overlapDiffPercentLimit/100.0);
+            OverlapResult ov = overlap.analyze(mOptions->overlapDiffPercentLimit/100.0);
+            if(!ov.overlapped && mOptions->overlapIndel)
+                ov = overlap.analyzeGapped(mOptions->overlapDiffPercentLimit/100.0);
             if(ov.overlapped) {
                 merged = OverlapAnalysis::merge(r1, r2, ov);
                 int result = mFilter->passFilter(merged);
                 config->addFilterResult(result, 2);
                 if(result == PASS_FILTER) {
-                    mergedOutput += merged->toString();
-                    config->getPostStats1()->statRead(merged);
-                    readPassed++;
+                    merged->appendToString(mergedOutput);
+                    config->getPostStats1()->statRead(merged, index);
                     mergedCount++;
                 }
                 delete merged;
@@ -449,18 +556,16 @@ bool PairEndProcessor::processPairEnd(ReadPairPack* pack, ThreadConfig* config){
                 int result1 = mFilter->passFilter(r1);
                 config->addFilterResult(result1, 1);
                 if(result1 == PASS_FILTER) {
-                    mergedOutput += r1->toString();
-                    config->getPostStats1()->statRead(r1);
+                    r1->appendToString(mergedOutput);
+                    config->getPostStats1()->statRead(r1, index);
                 }
 
                 int result2 = mFilter->passFilter(r2);
                 config->addFilterResult(result2, 1);
                 if(result2 == PASS_FILTER) {
-                    mergedOutput += r2->toString();
-                    config->getPostStats1()->statRead(r2);
+                    r2->appendToString(mergedOutput);
+                    config->getPostStats1()->statRead(r2, index);
                 }
-                if(result1 == PASS_FILTER && result2 == PASS_FILTER )
-                    readPassed++;
                 mergeProcessed = true;
             }
         }
@@ -474,40 +579,48 @@ bool PairEndProcessor::processPairEnd(ReadPairPack* pack, ThreadConfig* config){
 
             if( r1 != NULL &&  result1 == PASS_FILTER && r2 != NULL && result2 == PASS_FILTER ) {
                 
-                if(mOptions->outputToSTDOUT && !mOptions->merge.enabled) {
-                    singleOutput += r1->toString() + r2->toString();
+                if(interleaved) {
+                    r1->appendToString(singleOutput);
+                    r2->appendToString(singleOutput);
+                } else if(mPartitionWriter) {
+                    // the pair is routed by the name of read1
+                    int partition = PartitionWriter::getPartition(r1->mName, mOptions->partition.number);
+                    r1->appendToString(mPartitionWriter->getBuffer(partitionOut1, partition));
+                    r2->appendToString(mPartitionWriter->getBuffer(partitionOut2, partition));
                 } else {
-                    outstr1 += r1->toString();
-                    outstr2 += r2->toString();
+                    if(outstr1)
+                        r1->appendToString(outstr1);
+                    if(outstr2)
+                        r2->appendToString(outstr2);
                 }
 
                 // stats the read after filtering
                 if(!mOptions->merge.enabled) {
-                    config->getPostStats1()->statRead(r1);
-                    config->getPostStats2()->statRead(r2);
+                    config->getPostStats1()->statRead(r1, index);
+                    config->getPostStats2()->statRead(r2, index);
                 }
 
-                readPassed++;
+                pairPassed = true;
             } else if( r1 != NULL &&  result1 == PASS_FILTER) {
                 if(mUnpairedLeftWriter) {
-                    unpairedOut1 += r1->toString();
+                    r1->appendToString(unpairedOut1);
                     if(mFailedWriter)
-                        failedOut += or2->toStringWithTag(FAILED_TYPES[result2]);
+                        or2->appendToStringWithTag(failedOut, FAILED_TYPES[result2]);
                 } else {
                     if(mFailedWriter) {
-                        failedOut += or1->toStringWithTag("paired_read_is_failing");
-                        failedOut += or2->toStringWithTag(FAILED_TYPES[result2]);
+                        or1->appendToStringWithTag(failedOut, "paired_read_is_failing");
+                        or2->appendToStringWithTag(failedOut, FAILED_TYPES[result2]);
                     }
                 }
             } else if( r2 != NULL && result2 == PASS_FILTER) {
                 if(mUnpairedLeftWriter || mUnpairedRightWriter) {
-                    unpairedOut2 += r2->toString();
+                    r2->appendToString(unpairedOut2);
                     if(mFailedWriter)
-                        failedOut += or1->toStringWithTag(FAILED_TYPES[result1]);
+                        or1->appendToStringWithTag(failedOut, FAILED_TYPES[result1]);
                 } else {
                     if(mFailedWriter) {
-                        failedOut += or1->toStringWithTag(FAILED_TYPES[result1]);
-                        failedOut += or2->toStringWithTag("paired_read_is_failing");
+                        or1->appendToStringWithTag(failedOut, FAILED_TYPES[result1]);
+                        or2->appendToStringWithTag(failedOut, "paired_read_is_failing");
                     }
                 }
             }
@@ -520,101 +633,62 @@ bool PairEndProcessor::processPairEnd(ReadPairPack* pack, ThreadConfig* config){
         // if no trimming applied, r1 should be identical to or1
         if(r2 != or2 && r2 != NULL)
             delete r2;
+
+        if(mSplitWriter && (pairPassed || mOptions->split.byFileNumber)) {
+            recordEnds1.push_back(outstr1->size());
+            recordEnds2.push_back(outstr2->size());
+        }
     }
-    // if splitting output, then no lock is need since different threads write different files
-    if(!mOptions->split.enabled) 
-        mOutputMtx.lock();
-    if(mOptions->outputToSTDOUT) {
-        // STDOUT output
-        // if it's merging mode, write the merged reads to STDOUT
-        // otherwise write interleaved single output
-        if(mOptions->merge.enabled)
-            fwrite(mergedOutput.c_str(), 1, mergedOutput.length(), stdout);
-        else
-            fwrite(singleOutput.c_str(), 1, singleOutput.length(), stdout);
-    } else if(mOptions->split.enabled) {
-        // split output by each worker thread
-        if(!mOptions->out1.empty())
-            config->getWriter1()->writeString(outstr1);
-        if(!mOptions->out2.empty())
-            config->getWriter2()->writeString(outstr2);
-    } 
-
-    if(mMergedWriter && !mergedOutput.empty()) {
-        // write merged data
-        char* mdata = new char[mergedOutput.size()];
-        memcpy(mdata, mergedOutput.c_str(), mergedOutput.size());
-        mMergedWriter->input(mdata, mergedOutput.size());
-    }
-
-    if(mFailedWriter && !failedOut.empty()) {
-        // write failed data
-        char* fdata = new char[failedOut.size()];
-        memcpy(fdata, failedOut.c_str(), failedOut.size());
-        mFailedWriter->input(fdata, failedOut.size());
-    }
-
-    if(mOverlappedWriter && !overlappedOut.empty()) {
-        // write failed data
-        char* odata = new char[overlappedOut.size()];
-        memcpy(odata, overlappedOut.c_str(), overlappedOut.size());
-        mOverlappedWriter->input(odata, overlappedOut.size());
-    }
-
-    // normal output by left/right writer thread
-    if(mRightWriter && mLeftWriter && (!outstr1.empty() || !outstr2.empty())) {
-        // write PE
-        char* ldata = new char[outstr1.size()];
-        memcpy(ldata, outstr1.c_str(), outstr1.size());
-        mLeftWriter->input(ldata, outstr1.size());
-
-        char* rdata = new char[outstr2.size()];
-        memcpy(rdata, outstr2.c_str(), outstr2.size());
-        mRightWriter->input(rdata, outstr2.size());
-    } else if(mLeftWriter && !singleOutput.empty()) {
-        // write singleOutput
-        char* ldata = new char[singleOutput.size()];
-        memcpy(ldata, singleOutput.c_str(), singleOutput.size());
-        mLeftWriter->input(ldata, singleOutput.size());
-    }
-    // output unpaired reads
-    if (!unpairedOut1.empty() || !unpairedOut2.empty()) {
-        if(mUnpairedLeftWriter && mUnpairedRightWriter) {
-            // write PE
-            char* unpairedData1 = new char[unpairedOut1.size()];
-            memcpy(unpairedData1, unpairedOut1.c_str(), unpairedOut1.size());
-            mUnpairedLeftWriter->input(unpairedData1, unpairedOut1.size());
-
-            char* unpairedData2 = new char[unpairedOut2.size()];
-            memcpy(unpairedData2, unpairedOut2.c_str(), unpairedOut2.size());
-            mUnpairedRightWriter->input(unpairedData2, unpairedOut2.size());
-        } else if(mUnpairedLeftWriter) {
-            char* unpairedData = new char[unpairedOut1.size() + unpairedOut2.size() ];
-            memcpy(unpairedData, unpairedOut1.c_str(), unpairedOut1.size());
-            memcpy(unpairedData + unpairedOut1.size(), unpairedOut2.c_str(), unpairedOut2.size());
-            mUnpairedLeftWriter->input(unpairedData, unpairedOut1.size() + unpairedOut2.size());
+    mOutputMtx.lock();
+    // write merged, failed and overlapped data
+    WriterThread::outputBuffer(mMergedWriter, mergedOutput);
+    WriterThread::outputBuffer(mFailedWriter, failedOut);
+    WriterThread::outputBuffer(mOverlappedWriter, overlappedOut);
+
+    if(mPartitionWriter)
+        mPartitionWriter->input(partitionOut1, partitionOut2);
+
+    if(mSplitWriter) {
+        // the split writer decides which file each record goes to
+        if(mOptions->out2.empty()) {
+            mSplitWriter->input(outstr1, recordEnds1);
+            mSplitWriter->recycleBuffer(outstr2);
+        } else {
+            mSplitWriter->input(outstr1, recordEnds1, outstr2, recordEnds2);
         }
+    } else if(mRightWriter && mLeftWriter && (!outstr1->empty() || !outstr2->empty())) {
+        // normal output by left/right writer thread
+        // write PE, the two buffers are always handed over together to keep the files in pair
+        mLeftWriter->input(outstr1);
+        mRightWriter->input(outstr2);
+    } else {
+        WriterThread::outputBuffer(mLeftWriter, outstr1);
+        WriterThread::outputBuffer(mRightWriter, outstr2);
     }
+    WriterThread::outputBuffer(mLeftWriter, singleOutput);
 
-    if(!mOptions->split.enabled)
-        mOutputMtx.unlock();
+    // output unpaired reads
+    // if there is no separated writer for unpaired read2, they follow unpaired read1 in the same file
+    WriterThread::outputBuffer(mUnpairedLeftWriter, unpairedOut1);
+    WriterThread::outputBuffer(mUnpairedRightWriter ? mUnpairedRightWriter : mUnpairedLeftWriter, unpairedOut2);
 
-    if(mOptions->split.byFileLines)
-        config->markProcessed(readPassed);
-    else
-        config->markProcessed(pack->count);
+    mOutputMtx.unlock();
 
     if(mOptions->merge.enabled) {
         config->addMergedPairs(mergedCount);
     }
 
+    // thread 0 updates the prior once a pack by the insert sizes it has counted, the last bin is the unknown ones
+    if(mOverlapPrior && config->getThreadId() == 0)
+        mOverlapPrior->update(config->getInsertSizeHist(), mOptions->insertSizeMax);
+
     delete pack->data;
     delete pack;
 
     return true;
 }
     
-void PairEndProcessor::statInsertSize(Read* r1, Read* r2, OverlapResult& ov, int frontTrimmed1, int frontTrimmed2) {
+void PairEndProcessor::statInsertSize(Read* r1, Read* r2, OverlapResult& ov, long* hist, int frontTrimmed1, int frontTrimmed2) {
     int isize = mOptions->insertSizeMax;
     if(ov.overlapped) {
         if(ov.offset > 0)
@@ -626,7 +700,7 @@ void PairEndProcessor::statInsertSize(Read* r1, Read* r2, OverlapResult& ov, int
     if(isize > mOptions->insertSizeMax)
         isize = mOptions->insertSizeMax;
 
-    mInsertSizeHist[isize]++;
+    hist[isize]++;
 }
 
 bool PairEndProcessor::processRead(Read* r, ReadPair* originalPair, bool reversed) {
@@ -654,6 +728,7 @@ void PairEndProcessor::producePack(ReadPairPack* pack){
         //mRepo.repoNotFull.wait(lock);
     }*/
 
+    pack->index = mRepo.writePos;
     mRepo.packBuffer[mRepo.writePos] = pack;
     mRepo.writePos++;
 
@@ -756,28 +831,30 @@ void PairEndProcessor::producerTask()
             readNum += count;
             // if the writer threads are far behind this producer, sleep and wait
             // check this only when necessary
-            if(readNum % (PACK_SIZE * PACK_IN_MEM_LIMIT) == 0 && mLeftWriter) {
-                while( (mLeftWriter && mLeftWriter->bufferLength() > PACK_IN_MEM_LIMIT) || (mRightWriter && mRightWriter->bufferLength() > PACK_IN_MEM_LIMIT) ){
+            if(readNum % (PACK_SIZE * PACK_IN_MEM_LIMIT) == 0 && (mLeftWriter || mSplitWriter || mPartitionWriter)) {
+                while( (mLeftWriter && mLeftWriter->bufferLength() > PACK_IN_MEM_LIMIT) || (mRightWriter && mRightWriter->bufferLength() > PACK_IN_MEM_LIMIT)
+                    || (mSplitWriter && mSplitWriter->bufferLength() > PACK_IN_MEM_LIMIT * 2)
+                    || (mPartitionWriter && mPartitionWriter->bufferLength() > PACK_IN_MEM_LIMIT) ){
                     slept++;
                     usleep(1000);
                 }
             }
             // reset count to 0
             count = 0;
-            // re-evaluate split size
-            // TODO: following codes are commented since it may cause threading related conflicts in some systems
-            /*if(mOptions->split.needEvaluation && !splitSizeReEvaluated && readNum >= mOptions->split.size) {
+            // re-evaluate split size with the reads loaded, the split writer applies it from the file being written
+            if(mSplitWriter && mOptions->split.needEvaluation && !splitSizeReEvaluated && readNum >= mOptions->split.size) {
                 splitSizeReEvaluated = true;
                 // greater than the initial evaluation
                 if(readNum >= 1024*1024) {
                     size_t bytesRead;
                     size_t bytesTotal;
                     reader.mLeft->getBytes(bytesRead, bytesTotal);
-                    mOptions->split.size *=  (double)bytesTotal / ((double)bytesRead * (double) mOptions->split.number);
-                    if(mOptions->split.size <= 0)
-                        mOptions->split.size = 1;
+                    if(bytesRead > 0) {
+                        long splitSize = (double)readNum * (double)bytesTotal / ((double)bytesRead * (double) mOptions->split.number);
+                        mSplitWriter->setSplitSize(splitSize);
+                    }
                 }
-            }*/
+            }
         }
     }
 
@@ -795,10 +872,6 @@ void PairEndProcessor::producerTask()
 void PairEndProcessor::consumerTask(ThreadConfig* config)
 {
     while(true) {
-        if(config->canBeStopped()){
-            mFinishedThreads++;
-            break;
-        }
         while(mRepo.writePos <= mRepo.readPos) {
             if(mProduceFinished)
                 break;
@@ -15,7 +15,11 @@
 #include "umiprocessor.h"
 #include "overlapanalysis.h"
 #include "writerthread.h"
+#include "splitwriter.h"
+#include "partitionwriter.h"
 #include "duplicate.h"
+#include "dedupset.h"
+#include "adapterindex.h"
 
 
 using namespace std;
@@ -23,6 +27,8 @@ using namespace std;
 struct ReadPairPack {
     ReadPair** data;
     int count;
+    // the sequence number of the pack in the input, the reads before it are index * PACK_SIZE
+    long index;
 };
 
 typedef struct ReadPairPack ReadPairPack;
@@ -54,10 +60,9 @@ private:
     void consumePack(ThreadConfig* config);
     void producerTask();
     void consumerTask(ThreadConfig* config);
-    void initConfig(ThreadConfig* config);
     void initOutput();
     void closeOutput();
-    void statInsertSize(Read* r1, Read* r2, OverlapResult& ov, int frontTrimmed1 = 0, int frontTrimmed2 = 0);
+    void statInsertSize(Read* r1, Read* r2, OverlapResult& ov, long* hist, int frontTrimmed1 = 0, int frontTrimmed2 = 0);
     int getPeakInsertSize();
     void writeTask(WriterThread* config);
 
@@ -74,15 +79,20 @@ private:
     ofstream* mOutStream1;
     ofstream* mOutStream2;
     UmiProcessor* mUmiProcessor;
-    atomic_long* mInsertSizeHist;
+    long* mInsertSizeHist;
     WriterThread* mLeftWriter;
     WriterThread* mRightWriter;
+    SplitWriter* mSplitWriter;
+    PartitionWriter* mPartitionWriter;
     WriterThread* mUnpairedLeftWriter;
     WriterThread* mUnpairedRightWriter;
     WriterThread* mMergedWriter;
     WriterThread* mFailedWriter;
     WriterThread* mOverlappedWriter;
     Duplicate* mDuplicate;
+    DedupSet* mDedupSet;
+    AdapterIndex* mAdapterIndex;
+    OverlapPrior* mOverlapPrior;
 };
 
 
@@ -1,6 +1,7 @@
 #include "processor.h"
 #include "peprocessor.h"
 #include "seprocessor.h"
+#include "qcprocessor.h"
 
 Processor::Processor(Options* opt){
     mOptions = opt;
@@ -11,7 +12,10 @@ Processor::~Processor(){
 }
 
 bool Processor::process() {
-    if(mOptions->isPaired()) {
+    if(mOptions->reportOnly) {
+        QCProcessor p(mOptions);
+        p.process();
+    } else if(mOptions->isPaired()) {
         PairEndProcessor p(mOptions);
         p.process();
     } else {
@@ -0,0 +1,452 @@
+#include "qcprocessor.h"
+#include "fastqreader.h"
+#include "overlapanalysis.h"
+#include "jsonreporter.h"
+#include "htmlreporter.h"
+#include "util.h"
+#include "simd.h"
+#include <unistd.h>
+#include <string.h>
+#include <functional>
+#include <thread>
+
+QCProcessor::QCProcessor(Options* opt){
+    mOptions = opt;
+    mFiles = mOptions->in2.empty() ? 1 : 2;
+    mReadFinished[0] = false;
+    mReadFinished[1] = false;
+    mNextChunk = 0;
+
+    mDuplicate = NULL;
+    if(mOptions->duplicate.enabled && !mOptions->duplicate.sketch) {
+        mDuplicate = new Duplicate(mOptions);
+    }
+
+    int isizeBufLen = mOptions->insertSizeMax + 1;
+    mInsertSizeHist = new long[isizeBufLen]();
+}
+
+QCProcessor::~QCProcessor() {
+    if(mDuplicate) {
+        delete mDuplicate;
+        mDuplicate = NULL;
+    }
+    delete[] mInsertSizeHist;
+}
+
+bool QCProcessor::process(){
+    std::thread** readers = new thread*[mFiles];
+    for(int f=0; f<mFiles; f++){
+        readers[f] = new std::thread(std::bind(&QCProcessor::readerTask, this, f));
+    }
+
+    bool paired = mOptions->isPaired();
+    ThreadConfig** configs = new ThreadConfig*[mOptions->thread];
+    for(int t=0; t<mOptions->thread; t++){
+        configs[t] = new ThreadConfig(mOptions, t, paired);
+    }
+    std::thread** threads = new thread*[mOptions->thread];
+    for(int t=0; t<mOptions->thread; t++){
+        threads[t] = new std::thread(std::bind(&QCProcessor::workerTask, this, configs[t]));
+    }
+
+    for(int f=0; f<mFiles; f++){
+        readers[f]->join();
+        delete readers[f];
+    }
+    delete[] readers;
+    for(int t=0; t<mOptions->thread; t++){
+        threads[t]->join();
+        delete threads[t];
+    }
+    delete[] threads;
+
+    if(mOptions->verbose)
+        loginfo("start to generate reports\n");
+
+    // merge stats and read filter results
+    vector<Stats*> preStats1;
+    vector<Stats*> preStats2;
+    vector<FilterResult*> filterResults;
+    for(int t=0; t<mOptions->thread; t++){
+        preStats1.push_back(configs[t]->getPreStats1());
+        if(paired)
+            preStats2.push_back(configs[t]->getPreStats2());
+        filterResults.push_back(configs[t]->getFilterResult());
+    }
+    Stats* finalStats1 = Stats::merge(preStats1);
+    Stats* finalStats2 = paired ? Stats::merge(preStats2) : NULL;
+    FilterResult* finalFilterResult = FilterResult::merge(filterResults);
+
+    cerr << "Read1:"<<endl;
+    finalStats1->print();
+    if(paired) {
+        cerr << endl;
+        cerr << "Read2:"<<endl;
+        finalStats2->print();
+    }
+
+    int* dupHist = NULL;
+    double* dupMeanGC = NULL;
+    double dupRate = 0.0;
+    if(mOptions->duplicate.enabled) {
+        dupHist = new int[mOptions->duplicate.histSize];
+        memset(dupHist, 0, sizeof(int) * mOptions->duplicate.histSize);
+        dupMeanGC = new double[mOptions->duplicate.histSize];
+        memset(dupMeanGC, 0, sizeof(double) * mOptions->duplicate.histSize);
+        if(mDuplicate) {
+            dupRate = mDuplicate->statAll(dupHist, dupMeanGC, mOptions->duplicate.histSize);
+        } else {
+            vector<DupSketch*> dupSketches;
+            for(int t=0; t<mOptions->thread; t++)
+                dupSketches.push_back(configs[t]->getDupSketch());
+            DupSketch* dupSketch = DupSketch::merge(dupSketches);
+            dupRate = dupSketch->statAll(dupHist, dupMeanGC, mOptions->duplicate.histSize);
+            delete dupSketch;
+        }
+        cerr << endl;
+        if(paired)
+            cerr << "Duplication rate: " << dupRate * 100.0 << "%" << endl;
+        else
+            cerr << "Duplication rate (may be overestimated since this is SE data): " << dupRate * 100.0 << "%" << endl;
+    }
+
+    int peakInsertSize = 0;
+    if(paired) {
+        // the insert sizes are counted by all the threads
+        for(int t=0; t<mOptions->thread; t++) {
+            long* hist = configs[t]->getInsertSizeHist();
+            for(int i=0; i<=mOptions->insertSizeMax; i++)
+                mInsertSizeHist[i] += hist[i];
+        }
+        peakInsertSize = getPeakInsertSize();
+        cerr << endl;
+        cerr << "Insert size peak (evaluated by paired-end reads): " << peakInsertSize << endl;
+    }
+
+    // nothing is filtered, so the stats after filtering are the same as before
+    JsonReporter jr(mOptions);
+    jr.setDupHist(dupHist, dupMeanGC, dupRate);
+    if(paired)
+        jr.setInsertHist(mInsertSizeHist, peakInsertSize);
+    jr.report(finalFilterResult, finalStats1, finalStats1, finalStats2, finalStats2);
+
+    HtmlReporter hr(mOptions);
+    hr.setDupHist(dupHist, dupMeanGC, dupRate);
+    if(paired)
+        hr.setInsertHist(mInsertSizeHist, peakInsertSize);
+    hr.report(finalFilterResult, finalStats1, finalStats1, finalStats2, finalStats2);
+
+    // clean up
+    for(int t=0; t<mOptions->thread; t++){
+        delete configs[t];
+        configs[t] = NULL;
+    }
+    delete[] configs;
+
+    delete finalStats1;
+    if(finalStats2)
+        delete finalStats2;
+    delete finalFilterResult;
+
+    if(mOptions->duplicate.enabled) {
+        delete[] dupHist;
+        delete[] dupMeanGC;
+    }
+
+    return true;
+}
+
+bool QCProcessor::pushChunk(int file, QCChunk* chunk) {
+    // if the workers are far behind this reader, sleep and wait to limit memory usage
+    while(true) {
+        mChunkMtx.lock();
+        // the other file has ended before this chunk, so it can't be paired
+        int other = 1 - file;
+        if(mFiles == 2 && mReadFinished[other] && mChunks[other].size() <= mChunks[file].size()) {
+            mChunkMtx.unlock();
+            delete[] chunk->data;
+            delete chunk;
+            return false;
+        }
+        bool full = mChunks[file].size() - mNextChunk > mOptions->thread * 8;
+        if(!full) {
+            mChunks[file].push_back(chunk);
+            mChunkMtx.unlock();
+            return true;
+        }
+        mChunkMtx.unlock();
+        usleep(100);
+    }
+}
+
+void QCProcessor::readerTask(int file) {
+    if(mOptions->verbose)
+        loginfo("start to load data");
+    FastqReader reader(file == 0 ? mOptions->in1 : mOptions->in2);
+    // an interleaved chunk has PACK_SIZE pairs
+    int recordsPerChunk = mOptions->interleavedInput ? PACK_SIZE * 2 : PACK_SIZE;
+    long recordLimit = mOptions->interleavedInput ? mOptions->readsToProcess * 2 : mOptions->readsToProcess;
+    long records = 0;
+
+    int capacity = QC_CHUNK_BUF_SIZE;
+    char* data = new char[capacity];
+    int dataLen = 0;
+    int pos = 0;
+    bool eof = false;
+    QCChunk* chunk = new QCChunk;
+    while(true) {
+        QCRecord record;
+        if(parseRecord(data, dataLen, pos, record, eof)) {
+            chunk->records.push_back(record);
+            records++;
+            bool limited = recordLimit > 0 && records >= recordLimit;
+            if(chunk->records.size() == recordsPerChunk || limited) {
+                // the rest of data belongs to the next chunk
+                char* next = new char[capacity];
+                memcpy(next, data + pos, dataLen - pos);
+                chunk->data = data;
+                bool accepted = pushChunk(file, chunk);
+                data = next;
+                dataLen -= pos;
+                pos = 0;
+                chunk = new QCChunk;
+                if(limited || !accepted)
+                    break;
+            }
+            continue;
+        }
+        if(eof)
+            break;
+
+        // the records of this chunk refer to the offsets of data, so data is extended instead of compacted
+        if(dataLen == capacity) {
+            capacity *= 2;
+            char* bigger = new char[capacity];
+            memcpy(bigger, data, dataLen);
+            delete[] data;
+            data = bigger;
+        }
+        int bytes = reader.readRaw(data + dataLen, min(capacity - dataLen, QC_READ_BLOCK_SIZE));
+        if(bytes == 0)
+            eof = true;
+        dataLen += bytes;
+    }
+
+    if(chunk->records.empty()) {
+        delete[] data;
+        delete chunk;
+    } else {
+        chunk->data = data;
+        pushChunk(file, chunk);
+    }
+
+    mChunkMtx.lock();
+    mReadFinished[file] = true;
+    mChunkMtx.unlock();
+    if(mOptions->verbose)
+        loginfo("all reads loaded");
+}
+
+void QCProcessor::workerTask(ThreadConfig* config) {
+    string rcBuf;
+    while(true) {
+        QCChunk* chunk1 = NULL;
+        QCChunk* chunk2 = NULL;
+        long chunkIndex = 0;
+        bool finished = true;
+        mChunkMtx.lock();
+        for(int f=0; f<mFiles; f++)
+            finished = finished && mReadFinished[f];
+        bool ready = mNextChunk < mChunks[0].size() && (mFiles == 1 || mNextChunk < mChunks[1].size());
+        if(ready) {
+            chunkIndex = mNextChunk;
+            chunk1 = mChunks[0][mNextChunk];
+            mChunks[0][mNextChunk] = NULL;
+            if(mFiles == 2) {
+                chunk2 = mChunks[1][mNextChunk];
+                mChunks[1][mNextChunk] = NULL;
+            }
+            mNextChunk++;
+        }
+        mChunkMtx.unlock();
+
+        if(!ready) {
+            // the extra chunks of a longer file are not paired, they are released at the end
+            if(finished)
+                break;
+            usleep(1000);
+            continue;
+        }
+
+        // a chunk has PACK_SIZE reads (pairs) like a pack of the normal mode, so the same reads are sampled
+        statChunk(chunk1, chunk2, config, rcBuf, chunkIndex * PACK_SIZE);
+        delete[] chunk1->data;
+        delete chunk1;
+        if(chunk2) {
+            delete[] chunk2->data;
+            delete chunk2;
+        }
+    }
+
+    mChunkMtx.lock();
+    for(int f=0; f<mFiles; f++) {
+        for(long c=mNextChunk; c<mChunks[f].size(); c++) {
+            if(mChunks[f][c]) {
+                delete[] mChunks[f][c]->data;
+                delete mChunks[f][c];
+                mChunks[f][c] = NULL;
+            }
+        }
+    }
+    mChunkMtx.unlock();
+
+    if(mOptions->verbose) {
+        string msg = "thread " + to_string(config->getThreadId() + 1) + " finished";
+        loginfo(msg);
+    }
+}
+
+void QCProcessor::statChunk(QCChunk* chunk1, QCChunk* chunk2, ThreadConfig* config, string& rcBuf, long firstIndex) {
+    // the qualities are converted in place like Read does
+    if(mOptions->phred64) {
+        QCChunk* chunks[2] = {chunk1, chunk2};
+        for(int c=0; c<2 && chunks[c]; c++) {
+            for(int i=0; i<chunks[c]->records.size(); i++) {
+                QCRecord& record = chunks[c]->records[i];
+                Simd::phred64To33(chunks[c]->data + record.qual, record.len);
+            }
+        }
+    }
+
+    bool paired = mOptions->isPaired();
+    int step = mOptions->interleavedInput ? 2 : 1;
+    int count = chunk1->records.size() / step;
+    if(chunk2)
+        count = min(count, (int)chunk2->records.size());
+    Stats* stats1 = config->getPreStats1();
+    Stats* stats2 = config->getPreStats2();
+    DupSketch* dupSketch = config->getDupSketch();
+    for(int i=0; i<count; i++) {
+        QCRecord& r1 = chunk1->records[i * step];
+        const char* seq1 = chunk1->data + r1.seq;
+        stats1->statRead(seq1, chunk1->data + r1.qual, r1.len, firstIndex + i);
+        if(!paired) {
+            if(mDuplicate)
+                mDuplicate->statRead(seq1, r1.len);
+            else if(dupSketch)
+                dupSketch->statRead(seq1, r1.len);
+            continue;
+        }
+
+        QCChunk* c2 = chunk2 ? chunk2 : chunk1;
+        QCRecord& r2 = chunk2 ? chunk2->records[i] : chunk1->records[i * 2 + 1];
+        const char* seq2 = c2->data + r2.seq;
+        stats2->statRead(seq2, c2->data + r2.qual, r2.len, firstIndex + i);
+        if(mDuplicate)
+            mDuplicate->statPair(seq1, r1.len, seq2, r2.len);
+        else if(dupSketch)
+            dupSketch->statPair(seq1, r1.len, seq2, r2.len);
+        statInsertSize(seq1, r1.len, seq2, r2.len, rcBuf, config->getInsertSizeHist());
+    }
+
+    config->addFilterResult(PASS_FILTER, paired ? count * 2 : count);
+}
+
+void QCProcessor::statInsertSize(const char* seq1, int len1, const char* seq2, int len2, string& rcBuf, long* hist) {
+    // the reverse complement of read2, the buffer is reused by the thread
+    rcBuf.resize(len2);
+    Simd::reverseComplement(seq2, &rcBuf[0], len2);
+    OverlapResult ov = OverlapAnalysis::analyze(seq1, len1, rcBuf.data(), len2, mOptions->overlapDiffLimit, mOptions->overlapRequire, mOptions->overlapDiffPercentLimit/100.0);
+
+    int isize = mOptions->insertSizeMax;
+    if(ov.overlapped) {
+        if(ov.offset > 0)
+            isize = len1 + len2 - ov.overlap_len;
+        else
+            isize = ov.overlap_len;
+    }
+    if(isize > mOptions->insertSizeMax)
+        isize = mOptions->insertSizeMax;
+
+    hist[isize]++;
+}
+
+int QCProcessor::getPeakInsertSize() {
+    int peak = 0;
+    long maxCount = -1;
+    for(int i=0; i<mOptions->insertSizeMax; i++) {
+        if(mInsertSizeHist[i] > maxCount) {
+            peak = i;
+            maxCount = mInsertSizeHist[i];
+        }
+    }
+    return peak;
+}
+
+bool QCProcessor::parseRecord(char* data, int dataLen, int& pos, QCRecord& record, bool eof) {
+    int p = pos;
+    // skip the empty lines between records
+    while(p < dataLen && (data[p] == '\n' || data[p] == '\r'))
+        p++;
+
+    // name, sequence, strand and quality
+    int starts[4];
+    int ends[4];
+    for(int l=0; l<4; l++) {
+        if(p >= dataLen)
+            return false;
+        char* lf = (char*)memchr(data + p, '\n', dataLen - p);
+        if(!lf && !eof)
+            return false;
+        int end = lf ? lf - data : dataLen;
+        starts[l] = p;
+        ends[l] = end;
+        if(end > p && data[end - 1] == '\r')
+            ends[l]--;
+        p = end + 1;
+    }
+
+    if(data[starts[0]] != '@')
+        error_exit("a FASTQ record should start with @, but got: " + string(data + starts[0], ends[0] - starts[0]));
+    int len = ends[1] - starts[1];
+    if(ends[3] - starts[3] != len)
+        error_exit("sequence and quality have different length: " + string(data + starts[0], ends[0] - starts[0]));
+
+    record.seq = starts[1];
+    record.qual = starts[3];
+    record.len = len;
+    pos = min(p, dataLen);
+    return true;
+}
+
+bool QCProcessor::test() {
+    string fq = "@r1\nACGT\n+\nEEEE\n\r\n@r2 comment\r\nACG\r\n+\r\nE#E\r\n@r3\nAC";
+    vector<char> data(fq.begin(), fq.end());
+    int pos = 0;
+    QCRecord record;
+
+    if(!parseRecord(data.data(), data.size(), pos, record, false))
+        return false;
+    if(string(data.data() + record.seq, record.len) != "ACGT" || string(data.data() + record.qual, record.len) != "EEEE")
+        return false;
+
+    // the empty line is skipped, and \r is not a part of the sequence
+    if(!parseRecord(data.data(), data.size(), pos, record, false))
+        return false;
+    if(string(data.data() + record.seq, record.len) != "ACG" || string(data.data() + record.qual, record.len) != "E#E")
+        return false;
+
+    // r3 is not complete yet
+    int r3 = pos;
+    if(parseRecord(data.data(), data.size(), pos, record, true) || pos != r3)
+        return false;
+
+    // the last line can have no line break at the end of file
+    string last = "@r4\nAC\n+\nEE";
+    vector<char> lastData(last.begin(), last.end());
+    pos = 0;
+    if(!parseRecord(lastData.data(), lastData.size(), pos, record, false) && pos == 0)
+        return parseRecord(lastData.data(), lastData.size(), pos, record, true) && record.len == 2 && pos == lastData.size();
+    return false;
+}
@@ -0,0 +1,72 @@
+#ifndef QC_PROCESSOR_H
+#define QC_PROCESSOR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include "options.h"
+#include "threadconfig.h"
+#include "duplicate.h"
+
+using namespace std;
+
+// the data of each chunk is read by blocks of this size, so the partial record carried to the next chunk is small
+#define QC_READ_BLOCK_SIZE (1<<16)
+// the initial buffer size of a chunk, it's doubled if the records don't fit
+#define QC_CHUNK_BUF_SIZE (1<<20)
+
+// a record parsed in place, the offsets are in the data of its chunk
+struct QCRecord {
+    int seq;
+    int qual;
+    int len;
+};
+
+// PACK_SIZE records (or pairs for interleaved input) of one input file
+// the chunks of read1 and read2 with a same index have the same pairs
+struct QCChunk {
+    char* data;
+    vector<QCRecord> records;
+};
+
+// the engine of report only mode, nothing is trimmed, filtered or written
+// each input file is read and parsed by its own thread, and the records are counted in place
+// by the stats and duplication kernels of the workers, no Read is created
+class QCProcessor{
+public:
+    QCProcessor(Options* opt);
+    ~QCProcessor();
+    bool process();
+
+    static bool test();
+
+private:
+    void readerTask(int file);
+    void workerTask(ThreadConfig* config);
+    // false if the chunk is dropped since it can't be paired, then the reader should stop
+    bool pushChunk(int file, QCChunk* chunk);
+    // firstIndex is the position of the first read (pair) of the chunks in the input
+    void statChunk(QCChunk* chunk1, QCChunk* chunk2, ThreadConfig* config, string& rcBuf, long firstIndex);
+    // the insert size is counted in the histogram of the thread
+    void statInsertSize(const char* seq1, int len1, const char* seq2, int len2, string& rcBuf, long* hist);
+    int getPeakInsertSize();
+    // parse the record at pos of data, pos is moved to the next record if a complete record is found
+    // the last line can have no line break only if eof is true
+    static bool parseRecord(char* data, int dataLen, int& pos, QCRecord& record, bool eof);
+
+private:
+    Options* mOptions;
+    int mFiles;
+    vector<QCChunk*> mChunks[2];
+    bool mReadFinished[2];
+    // the index of the next chunk (pair) to count
+    long mNextChunk;
+    std::mutex mChunkMtx;
+    Duplicate* mDuplicate;
+    long* mInsertSizeHist;
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include "read.h"
 #include <sstream>
 #include "util.h"
+#include "simd.h"
 
 Read::Read(string name, string seq, string strand, string quality, bool phred64){
 	mName = name;
@@ -8,6 +9,7 @@ Read::Read(string name, string seq, string strand, string quality, bool phred64)
 	mStrand = strand;
 	mQuality = quality;
 	mHasQuality = true;
+	mProfile.valid = false;
 	if(phred64)
 		convertPhred64To33();
 }
@@ -17,6 +19,7 @@ Read::Read(string name, string seq, string strand){
 	mSeq = Sequence(seq);
 	mStrand = strand;
 	mHasQuality = false;
+	mProfile.valid = false;
 }
 
 Read::Read(string name, Sequence seq, string strand, string quality, bool phred64){
@@ -25,6 +28,7 @@ Read::Read(string name, Sequence seq, string strand, string quality, bool phred6
 	mStrand = strand;
 	mQuality = quality;
 	mHasQuality = true;
+	mProfile.valid = false;
 	if(phred64)
 		convertPhred64To33();
 }
@@ -34,12 +38,11 @@ Read::Read(string name, Sequence seq, string strand){
 	mSeq = seq;
 	mStrand = strand;
 	mHasQuality = false;
+	mProfile.valid = false;
 }
 
 void Read::convertPhred64To33(){
-	for(int i=0; i<mQuality.length(); i++) {
-		mQuality[i] = max(33, mQuality[i] - (64-33));
-	}
+	Simd::phred64To33(&mQuality[0], mQuality.length());
 }
 
 Read::Read(Read &r) {
@@ -48,6 +51,7 @@ Read::Read(Read &r) {
 	mStrand = r.mStrand;
 	mQuality = r.mQuality;
 	mHasQuality = r.mHasQuality;
+	mProfile = r.mProfile;
 }
 
 void Read::print(){
@@ -77,16 +81,89 @@ Read* Read::reverseComplement(){
 void Read::resize(int len) {
 	if(len > length() || len<0)
 		return ;
+	cropProfile(0, len);
 	mSeq.mStr.resize(len);
 	mQuality.resize(len);
 }
    
 void Read::trimFront(int len){
 	len = min(length()-1, len);
+	cropProfile(len, length());
 	mSeq.mStr = mSeq.mStr.substr(len, mSeq.mStr.length() - len);
 	mQuality = mQuality.substr(len, mQuality.length() - len);
 }
 
+void Read::crop(int start, int len) {
+	if(start < 0 || start > length())
+		return;
+	len = max(0, min(len, length() - start));
+	cropProfile(start, start + len);
+	mSeq.mStr = mSeq.mStr.substr(start, len);
+	mQuality = mQuality.substr(start, len);
+}
+
+void Read::setBase(int pos, char base, char qual) {
+	if(mProfile.valid && mProfile.len == length()) {
+		// replace the base in the profile, with its differences to the neighbours
+		const char* seq = mSeq.mStr.c_str();
+		int oldDiff = (pos > 0 && seq[pos-1] != seq[pos]) + (pos+1 < length() && seq[pos] != seq[pos+1]);
+		int newDiff = (pos > 0 && seq[pos-1] != base) + (pos+1 < length() && base != seq[pos+1]);
+		profileBase(pos, -1);
+		mProfile.diff += newDiff - oldDiff;
+		mSeq.mStr[pos] = base;
+		mQuality[pos] = qual;
+		profileBase(pos, 1);
+	} else {
+		mProfile.valid = false;
+		mSeq.mStr[pos] = base;
+		mQuality[pos] = qual;
+	}
+}
+
+ReadProfile& Read::profile(char qualifiedQual) {
+	if(mProfile.valid && mProfile.qualifiedQual == qualifiedQual && mProfile.len == length())
+		return mProfile;
+
+	BaseCounts counts;
+	Simd::countBases(mSeq.mStr.c_str(), mQuality.c_str(), length(), qualifiedQual, &counts);
+	mProfile.valid = true;
+	mProfile.qualifiedQual = qualifiedQual;
+	mProfile.len = length();
+	mProfile.lowQual = counts.lowQual;
+	mProfile.nBase = counts.nBase;
+	mProfile.totalQual = counts.totalQual;
+	mProfile.diff = counts.diff;
+	return mProfile;
+}
+
+void Read::profileBase(int pos, int sign) {
+	mProfile.lowQual += sign * (mQuality[pos] < mProfile.qualifiedQual);
+	mProfile.nBase += sign * (mSeq.mStr[pos] == 'N');
+	mProfile.totalQual += sign * (mQuality[pos] - 33);
+}
+
+void Read::cropProfile(int start, int end) {
+	if(!mProfile.valid)
+		return;
+	// the read was changed without updating the profile
+	if(mProfile.len != length()) {
+		mProfile.valid = false;
+		return;
+	}
+	int len = length();
+	const char* seq = mSeq.mStr.c_str();
+	for(int i=0; i<start; i++)
+		profileBase(i, -1);
+	for(int i=end; i<len; i++)
+		profileBase(i, -1);
+	// the base pairs (i, i+1) with a removed base
+	for(int i=0; i<start && i<len-1; i++)
+		mProfile.diff -= seq[i] != seq[i+1];
+	for(int i=max(end - 1, start); i<len-1; i++)
+		mProfile.diff -= seq[i] != seq[i+1];
+	mProfile.len = end - start;
+}
+
 string Read::lastIndex(){
 	int len = mName.length();
 	if(len<5)
@@ -135,6 +212,30 @@ string Read::toStringWithTag(string tag) {
 	return mName + " " + tag + "\n" + mSeq.mStr + "\n" + mStrand + "\n" + mQuality + "\n";
 }
 
+void Read::appendToString(string* target) {
+	target->append(mName);
+	target->push_back('\n');
+	target->append(mSeq.mStr);
+	target->push_back('\n');
+	target->append(mStrand);
+	target->push_back('\n');
+	target->append(mQuality);
+	target->push_back('\n');
+}
+
+void Read::appendToStringWithTag(string* target, string tag) {
+	target->append(mName);
+	target->push_back(' ');
+	target->append(tag);
+	target->push_back('\n');
+	target->append(mSeq.mStr);
+	target->push_back('\n');
+	target->append(mStrand);
+	target->push_back('\n');
+	target->append(mQuality);
+	target->push_back('\n');
+}
+
 bool Read::fixMGI() {
 	int len = mName.length();
 	if(mName[len-1]=='1' || mName[len-1]=='2') {
@@ -152,7 +253,35 @@ bool Read::test(){
 		"+",
 		"AAAAA6EEEEEEEEEEEEEEEEE#EEEEEEEEEEEEEEEEE/EEEEEEEEEEEEEEEEAEEEAEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEE<EEEEAEEEEEEEEEEEEEEEAEEE/EEEEEEEEEEAAEAEAAEEEAEEAA");
 	string idx = r.lastIndex();
-	return idx == "GGTCCCGA";
+	if(idx != "GGTCCCGA")
+		return false;
+
+	string serialized;
+	r.appendToString(&serialized);
+	if(serialized != r.toString())
+		return false;
+
+	serialized.clear();
+	r.appendToStringWithTag(&serialized, "failed_too_short");
+	if(serialized != r.toStringWithTag("failed_too_short"))
+		return false;
+
+	// the profile updated by trimming and correction is the same as the one counted again
+	Read p("@name", "NNACGGTTNACCCA", "+", "##EEEE#EEE5E#E");
+	p.profile('5');
+	p.trimFront(1);
+	p.resize(12);
+	p.setBase(6, 'G', 'E');
+	p.crop(2, 7);
+	if(!p.mProfile.valid)
+		return false;
+	ReadProfile updated = p.profile('5');
+	Read q("@name", p.mSeq.mStr, "+", p.mQuality);
+	ReadProfile counted = q.profile('5');
+	if(p.mSeq.mStr != "CGGTGNA" || updated.len != 7)
+		return false;
+	return updated.lowQual == counted.lowQual && updated.nBase == counted.nBase
+		&& updated.totalQual == counted.totalQual && updated.diff == counted.diff;
 }
 
 ReadPair::ReadPair(Read* left, Read* right){
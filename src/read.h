@@ -11,6 +11,21 @@
 
 using namespace std;
 
+// the aggregates of a read used by the filters, they are counted in the same pass of the pre-filtering stats
+// and updated incrementally when the read is trimmed, so the filters don't need to scan the read again
+struct ReadProfile {
+    bool valid;
+    // the quality threshold that lowQual is counted with
+    char qualifiedQual;
+    // the length that the aggregates are counted for
+    int len;
+    int lowQual;
+    int nBase;
+    int totalQual;
+    // the number of bases different from the next base, for the low complexity filter
+    int diff;
+};
+
 class Read{
 public:
 	Read(string name, string seq, string strand, string quality, bool phred64=false);
@@ -28,16 +43,28 @@ public:
     int length();
     string toString();
     string toStringWithTag(string tag);
+    // serialize this record to the end of target, no temporary string is created
+    void appendToString(string* target);
+    void appendToStringWithTag(string* target, string tag);
     void resize(int len);
     void convertPhred64To33();
     void trimFront(int len);
+    // keep only the bases in [start, start + len)
+    void crop(int start, int len);
+    // replace a base and its quality, for base correction
+    void setBase(int pos, char base, char qual);
     bool fixMGI();
+    // count the aggregates of the filters in one pass if they are not counted yet
+    ReadProfile& profile(char qualifiedQual);
 
 public:
     static bool test();
 
 private:
-
+    // remove the bases out of [start, end) from the profile, before they are trimmed
+    void cropProfile(int start, int end);
+    // add (sign = 1) or remove (sign = -1) a base to the profile, the base differences are not included
+    void profileBase(int pos, int sign);
 
 public:
 	string mName;
@@ -45,6 +72,7 @@ public:
 	string mStrand;
 	string mQuality;
 	bool mHasQuality;
+    ReadProfile mProfile;
 };
 
 class ReadPair{
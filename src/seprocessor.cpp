@@ -20,12 +20,25 @@ SingleEndProcessor::SingleEndProcessor(Options* opt){
     mZipFile = NULL;
     mUmiProcessor = new UmiProcessor(opt);
     mLeftWriter =  NULL;
+    mSplitWriter = NULL;
+    mPartitionWriter = NULL;
     mFailedWriter = NULL;
 
     mDuplicate = NULL;
-    if(mOptions->duplicate.enabled) {
+    if(mOptions->duplicate.enabled && !mOptions->duplicate.sketch) {
         mDuplicate = new Duplicate(mOptions);
     }
+
+    mDedupSet = NULL;
+    if(mOptions->dedup.enabled) {
+        mDedupSet = new DedupSet(mOptions->dedup.memory);
+    }
+
+    // the adapters of the FASTA file are indexed once for all the reads
+    mAdapterIndex = NULL;
+    if(mOptions->adapter.hasFasta) {
+        mAdapterIndex = new AdapterIndex(mOptions->adapter.seqsInFasta);
+    }
 }
 
 SingleEndProcessor::~SingleEndProcessor() {
@@ -34,14 +47,32 @@ SingleEndProcessor::~SingleEndProcessor() {
         delete mDuplicate;
         mDuplicate = NULL;
     }
+    if(mDedupSet) {
+        delete mDedupSet;
+        mDedupSet = NULL;
+    }
+    if(mAdapterIndex) {
+        delete mAdapterIndex;
+        mAdapterIndex = NULL;
+    }
 }
 
 void SingleEndProcessor::initOutput() {
     if(!mOptions->failedOut.empty())
         mFailedWriter = new WriterThread(mOptions, mOptions->failedOut);
+    // STDOUT or shared memory is written by a writer thread like files, so the workers don't block on it
+    if(mOptions->outputToStream()) {
+        mLeftWriter = new WriterThread(mOptions, mOptions->getStreamOutput());
+        return;
+    }
     if(mOptions->out1.empty())
         return;
-    mLeftWriter = new WriterThread(mOptions, mOptions->out1);
+    if(mOptions->split.enabled)
+        mSplitWriter = new SplitWriter(mOptions, false);
+    else if(mOptions->partition.enabled)
+        mPartitionWriter = new PartitionWriter(mOptions, false);
+    else
+        mLeftWriter = new WriterThread(mOptions, mOptions->out1);
 }
 
 void SingleEndProcessor::closeOutput() {
@@ -49,24 +80,22 @@ void SingleEndProcessor::closeOutput() {
         delete mLeftWriter;
         mLeftWriter = NULL;
     }
+    if(mSplitWriter) {
+        delete mSplitWriter;
+        mSplitWriter = NULL;
+    }
+    if(mPartitionWriter) {
+        delete mPartitionWriter;
+        mPartitionWriter = NULL;
+    }
     if(mFailedWriter) {
         delete mFailedWriter;
         mFailedWriter = NULL;
     }
 }
 
-void SingleEndProcessor::initConfig(ThreadConfig* config) {
-    if(mOptions->out1.empty())
-        return;
-
-    if(mOptions->split.enabled) {
-        config->initWriterForSplit();
-    }
-}
-
 bool SingleEndProcessor::process(){
-    if(!mOptions->split.enabled)
-        initOutput();
+    initOutput();
 
     initPackRepository();
     std::thread producer(std::bind(&SingleEndProcessor::producerTask, this));
@@ -76,7 +105,6 @@ bool SingleEndProcessor::process(){
     ThreadConfig** configs = new ThreadConfig*[mOptions->thread];
     for(int t=0; t<mOptions->thread; t++){
         configs[t] = new ThreadConfig(mOptions, t, false);
-        initConfig(configs[t]);
     }
 
     std::thread** threads = new thread*[mOptions->thread];
@@ -96,12 +124,15 @@ bool SingleEndProcessor::process(){
         threads[t]->join();
     }
 
-    if(!mOptions->split.enabled) {
-        if(leftWriterThread)
-            leftWriterThread->join();
-        if(failedWriterThread)
-            failedWriterThread->join();
-    }
+    if(leftWriterThread)
+        leftWriterThread->join();
+    if(failedWriterThread)
+        failedWriterThread->join();
+    // wait for all split files or partitions to be written
+    if(mSplitWriter)
+        mSplitWriter->close();
+    if(mPartitionWriter)
+        mPartitionWriter->close();
 
     if(mOptions->verbose)
         loginfo("start to generate reports\n");
@@ -144,7 +175,16 @@ bool SingleEndProcessor::process(){
         memset(dupHist, 0, sizeof(int) * mOptions->duplicate.histSize);
         dupMeanGC = new double[mOptions->duplicate.histSize];
         memset(dupMeanGC, 0, sizeof(double) * mOptions->duplicate.histSize);
-        dupRate = mDuplicate->statAll(dupHist, dupMeanGC, mOptions->duplicate.histSize);
+        if(mDuplicate) {
+            dupRate = mDuplicate->statAll(dupHist, dupMeanGC, mOptions->duplicate.histSize);
+        } else {
+            vector<DupSketch*> dupSketches;
+            for(int t=0; t<mOptions->thread; t++)
+                dupSketches.push_back(configs[t]->getDupSketch());
+            DupSketch* dupSketch = DupSketch::merge(dupSketches);
+            dupRate = dupSketch->statAll(dupHist, dupMeanGC, mOptions->duplicate.histSize);
+            delete dupSketch;
+        }
         cerr << endl;
         cerr << "Duplication rate (may be overestimated since this is SE data): " << dupRate * 100.0 << "%" << endl;
     }
@@ -184,27 +224,35 @@ bool SingleEndProcessor::process(){
     if(failedWriterThread)
         delete failedWriterThread;
 
-    if(!mOptions->split.enabled)
-        closeOutput();
+    closeOutput();
 
     return true;
 }
 
 bool SingleEndProcessor::processSingleEnd(ReadPack* pack, ThreadConfig* config){
-    string outstr;
-    string failedOut;
-    int readPassed = 0;
+    // records are serialized directly into the buffers, which are then handed to the writers
+    string* outstr = mSplitWriter ? mSplitWriter->getBuffer() : WriterThread::getOutputBuffer(mLeftWriter);
+    string* failedOut = WriterThread::getOutputBuffer(mFailedWriter);
+    // for splitting output, the end offset of each record in outstr
+    // if splitting by file number, the files are balanced by input reads, so filtered reads are also counted
+    vector<size_t> recordEnds;
+    // for partitioning output, the buffer of each partition
+    vector<string*> partitionOut;
     for(int p=0;p<pack->count;p++){
 
         // original read1
         Read* or1 = pack->data[p];
+        // the position of the read in the input, for sampling the stats
+        long index = pack->index * PACK_SIZE + p;
 
         // stats the original read before trimming
-        config->getPreStats1()->statRead(or1);
+        config->getPreStats1()->statRead(or1, index);
 
         // handling the duplication profiling
         if(mDuplicate)
             mDuplicate->statRead(or1);
+        else if(config->getDupSketch())
+            config->getDupSketch()->statRead(or1);
 
         // filter by index
         if(mOptions->indexFilter.enabled && mFilter->filterByIndex(or1)) {
@@ -212,6 +260,17 @@ bool SingleEndProcessor::processSingleEnd(ReadPack* pack, ThreadConfig* config){
             continue;
         }
 
+        // drop the read if the same sequence has been seen
+        if(mDedupSet && !mDedupSet->add(or1->mSeq.mStr.c_str(), or1->length())) {
+            config->addFilterResult(FAIL_DUPLICATE, 1);
+            if(mFailedWriter)
+                or1->appendToStringWithTag(failedOut, FAILED_TYPES[FAIL_DUPLICATE]);
+            if(mSplitWriter && mOptions->split.byFileNumber)
+                recordEnds.push_back(outstr->size());
+            delete or1;
+            continue;
+        }
+
         // fix MGI
         if(mOptions->fixMGI) {
             or1->fixMGI();
@@ -236,7 +295,7 @@ bool SingleEndProcessor::processSingleEnd(ReadPack* pack, ThreadConfig* config){
                 trimmed = AdapterTrimmer::trimBySequence(r1, config->getFilterResult(), mOptions->adapter.sequence, false);
             bool incTrimmedCounter = !trimmed;
             if(mOptions->adapter.hasFasta) {
-                AdapterTrimmer::trimByMultiSequences(r1, config->getFilterResult(), mOptions->adapter.seqsInFasta, false, incTrimmedCounter);
+                AdapterTrimmer::trimByMultiSequences(r1, config->getFilterResult(), mOptions->adapter.seqsInFasta, false, incTrimmedCounter, mAdapterIndex, config->getReadSeeds());
             }
         }
 
@@ -255,13 +314,20 @@ bool SingleEndProcessor::processSingleEnd(ReadPack* pack, ThreadConfig* config){
         config->addFilterResult(result, 1);
 
         if( r1 != NULL &&  result == PASS_FILTER) {
-            outstr += r1->toString();
+            if(mPartitionWriter)
+                r1->appendToString(mPartitionWriter->getBuffer(partitionOut, PartitionWriter::getPartition(r1->mName, mOptions->partition.number)));
+            else if(outstr)
+                r1->appendToString(outstr);
 
             // stats the read after filtering
-            config->getPostStats1()->statRead(r1);
-            readPassed++;
-        } else if(mFailedWriter) {
-            failedOut += or1->toStringWithTag(FAILED_TYPES[result]);
+            config->getPostStats1()->statRead(r1, index);
+            if(mSplitWriter)
+                recordEnds.push_back(outstr->size());
+        } else {
+            if(mFailedWriter)
+                or1->appendToStringWithTag(failedOut, FAILED_TYPES[result]);
+            if(mSplitWriter && mOptions->split.byFileNumber)
+                recordEnds.push_back(outstr->size());
         }
 
         delete or1;
@@ -269,35 +335,18 @@ bool SingleEndProcessor::processSingleEnd(ReadPack* pack, ThreadConfig* config){
         if(r1 != or1 && r1 != NULL)
             delete r1;
     }
-    // if splitting output, then no lock is need since different threads write different files
-    if(!mOptions->split.enabled)
-        mOutputMtx.lock();
-    if(mOptions->outputToSTDOUT) {
-        fwrite(outstr.c_str(), 1, outstr.length(), stdout);
-    } else if(mOptions->split.enabled) {
-        // split output by each worker thread
-        if(!mOptions->out1.empty())
-            config->getWriter1()->writeString(outstr);
-    } 
-
-    if(mLeftWriter) {
-        char* ldata = new char[outstr.size()];
-        memcpy(ldata, outstr.c_str(), outstr.size());
-        mLeftWriter->input(ldata, outstr.size());
-    }
-    if(mFailedWriter && !failedOut.empty()) {
-        // write failed data
-        char* fdata = new char[failedOut.size()];
-        memcpy(fdata, failedOut.c_str(), failedOut.size());
-        mFailedWriter->input(fdata, failedOut.size());
+    mOutputMtx.lock();
+    if(mSplitWriter) {
+        // the split writer decides which file each record goes to
+        mSplitWriter->input(outstr, recordEnds);
+    } else {
+        if(mPartitionWriter)
+            mPartitionWriter->input(partitionOut);
+        WriterThread::outputBuffer(mLeftWriter, outstr);
     }
-    if(!mOptions->split.enabled)
-        mOutputMtx.unlock();
-
-    if(mOptions->split.byFileLines)
-        config->markProcessed(readPassed);
-    else
-        config->markProcessed(pack->count);
+    // write failed data
+    WriterThread::outputBuffer(mFailedWriter, failedOut);
+    mOutputMtx.unlock();
 
     delete pack->data;
     delete pack;
@@ -326,6 +375,7 @@ void SingleEndProcessor::producePack(ReadPack* pack){
         //mRepo.repoNotFull.wait(lock);
     }*/
 
+    pack->index = mRepo.writePos;
     mRepo.packBuffer[mRepo.writePos] = pack;
     mRepo.writePos++;
 
@@ -428,28 +478,29 @@ void SingleEndProcessor::producerTask()
             readNum += count;
             // if the writer threads are far behind this producer, sleep and wait
             // check this only when necessary
-            if(readNum % (PACK_SIZE * PACK_IN_MEM_LIMIT) == 0 && mLeftWriter) {
-                while(mLeftWriter->bufferLength() > PACK_IN_MEM_LIMIT) {
+            if(readNum % (PACK_SIZE * PACK_IN_MEM_LIMIT) == 0 && (mLeftWriter || mSplitWriter || mPartitionWriter)) {
+                while( (mLeftWriter && mLeftWriter->bufferLength() > PACK_IN_MEM_LIMIT) || (mSplitWriter && mSplitWriter->bufferLength() > PACK_IN_MEM_LIMIT)
+                    || (mPartitionWriter && mPartitionWriter->bufferLength() > PACK_IN_MEM_LIMIT) ) {
                     slept++;
                     usleep(1000);
                 }
             }
             // reset count to 0
             count = 0;
-            // re-evaluate split size
-            // TODO: following codes are commented since it may cause threading related conflicts in some systems
-            /*if(mOptions->split.needEvaluation && !splitSizeReEvaluated && readNum >= mOptions->split.size) {
+            // re-evaluate split size with the reads loaded, the split writer applies it from the file being written
+            if(mSplitWriter && mOptions->split.needEvaluation && !splitSizeReEvaluated && readNum >= mOptions->split.size) {
                 splitSizeReEvaluated = true;
                 // greater than the initial evaluation
                 if(readNum >= 1024*1024) {
                     size_t bytesRead;
                     size_t bytesTotal;
                     reader.getBytes(bytesRead, bytesTotal);
-                    mOptions->split.size *=  (double)bytesTotal / ((double)bytesRead * (double) mOptions->split.number);
-                    if(mOptions->split.size <= 0)
-                        mOptions->split.size = 1;
+                    if(bytesRead > 0) {
+                        long splitSize = (double)readNum * (double)bytesTotal / ((double)bytesRead * (double) mOptions->split.number);
+                        mSplitWriter->setSplitSize(splitSize);
+                    }
                 }
-            }*/
+            }
         }
     }
 
@@ -467,10 +518,6 @@ void SingleEndProcessor::producerTask()
 void SingleEndProcessor::consumerTask(ThreadConfig* config)
 {
     while(true) {
-        if(config->canBeStopped()){
-            mFinishedThreads++;
-            break;
-        }
         while(mRepo.writePos <= mRepo.readPos) {
             if(mProduceFinished)
                 break;
@@ -14,13 +14,19 @@
 #include "filter.h"
 #include "umiprocessor.h"
 #include "writerthread.h"
+#include "splitwriter.h"
+#include "partitionwriter.h"
 #include "duplicate.h"
+#include "dedupset.h"
+#include "adapterindex.h"
 
 using namespace std;
 
 struct ReadPack {
     Read** data;
     int count;
+    // the sequence number of the pack in the input, the reads before it are index * PACK_SIZE
+    long index;
 };
 
 typedef struct ReadPack ReadPack;
@@ -51,7 +57,6 @@ private:
     void consumePack(ThreadConfig* config);
     void producerTask();
     void consumerTask(ThreadConfig* config);
-    void initConfig(ThreadConfig* config);
     void initOutput();
     void closeOutput();
     void writeTask(WriterThread* config);
@@ -68,8 +73,12 @@ private:
     ofstream* mOutStream;
     UmiProcessor* mUmiProcessor;
     WriterThread* mLeftWriter;
+    SplitWriter* mSplitWriter;
+    PartitionWriter* mPartitionWriter;
     WriterThread* mFailedWriter;
     Duplicate* mDuplicate;
+    DedupSet* mDedupSet;
+    AdapterIndex* mAdapterIndex;
 };
 
 
@@ -1,4 +1,5 @@
 #include "sequence.h"
+#include "simd.h"
 
 Sequence::Sequence(){
 }
@@ -17,29 +18,7 @@ int Sequence::length(){
 
 Sequence Sequence::reverseComplement(){
     string str(mStr.length(), 0);
-    for(int c=0;c<mStr.length();c++){
-        char base = mStr[c];
-        switch(base){
-            case 'A':
-            case 'a':
-                str[mStr.length()-c-1] = 'T';
-                break;
-            case 'T':
-            case 't':
-                str[mStr.length()-c-1] = 'A';
-                break;
-            case 'C':
-            case 'c':
-                str[mStr.length()-c-1] = 'G';
-                break;
-            case 'G':
-            case 'g':
-                str[mStr.length()-c-1] = 'C';
-                break;
-            default:
-                str[mStr.length()-c-1] = 'N';
-        }
-    }
+    Simd::reverseComplement(mStr.c_str(), &str[0], mStr.length());
     return Sequence(str);
 }
 
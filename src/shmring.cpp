@@ -0,0 +1,265 @@
+#include "shmring.h"
+#include "util.h"
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <errno.h>
+#include <stddef.h>
+#include <time.h>
+#include <thread>
+
+ShmRing::ShmRing(){
+    mNonce = 0;
+    mHeader = NULL;
+    mBase = NULL;
+    mMappedSize = 0;
+}
+
+ShmRing::~ShmRing() {
+    unmap();
+}
+
+void ShmRing::unmap() {
+    if(mBase) {
+        munmap(mBase, mMappedSize);
+        mBase = NULL;
+        mHeader = NULL;
+        mMappedSize = 0;
+    }
+}
+
+bool ShmRing::create(string name, uint32_t slotCount, uint64_t slotSize) {
+    mName = name;
+    // remove the stale one, otherwise a consumer may attach to it
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+    if(fd < 0)
+        return false;
+
+    mMappedSize = SHM_RING_HEADER_SIZE + (size_t)slotCount * (sizeof(uint64_t) + slotSize);
+    if(ftruncate(fd, mMappedSize) != 0) {
+        close(fd);
+        return false;
+    }
+    void* addr = mmap(NULL, mMappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(addr == MAP_FAILED)
+        return false;
+
+    mBase = (char*)addr;
+    mHeader = (ShmRingHeader*)mBase;
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    mNonce = ((uint64_t)getpid() << 32) ^ ((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+    mHeader->nonce = mNonce;
+    mHeader->producerPid = getpid();
+    mHeader->version = SHM_RING_VERSION;
+    mHeader->slotCount = slotCount;
+    mHeader->slotSize = slotSize;
+    mHeader->writeSeq.store(0, memory_order_relaxed);
+    mHeader->readSeq.store(0, memory_order_relaxed);
+    mHeader->finished.store(0, memory_order_relaxed);
+    // the magic is stored at last, so a consumer sees the other fields once it sees the magic
+    mHeader->magic.store(SHM_RING_MAGIC, memory_order_release);
+    return true;
+}
+
+bool ShmRing::attach(string name) {
+    mName = name;
+    int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    if(fd < 0)
+        return false;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size < SHM_RING_HEADER_SIZE) {
+        close(fd);
+        return false;
+    }
+    mMappedSize = st.st_size;
+    void* addr = mmap(NULL, mMappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(addr == MAP_FAILED)
+        return false;
+
+    mBase = (char*)addr;
+    mHeader = (ShmRingHeader*)mBase;
+    // no other field is read before the magic
+    if(mHeader->magic.load(memory_order_acquire) != SHM_RING_MAGIC || mHeader->version != SHM_RING_VERSION
+        || mMappedSize < SHM_RING_HEADER_SIZE + (size_t)mHeader->slotCount * (sizeof(uint64_t) + mHeader->slotSize)) {
+        unmap();
+        return false;
+    }
+    mNonce = mHeader->nonce;
+    // the rings left by the earlier runs, a finished one which is fully read, or an unfinished one of a crashed producer
+    bool finished = mHeader->finished.load(memory_order_acquire) == 1;
+    bool drained = mHeader->readSeq.load(memory_order_acquire) == mHeader->writeSeq.load(memory_order_acquire);
+    if((finished && drained) || stale()) {
+        unmap();
+        return false;
+    }
+    return true;
+}
+
+bool ShmRing::stale() {
+    if(mHeader->finished.load(memory_order_acquire) == 1)
+        return false;
+    if(kill(mHeader->producerPid, 0) != 0 && errno == ESRCH)
+        return true;
+    // the name may be removed or taken by the ring of another run
+    int fd = shm_open(mName.c_str(), O_RDONLY, 0600);
+    if(fd < 0)
+        return true;
+    uint64_t nonce = 0;
+    bool replaced = pread(fd, &nonce, sizeof(nonce), offsetof(ShmRingHeader, nonce)) != sizeof(nonce) || nonce != mNonce;
+    close(fd);
+    return replaced;
+}
+
+char* ShmRing::slot(uint64_t seq) {
+    return mBase + SHM_RING_HEADER_SIZE + (seq % mHeader->slotCount) * (sizeof(uint64_t) + mHeader->slotSize);
+}
+
+bool ShmRing::publish(const char* data, size_t size) {
+    while(size > mHeader->slotSize) {
+        // cut at the end of the last record that fits in a slot, a record has 4 lines
+        size_t cut = 0;
+        int lines = 0;
+        for(size_t i=0; i<mHeader->slotSize; i++) {
+            if(data[i] == '\n') {
+                lines++;
+                if(lines % 4 == 0)
+                    cut = i + 1;
+            }
+        }
+        if(cut == 0)
+            error_exit("a record is longer than the slot of shared memory output, please increase --shm_slot_size");
+        if(!publishSlot(data, cut))
+            return false;
+        data += cut;
+        size -= cut;
+    }
+    if(size == 0)
+        return true;
+    return publishSlot(data, size);
+}
+
+bool ShmRing::publishSlot(const char* data, size_t size) {
+    uint64_t seq = mHeader->writeSeq.load(memory_order_relaxed);
+    // wait for the consumer if the ring is full
+    while(seq - mHeader->readSeq.load(memory_order_acquire) >= mHeader->slotCount)
+        usleep(100);
+
+    char* s = slot(seq);
+    uint64_t payloadSize = size;
+    memcpy(s, &payloadSize, sizeof(uint64_t));
+    memcpy(s + sizeof(uint64_t), data, size);
+    mHeader->writeSeq.store(seq + 1, memory_order_release);
+    return true;
+}
+
+void ShmRing::finish() {
+    if(mHeader)
+        mHeader->finished.store(1, memory_order_release);
+}
+
+bool ShmRing::next(const char*& data, size_t& size) {
+    uint64_t seq = mHeader->readSeq.load(memory_order_relaxed);
+    for(int waits=1; ; waits++) {
+        // read finished before writeSeq, so no published slot is missed
+        bool finished = mHeader->finished.load(memory_order_acquire) == 1;
+        if(seq < mHeader->writeSeq.load(memory_order_acquire))
+            break;
+        if(finished)
+            return false;
+        // check the producer every 0.1 second of waiting
+        if(waits % 1000 == 0 && stale())
+            return false;
+        usleep(100);
+    }
+
+    char* s = slot(seq);
+    uint64_t payloadSize;
+    memcpy(&payloadSize, s, sizeof(uint64_t));
+    data = s + sizeof(uint64_t);
+    size = payloadSize;
+    return true;
+}
+
+void ShmRing::release() {
+    mHeader->readSeq.fetch_add(1, memory_order_release);
+}
+
+bool ShmRing::test() {
+    string name = "/fastp_shmring_test_" + to_string(getpid());
+    // the name is unlinked on every return, so a failed test leaves nothing behind for the next run
+    struct Unlinker {
+        string name;
+        ~Unlinker() {shm_unlink(name.c_str());}
+    } unlinker = {name};
+    ShmRing producer;
+    if(!producer.create(name, 2, 64))
+        return false;
+    ShmRing consumer;
+    if(!consumer.attach(name))
+        return false;
+
+    // each record is 16 bytes, so 4 of them fill a slot
+    string records;
+    for(int i=0; i<10; i++)
+        records += "@r" + to_string(i) + "\nACGT\n+\nEEEE\n";
+    string expected = records + records;
+
+    std::thread t([&producer, &records](){
+        producer.publish(records.data(), records.size());
+        producer.publish(records.data(), records.size());
+        producer.finish();
+    });
+
+    string received;
+    const char* data;
+    size_t size;
+    bool passed = true;
+    while(consumer.next(data, size)) {
+        if(size > 64 || size == 0 || data[size - 1] != '\n')
+            passed = false;
+        received.append(data, size);
+        consumer.release();
+    }
+    t.join();
+    if(!passed || received != expected)
+        return false;
+
+    // the finished ring which is fully read is not attached again
+    ShmRing drained;
+    if(drained.attach(name))
+        return false;
+
+    // the ring of a crashed producer is not attached
+    ShmRing crashed;
+    if(!crashed.create(name, 2, 64))
+        return false;
+    pid_t child = fork();
+    if(child == 0)
+        _exit(0);
+    waitpid(child, NULL, 0);
+    crashed.mHeader->producerPid = child;
+    ShmRing orphan;
+    if(orphan.attach(name))
+        return false;
+
+    // the ring replaced by a new run is stale for the consumer attached to it
+    ShmRing first;
+    if(!first.create(name, 2, 64))
+        return false;
+    ShmRing waiting;
+    if(!waiting.attach(name) || waiting.stale())
+        return false;
+    ShmRing second;
+    if(!second.create(name, 2, 64))
+        return false;
+    return waiting.stale() && !waiting.next(data, size);
+}
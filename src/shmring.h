@@ -0,0 +1,101 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string>
+#include <atomic>
+
+using namespace std;
+
+/*
+ A ring of FASTQ packs in POSIX shared memory, written by fastp and read by one consumer on the same host.
+
+ The shared memory object (shm_open name, like /fastp_out) is laid out as:
+     ShmRingHeader, padded to 4096 bytes
+     slot 0, slot 1, ... slot (slotCount - 1), each slot takes (8 + slotSize) bytes
+ A slot starts with a uint64_t payload size, followed by the payload, which is always complete FASTQ records
+ (interleaved for paired-end output). The records are in the same order as they would be written to STDOUT.
+
+ Protocol (single producer, single consumer):
+     1, the producer creates the object, initializes the header and stores magic at last with release ordering.
+        A consumer should load magic with acquire ordering before reading any other field of the header,
+        wait until it is "FASTPSHM" (little-endian uint64) and check version.
+        The ring of a run is identified by nonce. A consumer should skip a ring which is finished and fully read,
+        or not finished but its producer process is gone, since they are left by the earlier runs.
+        If the name is replaced by the ring of another run while waiting, the old ring is not written any more.
+     2, message n is in slot (n % slotCount). The producer fills slot n only when n - readSeq < slotCount,
+        then increases writeSeq to n + 1 with release ordering.
+     3, the consumer reads slot readSeq when readSeq < writeSeq (acquire ordering), and increases readSeq
+        after the payload is no longer used, so it can process the payload in place without copying.
+     4, when all packs are published, the producer sets finished to 1.
+        The consumer reads finished before writeSeq, and stops when finished is 1 and readSeq == writeSeq.
+     5, the producer doesn't unlink the object, since the consumer can be started later.
+        The consumer should shm_unlink it after reading all the packs.
+ The producer blocks when the ring is full, like writing a pipe.
+*/
+
+// "FASTPSHM" read as a little-endian uint64
+#define SHM_RING_MAGIC 0x4D48535054534146ULL
+#define SHM_RING_VERSION 2
+#define SHM_RING_HEADER_SIZE 4096
+
+struct ShmRingHeader {
+    // stored at last, when the other fields are ready
+    atomic<uint64_t> magic;
+    // a random number of the run that created the ring
+    uint64_t nonce;
+    // the process id of the producer
+    uint32_t producerPid;
+    uint32_t version;
+    uint32_t slotCount;
+    uint64_t slotSize;
+    // number of the slots published by the producer
+    atomic<uint64_t> writeSeq;
+    // number of the slots released by the consumer
+    atomic<uint64_t> readSeq;
+    // set to 1 when the producer will not publish any more
+    atomic<uint32_t> finished;
+};
+
+class ShmRing{
+public:
+    ShmRing();
+    ~ShmRing();
+
+    // for the producer, create the ring, an existing one with the same name is replaced
+    bool create(string name, uint32_t slotCount, uint64_t slotSize);
+    // for the consumer, attach to an existing ring, it fails if the ring is not ready or left by an earlier run
+    bool attach(string name);
+
+    // producer: publish the records, they can be divided to several slots if they are too long for a slot
+    bool publish(const char* data, size_t size);
+    // producer: mark the end of the stream
+    void finish();
+
+    // consumer: get the payload of next slot, it waits until there is one
+    // returns false if the stream is finished, or the ring is stale()
+    bool next(const char*& data, size_t& size);
+    // consumer: the ring is not finished, but its name is removed or replaced by another run, or its producer is gone
+    bool stale();
+    // consumer: release the slot returned by next(), so the producer can reuse it
+    void release();
+
+    uint64_t slotSize() {return mHeader ? mHeader->slotSize : 0;}
+    static bool test();
+
+private:
+    char* slot(uint64_t seq);
+    bool publishSlot(const char* data, size_t size);
+    void unmap();
+
+private:
+    string mName;
+    uint64_t mNonce;
+    ShmRingHeader* mHeader;
+    char* mBase;
+    size_t mMappedSize;
+};
+
+#endif
@@ -0,0 +1,285 @@
+#include "simd.h"
+#include <string.h>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static void scalarReverseComplement(const char* src, char* dst, int len) {
+    for(int i=0; i<len; i++)
+        dst[len - 1 - i] = complementBase(src[i]);
+}
+
+static void scalarPhred64To33(char* qual, int len) {
+    for(int i=0; i<len; i++) {
+        int q = qual[i] - (64 - 33);
+        qual[i] = q < 33 ? 33 : q;
+    }
+}
+
+static void scalarCountBases(const char* seq, const char* qual, int len, char qualifiedQual, BaseCounts* counts) {
+    memset(counts, 0, sizeof(BaseCounts));
+    countBaseRange(seq, qual, 0, len, qualifiedQual, counts);
+    countDiffRange(seq, 0, len, counts);
+}
+
+static int scalarFindAdapter(const char* read, int rlen, const char* adapter, int alen, int start, int end) {
+    return findAdapterRange(countMismatchRange, read, rlen, adapter, alen, start, end);
+}
+
+static int scalarFindOverlap(const char* str1, int len1, const char* str2, int len2, int diffLimit, int overlapRequire, double diffPercentLimit,
+                          const int* probes, int probeCount, int* offset, int* overlapLen, int* diff) {
+    return findOverlapRange(countMismatchRange, str1, len1, str2, len2, diffLimit, overlapRequire, diffPercentLimit, probes, probeCount, offset, overlapLen, diff);
+}
+
+SimdKernels* Simd::scalarKernels() {
+    static SimdKernels kernels = {"scalar", scalarReverseComplement, scalarPhred64To33, scalarCountBases, scalarFindAdapter, scalarFindOverlap, alignBandRange};
+    return &kernels;
+}
+
+int Simd::supportedKernels(SimdKernels** kernels) {
+    int count = 0;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if(!__builtin_cpu_supports("popcnt"))
+        return 0;
+    if(sse42Kernels() && __builtin_cpu_supports("sse4.2"))
+        kernels[count++] = sse42Kernels();
+    if(avx2Kernels() && __builtin_cpu_supports("avx2"))
+        kernels[count++] = avx2Kernels();
+    if(avx512Kernels() && __builtin_cpu_supports("avx512bw"))
+        kernels[count++] = avx512Kernels();
+#endif
+    return count;
+}
+
+SimdKernels* Simd::select() {
+    SimdKernels* kernels[SIMD_MAX_KERNELS];
+    int count = supportedKernels(kernels);
+    if(count == 0)
+        return scalarKernels();
+    return kernels[count - 1];
+}
+
+SimdKernels* Simd::mKernels = Simd::select();
+
+// the byte loops of Sequence::reverseComplement() and Read::convertPhred64To33() before the kernels, which are kept to test them
+static string legacyReverseComplement(const string& seq) {
+    string str(seq.length(), 0);
+    for(int c=0; c<seq.length(); c++) {
+        switch(seq[c]) {
+            case 'A':
+            case 'a':
+                str[seq.length()-c-1] = 'T';
+                break;
+            case 'T':
+            case 't':
+                str[seq.length()-c-1] = 'A';
+                break;
+            case 'C':
+            case 'c':
+                str[seq.length()-c-1] = 'G';
+                break;
+            case 'G':
+            case 'g':
+                str[seq.length()-c-1] = 'C';
+                break;
+            default:
+                str[seq.length()-c-1] = 'N';
+        }
+    }
+    return str;
+}
+
+static string legacyPhred64To33(string qual) {
+    for(int i=0; i<qual.length(); i++)
+        qual[i] = max(33, qual[i] - (64-33));
+    return qual;
+}
+
+// the counting of Stats::statRead(), Filter::passFilter() and Filter::passLowComplexityFilter() before the kernels
+static void legacyCountBases(const string& seq, const string& qual, char qualifiedQual, BaseCounts* counts) {
+    memset(counts, 0, sizeof(BaseCounts));
+    for(int i=0; i<seq.length(); i++) {
+        char base = seq[i];
+        char q = qual[i];
+        char b = base & 0x07;
+        if(q >= '?') {
+            counts->q30++;
+            counts->q20++;
+        } else if(q >= '5') {
+            counts->q20++;
+        }
+        if(b == ('G' & 0x07) || b == ('C' & 0x07))
+            counts->gc++;
+
+        counts->totalQual += q - 33;
+        if(q < qualifiedQual)
+            counts->lowQual++;
+        if(base == 'N')
+            counts->nBase++;
+    }
+    for(int i=0; i<(int)seq.length()-1; i++) {
+        if(seq[i] != seq[i+1])
+            counts->diff++;
+    }
+}
+
+bool Simd::test() {
+    // all the kernels supported by this CPU are compared with the scalar ones
+    SimdKernels* kernels[SIMD_MAX_KERNELS];
+    int count = supportedKernels(kernels);
+    SimdKernels* scalar = scalarKernels();
+
+    // the bytes of reads, with lowercase and other letters, and the bytes >= 128
+    const char alphabet[] = "ACGTACGTACGTNacgtnRYSWKM.-\x80\xff";
+    unsigned int seed = 1;
+    for(int len=0; len<=300; len++) {
+        string seq(len, 'A');
+        string qual(len, 'I');
+        for(int i=0; i<len; i++) {
+            seed = seed * 1103515245 + 12345;
+            seq[i] = alphabet[(seed >> 16) % (sizeof(alphabet) - 1)];
+            seed = seed * 1103515245 + 12345;
+            // mostly valid qualities, and some out of range ones
+            int q = (seed >> 16) % 100;
+            qual[i] = q < 90 ? (char)(33 + q % 75) : (char)(q * 37);
+        }
+        // runs of a same base for the base differences
+        if(len > 20)
+            seq.replace(5, 10, 10, 'G');
+
+        string rcExpected(len, 0);
+        scalar->reverseComplement(seq.c_str(), &rcExpected[0], len);
+        string phredExpected = qual;
+        scalar->phred64To33(&phredExpected[0], len);
+        BaseCounts countsExpected;
+        scalar->countBases(seq.c_str(), qual.c_str(), len, '0', &countsExpected);
+
+        // the scalar kernels give the same bytes and counts as the loops before them
+        BaseCounts legacyCounts;
+        legacyCountBases(seq, qual, '0', &legacyCounts);
+        if(rcExpected != legacyReverseComplement(seq) || phredExpected != legacyPhred64To33(qual)
+            || memcmp(&legacyCounts, &countsExpected, sizeof(BaseCounts)) != 0) {
+            cerr << "Simd::test: scalar is different from the legacy loops, len = " << len << endl;
+            return false;
+        }
+
+        for(int k=0; k<count; k++) {
+            string rc(len, 0);
+            kernels[k]->reverseComplement(seq.c_str(), &rc[0], len);
+            string phred = qual;
+            kernels[k]->phred64To33(&phred[0], len);
+            BaseCounts counts;
+            kernels[k]->countBases(seq.c_str(), qual.c_str(), len, '0', &counts);
+            if(rc != rcExpected || phred != phredExpected || memcmp(&counts, &countsExpected, sizeof(BaseCounts)) != 0) {
+                cerr << "Simd::test: " << kernels[k]->name << " is different from scalar, len = " << len << endl;
+                return false;
+            }
+        }
+
+        // the adapters are planted in the read with some mismatches, and also cut by the read end
+        for(int alen=4; alen<=82; alen+=6) {
+            string adapter(alen, 'A');
+            for(int i=0; i<alen; i++) {
+                seed = seed * 1103515245 + 12345;
+                adapter[i] = alphabet[(seed >> 16) % (sizeof(alphabet) - 1)];
+            }
+            string read = seq;
+            seed = seed * 1103515245 + 12345;
+            int planted = (seed >> 16) % (len + 1);
+            for(int i=0; i<alen && planted + i < len; i++) {
+                seed = seed * 1103515245 + 12345;
+                read[planted + i] = (seed >> 16) % 10 == 0 ? 'N' : adapter[i];
+            }
+            int start = -(alen % 5);
+            int expected = scalar->findAdapter(read.c_str(), len, adapter.c_str(), alen, start, len - 4);
+            for(int k=0; k<count; k++) {
+                if(kernels[k]->findAdapter(read.c_str(), len, adapter.c_str(), alen, start, len - 4) != expected) {
+                    cerr << "Simd::test: " << kernels[k]->name << " finds a different adapter position, len = " << len << ", adapter len = " << alen << endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    // read1 and read2 of a same fragment with some mismatches, and the pairs of different fragments
+    for(int n=0; n<2000; n++) {
+        seed = seed * 1103515245 + 12345;
+        int len1 = (seed >> 16) % 200;
+        seed = seed * 1103515245 + 12345;
+        int len2 = (seed >> 16) % 200;
+        seed = seed * 1103515245 + 12345;
+        int shift = (int)((seed >> 16) % (len1 + len2 + 1)) - len2;
+        string str1(len1, 'A');
+        string str2(len2, 'A');
+        for(int i=0; i<len1; i++) {
+            seed = seed * 1103515245 + 12345;
+            str1[i] = alphabet[(seed >> 16) % (sizeof(alphabet) - 1)];
+        }
+        for(int i=0; i<len2; i++) {
+            seed = seed * 1103515245 + 12345;
+            bool same = n % 3 != 0 && shift + i >= 0 && shift + i < len1 && (seed >> 16) % 30 != 0;
+            str2[i] = same ? str1[shift + i] : alphabet[(seed >> 20) % (sizeof(alphabet) - 1)];
+        }
+        // some pairs have the offsets to try first, which can be out of range or not matched
+        int probes[3] = {shift, shift + 7, -shift};
+        int probeCount = n % 4;
+        int expected[4];
+        expected[0] = scalar->findOverlap(str1.c_str(), len1, str2.c_str(), len2, n % 6, n % 35, 0.2, probes, probeCount, expected + 1, expected + 2, expected + 3);
+        for(int k=0; k<count; k++) {
+            int result[4];
+            result[0] = kernels[k]->findOverlap(str1.c_str(), len1, str2.c_str(), len2, n % 6, n % 35, 0.2, probes, probeCount, result + 1, result + 2, result + 3);
+            if(result[0] != expected[0] || (expected[0] && memcmp(result, expected, sizeof(int) * 4) != 0)) {
+                cerr << "Simd::test: " << kernels[k]->name << " finds a different overlap, len1 = " << len1 << ", len2 = " << len2 << endl;
+                return false;
+            }
+        }
+    }
+
+    // the tail of read1 and read2 with the indels of a few bases, aligned in the band around the offset
+    for(int n=0; n<3000; n++) {
+        seed = seed * 1103515245 + 12345;
+        int len1 = 1 + (seed >> 16) % 300;
+        seed = seed * 1103515245 + 12345;
+        int len2 = 1 + (seed >> 16) % 300;
+        seed = seed * 1103515245 + 12345;
+        int center = (seed >> 16) % len1;
+        // str1 is read with the guard bytes on each side
+        string padded(len1 + 2 * OVERLAP_GAP_LANES, 0);
+        char* str1 = &padded[OVERLAP_GAP_LANES];
+        for(int i=0; i<len1; i++) {
+            seed = seed * 1103515245 + 12345;
+            str1[i] = "ACGT"[(seed >> 16) % 4];
+        }
+        string str2;
+        int i = center;
+        while(i < len1 && (int)str2.length() < len2) {
+            seed = seed * 1103515245 + 12345;
+            int r = (seed >> 16) % 100;
+            if(r < 2)
+                i += 1 + r;
+            else if(r < 4)
+                str2.append(r - 1, 'C');
+            else
+                str2 += r < 8 ? 'N' : str1[i++];
+        }
+        while((int)str2.length() < len2)
+            str2 += 'T';
+        int costLimit = n % 4 == 0 ? 254 : n % 20;
+        int expectedRow = 0;
+        int expected = scalar->alignBand(str1, len1, str2.c_str(), len2, center, costLimit, &expectedRow);
+        for(int k=0; k<count; k++) {
+            int row = 0;
+            int result = kernels[k]->alignBand(str1, len1, str2.c_str(), len2, center, costLimit, &row);
+            if(result != expected || row != expectedRow) {
+                cerr << "Simd::test: " << kernels[k]->name << " aligns the band differently, len1 = " << len1 << ", len2 = " << len2 << endl;
+                return false;
+            }
+        }
+    }
+
+    string rc(8, 0);
+    scalar->reverseComplement("AcGtNxTG", &rc[0], 8);
+    return rc == "CANNACGT";
+}
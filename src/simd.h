@@ -0,0 +1,274 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// only plain C types here, since this header is also included by the sources built with -mavx2/-mavx512bw
+// and their instances of the inline functions of STL could be picked by the linker for the whole program
+
+// the number of the instruction sets that have kernels
+#define SIMD_MAX_KERNELS 3
+
+// the counts of a read, see Simd::countBases()
+struct BaseCounts {
+    int q20;
+    int q30;
+    // the bases with last 2 bits 11, the same as the G/C of the base content stats
+    int gc;
+    int lowQual;
+    int nBase;
+    int totalQual;
+    // the number of bases different from the next base
+    int diff;
+};
+
+// the kernels of an instruction set, they give the same results as the scalar ones
+struct SimdKernels {
+    const char* name;
+    // dst[len - 1 - i] is the complement of src[i], ACGT (and acgt) are complemented, others are N
+    void (*reverseComplement)(const char* src, char* dst, int len);
+    // qual[i] = max(33, qual[i] - 31)
+    void (*phred64To33)(char* qual, int len);
+    void (*countBases)(const char* seq, const char* qual, int len, char qualifiedQual, BaseCounts* counts);
+    // the first pos in [start, end) where the adapter matches the read, or end if none, see findAdapterRange()
+    int (*findAdapter)(const char* read, int rlen, const char* adapter, int alen, int start, int end);
+    // 1 if read1 and the reverse complement of read2 overlap, see findOverlapRange()
+    int (*findOverlap)(const char* str1, int len1, const char* str2, int len2, int diffLimit, int overlapRequire, double diffPercentLimit,
+                       const int* probes, int probeCount, int* offset, int* overlapLen, int* diff);
+    // the best state of the banded gapped alignment ending at the end of str1, see alignBandRange()
+    int (*alignBand)(const char* str1, int len1, const char* str2, int len2, int center, int costLimit, int* endRow);
+};
+
+// the complement of a base, shared by the tails of all the kernels
+static inline char complementBase(char base) {
+    switch(base) {
+        case 'A':
+        case 'a':
+            return 'T';
+        case 'T':
+        case 't':
+            return 'A';
+        case 'C':
+        case 'c':
+            return 'G';
+        case 'G':
+        case 'g':
+            return 'C';
+        default:
+            return 'N';
+    }
+}
+
+// count the bases in [start, end) except the base differences
+static inline void countBaseRange(const char* seq, const char* qual, int start, int end, char qualifiedQual, BaseCounts* counts) {
+    for(int i=start; i<end; i++) {
+        counts->q20 += qual[i] >= '5';
+        counts->q30 += qual[i] >= '?';
+        counts->gc += (seq[i] & 0x03) == 0x03;
+        counts->lowQual += qual[i] < qualifiedQual;
+        counts->nBase += seq[i] == 'N';
+        counts->totalQual += qual[i] - 33;
+    }
+}
+
+// count the base differences (i, i + 1) for i in [start, len - 1)
+static inline void countDiffRange(const char* seq, int start, int len, BaseCounts* counts) {
+    for(int i=start; i<len-1; i++)
+        counts->diff += seq[i] != seq[i+1];
+}
+
+// the number of different bytes of a and b in [0, len), the counting can stop once it's > limit
+typedef int (*MismatchCounter)(const char* a, const char* b, int len, int limit);
+
+static inline int countMismatchRange(const char* a, const char* b, int len, int limit) {
+    int mismatch = 0;
+    for(int i=0; i<len; i++) {
+        mismatch += a[i] != b[i];
+        if(mismatch > limit)
+            break;
+    }
+    return mismatch;
+}
+
+// the adapter is aligned to the read at pos (can be negative), and compared from max(0, -pos) to min(rlen - pos, alen)
+// one mismatch is allowed for each 8 bases of min(rlen - pos, alen), the rules of AdapterTrimmer::trimBySequence()
+static inline int findAdapterRange(MismatchCounter countMismatches, const char* read, int rlen, const char* adapter, int alen, int start, int end) {
+    for(int pos=start; pos<end; pos++) {
+        int cmplen = rlen - pos < alen ? rlen - pos : alen;
+        int allowedMismatch = cmplen / 8;
+        int skipped = pos < 0 ? -pos : 0;
+        if(countMismatches(adapter + skipped, read + pos + skipped, cmplen - skipped, allowedMismatch) <= allowedMismatch)
+            return pos;
+    }
+    return end;
+}
+
+// the bases compared before a mismatching overlap is rejected, see OverlapAnalysis::analyze()
+#define OVERLAP_COMPLETE_COMPARE_REQUIRE 50
+
+// the overlap of str1 and str2 moved right for offset (can be negative), the rules of OverlapAnalysis::analyze().
+// it's accepted if there are no more than the allowed mismatches in the first OVERLAP_COMPLETE_COMPARE_REQUIRE bases
+// of the overlap, and the diff is the mismatches of the whole overlap
+static inline int matchOverlapAt(MismatchCounter countMismatches, const char* str1, int len1, const char* str2, int len2,
+                                 int diffLimit, double diffPercentLimit, int offset, int* overlapLen, int* diff) {
+    // str1 + s1 is aligned to str2 + s2
+    int s1 = offset > 0 ? offset : 0;
+    int s2 = offset > 0 ? 0 : -offset;
+    int ol = len1 - s1 < len2 - s2 ? len1 - s1 : len2 - s2;
+    int limit = (int)(ol * diffPercentLimit);
+    if(diffLimit < limit)
+        limit = diffLimit;
+    int head = ol < OVERLAP_COMPLETE_COMPARE_REQUIRE ? ol : OVERLAP_COMPLETE_COMPARE_REQUIRE;
+    int mismatch = countMismatches(str1 + s1, str2 + s2, head, limit);
+    if(mismatch > limit)
+        return 0;
+    *overlapLen = ol;
+    *diff = mismatch + countMismatches(str1 + s1 + head, str2 + s2 + head, ol - head, ol);
+    return 1;
+}
+
+// the offsets are tried from 0 to len1 - overlapRequire - 1 (str2 moved right), and then from 0 to -(len2 - overlapRequire - 1)
+// (str2 moved left), the first one accepted is returned. if probes are given, the ones in these ranges are tried first
+static inline int findOverlapRange(MismatchCounter countMismatches, const char* str1, int len1, const char* str2, int len2,
+                                   int diffLimit, int overlapRequire, double diffPercentLimit, const int* probes, int probeCount,
+                                   int* offset, int* overlapLen, int* diff) {
+    for(int i=0; i<probeCount; i++) {
+        int o = probes[i];
+        if(o >= len1 - overlapRequire || o <= -(len2 - overlapRequire))
+            continue;
+        if(matchOverlapAt(countMismatches, str1, len1, str2, len2, diffLimit, diffPercentLimit, o, overlapLen, diff)) {
+            *offset = o;
+            return 1;
+        }
+    }
+    for(int o=0; o<len1-overlapRequire; o++) {
+        if(matchOverlapAt(countMismatches, str1, len1, str2, len2, diffLimit, diffPercentLimit, o, overlapLen, diff)) {
+            *offset = o;
+            return 1;
+        }
+    }
+    for(int o=0; o>-(len2-overlapRequire); o--) {
+        if(matchOverlapAt(countMismatches, str1, len1, str2, len2, diffLimit, diffPercentLimit, o, overlapLen, diff)) {
+            *offset = o;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// the max indel length of a gapped overlap, the band has the diagonals up to it on each side of the center one
+#define OVERLAP_GAP_BAND 3
+// the diagonals of the band are the lanes of the kernels, the last lane is always empty
+#define OVERLAP_GAP_LANES 8
+
+// a state of the band packs the cost (from bit 22), the differences (mismatches and indel bases, from bit 12)
+// and the start of the overlap in str1 (the low 12 bits), so the lower cost wins and then the fewer differences
+#define GAP_COST_UNIT (1 << 22)
+#define GAP_DIFF_UNIT (1 << 12)
+#define GAP_START_MASK (GAP_DIFF_UNIT - 1)
+// no path, the states are capped at it, so the costs of the paths are below 256
+#define GAP_STATE_NONE (1 << 30)
+#define GAP_MISMATCH (GAP_COST_UNIT + GAP_DIFF_UNIT)
+#define GAP_OPEN (2 * GAP_COST_UNIT + GAP_DIFF_UNIT)
+#define GAP_EXTEND (GAP_COST_UNIT + GAP_DIFF_UNIT)
+
+// the banded alignment with affine gaps of OverlapAnalysis::analyzeGapped(). in row j, str2[0, j) is aligned to str1 ending at
+// column i = j + center + k - OVERLAP_GAP_BAND for the lane k. str1 can start at any column of row 0 (the bases before the overlap),
+// and str2 can end at any row (the bases after str1). the rows stop once no state has a cost <= costLimit.
+// returns the best state ending at column len1 and its row. len1 should be <= GAP_START_MASK,
+// and str1[-OVERLAP_GAP_LANES, len1 + OVERLAP_GAP_LANES) should be readable. the kernels cap the states at the same steps
+static inline int alignBandRange(const char* str1, int len1, const char* str2, int len2, int center, int costLimit, int* endRow) {
+    const int lanes = OVERLAP_GAP_LANES;
+    int match[OVERLAP_GAP_LANES], insertion[OVERLAP_GAP_LANES], deletion[OVERLAP_GAP_LANES];
+    for(int k=0; k<lanes; k++) {
+        int i = center + k - OVERLAP_GAP_BAND;
+        match[k] = (k < lanes - 1 && i >= 1 && i <= len1) ? i : GAP_STATE_NONE;
+        insertion[k] = deletion[k] = GAP_STATE_NONE;
+    }
+    int end = GAP_STATE_NONE;
+    *endRow = 0;
+    for(int j=1; j<=len2 && j + center - OVERLAP_GAP_BAND <= len1; j++) {
+        // the column of lane 0
+        int first = j + center - OVERLAP_GAP_BAND;
+        int best[OVERLAP_GAP_LANES], prevInsertion[OVERLAP_GAP_LANES];
+        for(int k=0; k<lanes; k++) {
+            int m = match[k] < insertion[k] ? match[k] : insertion[k];
+            best[k] = m < deletion[k] ? m : deletion[k];
+            // str2[j-1] is inserted, from the same column of the last row, which is the next lane
+            int opened = (match[k] < deletion[k] ? match[k] : deletion[k]) + GAP_OPEN;
+            int extended = insertion[k] + GAP_EXTEND;
+            prevInsertion[k] = opened < extended ? opened : extended;
+        }
+        int rowBest = GAP_STATE_NONE;
+        for(int k=0; k<lanes; k++) {
+            bool valid = k < lanes - 1 && first + k >= 1 && first + k <= len1;
+            int ins = k + 1 < lanes ? prevInsertion[k + 1] : GAP_STATE_NONE;
+            // str2[j-1] is aligned to str1[i-1]
+            int m = best[k] + (str1[first + k - 1] != str2[j - 1]) * GAP_MISMATCH;
+            match[k] = valid ? (m < GAP_STATE_NONE ? m : GAP_STATE_NONE) : GAP_STATE_NONE;
+            insertion[k] = valid ? (ins < GAP_STATE_NONE ? ins : GAP_STATE_NONE) : GAP_STATE_NONE;
+        }
+        for(int k=0; k<lanes; k++) {
+            bool valid = k < lanes - 1 && first + k >= 1 && first + k <= len1;
+            // str1[i-1] is deleted, from the last lane of this row
+            int del = GAP_STATE_NONE;
+            if(k > 0) {
+                int opened = (match[k - 1] < insertion[k - 1] ? match[k - 1] : insertion[k - 1]) + GAP_OPEN;
+                int extended = deletion[k - 1] + GAP_EXTEND;
+                del = opened < extended ? opened : extended;
+            }
+            deletion[k] = valid ? (del < GAP_STATE_NONE ? del : GAP_STATE_NONE) : GAP_STATE_NONE;
+            int m = match[k] < insertion[k] ? match[k] : insertion[k];
+            int cell = m < deletion[k] ? m : deletion[k];
+            rowBest = rowBest < cell ? rowBest : cell;
+            // the overlap ends at the end of str1
+            if(first + k == len1 && cell < end) {
+                end = cell;
+                *endRow = j;
+            }
+        }
+        if(rowBest / GAP_COST_UNIT > costLimit)
+            break;
+    }
+    return end;
+}
+
+// the kernels built with -msse4.2, -mavx2 and -mavx512bw, NULL if not built for x86
+SimdKernels* sse42Kernels();
+SimdKernels* avx2Kernels();
+SimdKernels* avx512Kernels();
+
+// the scanning kernels of reads, the fastest ones supported by the CPU are selected at startup
+class Simd {
+public:
+    static void reverseComplement(const char* src, char* dst, int len) {
+        mKernels->reverseComplement(src, dst, len);
+    }
+    static void phred64To33(char* qual, int len) {
+        mKernels->phred64To33(qual, len);
+    }
+    static void countBases(const char* seq, const char* qual, int len, char qualifiedQual, BaseCounts* counts) {
+        mKernels->countBases(seq, qual, len, qualifiedQual, counts);
+    }
+    static int findAdapter(const char* read, int rlen, const char* adapter, int alen, int start, int end) {
+        return mKernels->findAdapter(read, rlen, adapter, alen, start, end);
+    }
+    static int findOverlap(const char* str1, int len1, const char* str2, int len2, int diffLimit, int overlapRequire, double diffPercentLimit,
+                           const int* probes, int probeCount, int* offset, int* overlapLen, int* diff) {
+        return mKernels->findOverlap(str1, len1, str2, len2, diffLimit, overlapRequire, diffPercentLimit, probes, probeCount, offset, overlapLen, diff);
+    }
+    static int alignBand(const char* str1, int len1, const char* str2, int len2, int center, int costLimit, int* endRow) {
+        return mKernels->alignBand(str1, len1, str2, len2, center, costLimit, endRow);
+    }
+    static const char* name() {return mKernels->name;}
+    static SimdKernels* scalarKernels();
+    static bool test();
+
+private:
+    static SimdKernels* select();
+    // the kernels supported by this CPU from the slowest to the fastest, returns the number of them
+    static int supportedKernels(SimdKernels** kernels);
+
+private:
+    static SimdKernels* mKernels;
+};
+
+#endif
@@ -0,0 +1,218 @@
+#include "simd.h"
+#include <stddef.h>
+
+// this file is built with -mavx2 -mpopcnt on x86, and the kernels are only used if the CPU supports them
+#if defined(__AVX2__) && defined(__POPCNT__)
+#include <immintrin.h>
+#include <string.h>
+
+// ACGT and acgt are complemented, others are N
+static inline __m256i complement32(__m256i bases) {
+    __m256i lower = _mm256_or_si256(bases, _mm256_set1_epi8(0x20));
+    __m256i result = _mm256_set1_epi8('N');
+    result = _mm256_blendv_epi8(result, _mm256_set1_epi8('T'), _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('a')));
+    result = _mm256_blendv_epi8(result, _mm256_set1_epi8('A'), _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('t')));
+    result = _mm256_blendv_epi8(result, _mm256_set1_epi8('G'), _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('c')));
+    result = _mm256_blendv_epi8(result, _mm256_set1_epi8('C'), _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('g')));
+    return result;
+}
+
+static inline int count32(__m256i mask) {
+    return _mm_popcnt_u32(_mm256_movemask_epi8(mask));
+}
+
+static void avx2ReverseComplement(const char* src, char* dst, int len) {
+    // the bytes are reversed in each 128-bit lane, and then the two lanes are swapped
+    const __m256i reverse = _mm256_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+                                            0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    int i = 0;
+    for(; i + 32 <= len; i += 32) {
+        __m256i bases = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i rc = _mm256_shuffle_epi8(complement32(bases), reverse);
+        rc = _mm256_permute2x128_si256(rc, rc, 1);
+        _mm256_storeu_si256((__m256i*)(dst + len - i - 32), rc);
+    }
+    for(; i<len; i++)
+        dst[len - 1 - i] = complementBase(src[i]);
+}
+
+static void avx2Phred64To33(char* qual, int len) {
+    // the saturated subtraction keeps the bytes >= 128 (negative) at 33 as the scalar one does
+    const __m256i offset = _mm256_set1_epi8(64 - 33);
+    const __m256i minQual = _mm256_set1_epi8(33);
+    int i = 0;
+    for(; i + 32 <= len; i += 32) {
+        __m256i q = _mm256_loadu_si256((const __m256i*)(qual + i));
+        q = _mm256_max_epi8(_mm256_subs_epi8(q, offset), minQual);
+        _mm256_storeu_si256((__m256i*)(qual + i), q);
+    }
+    for(; i<len; i++) {
+        int q = qual[i] - (64 - 33);
+        qual[i] = q < 33 ? 33 : q;
+    }
+}
+
+static void avx2CountBases(const char* seq, const char* qual, int len, char qualifiedQual, BaseCounts* counts) {
+    memset(counts, 0, sizeof(BaseCounts));
+    const __m256i q20 = _mm256_set1_epi8('5' - 1);
+    const __m256i q30 = _mm256_set1_epi8('?' - 1);
+    const __m256i lowQual = _mm256_set1_epi8(qualifiedQual);
+    const __m256i gcBits = _mm256_set1_epi8(0x03);
+    const __m256i baseN = _mm256_set1_epi8('N');
+    const __m256i zero = _mm256_setzero_si256();
+    // the qualities are summed as unsigned bytes, and corrected for the negative ones later
+    __m256i qualSum = zero;
+    long negatives = 0;
+    // the base differences (j, j + 1) are counted for j < diffDone
+    int diffDone = 0;
+    int i = 0;
+    for(; i + 32 <= len; i += 32) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(seq + i));
+        __m256i q = _mm256_loadu_si256((const __m256i*)(qual + i));
+        counts->q20 += count32(_mm256_cmpgt_epi8(q, q20));
+        counts->q30 += count32(_mm256_cmpgt_epi8(q, q30));
+        counts->gc += count32(_mm256_cmpeq_epi8(_mm256_and_si256(s, gcBits), gcBits));
+        counts->lowQual += count32(_mm256_cmpgt_epi8(lowQual, q));
+        counts->nBase += count32(_mm256_cmpeq_epi8(s, baseN));
+        qualSum = _mm256_add_epi64(qualSum, _mm256_sad_epu8(q, zero));
+        negatives += count32(q);
+        // the base after the block is only read when it's in the read
+        if(i + 32 < len) {
+            __m256i next = _mm256_loadu_si256((const __m256i*)(seq + i + 1));
+            counts->diff += 32 - count32(_mm256_cmpeq_epi8(s, next));
+            diffDone = i + 32;
+        }
+    }
+    long long lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, qualSum);
+    counts->totalQual = lanes[0] + lanes[1] + lanes[2] + lanes[3] - 256 * negatives - 33L * i;
+    countBaseRange(seq, qual, i, len, qualifiedQual, counts);
+    countDiffRange(seq, diffDone, len, counts);
+}
+
+static int avx2CountMismatches(const char* a, const char* b, int len, int limit) {
+    int mismatch = 0;
+    int i = 0;
+    for(; i + 32 <= len; i += 32) {
+        __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(a + i)), _mm256_loadu_si256((const __m256i*)(b + i)));
+        mismatch += 32 - count32(eq);
+        if(mismatch > limit)
+            return mismatch;
+    }
+    if(i == len)
+        return mismatch;
+    if(len < 32) {
+        // the 16 bytes compare for the short ones, they are mostly the alignments near the read end
+        for(; i + 16 <= len; i += 16) {
+            __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(a + i)), _mm_loadu_si128((const __m128i*)(b + i)));
+            mismatch += 16 - _mm_popcnt_u32(_mm_movemask_epi8(eq));
+            if(mismatch > limit)
+                return mismatch;
+        }
+        return mismatch + countMismatchRange(a + i, b + i, len - i, limit - mismatch);
+    }
+    // the last 32 bytes are compared again, and the ones already counted are shifted out
+    __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(a + len - 32)), _mm256_loadu_si256((const __m256i*)(b + len - 32)));
+    unsigned int diff = ~(unsigned int)_mm256_movemask_epi8(eq);
+    return mismatch + _mm_popcnt_u32(diff >> (32 - (len - i)));
+}
+
+static int avx2FindAdapter(const char* read, int rlen, const char* adapter, int alen, int start, int end) {
+    return findAdapterRange(avx2CountMismatches, read, rlen, adapter, alen, start, end);
+}
+
+static int avx2FindOverlap(const char* str1, int len1, const char* str2, int len2, int diffLimit, int overlapRequire, double diffPercentLimit,
+                          const int* probes, int probeCount, int* offset, int* overlapLen, int* diff) {
+    return findOverlapRange(avx2CountMismatches, str1, len1, str2, len2, diffLimit, overlapRequire, diffPercentLimit, probes, probeCount, offset, overlapLen, diff);
+}
+
+// the lanes moved up by 1, 2 or 4 (lane k gets lane k - n), and the first lanes get no path
+static inline __m256i shiftUp(__m256i x, __m256i index, int firstLanes) {
+    __m256i moved = _mm256_permutevar8x32_epi32(x, index);
+    switch(firstLanes) {
+        case 1:
+            return _mm256_blend_epi32(moved, _mm256_set1_epi32(GAP_STATE_NONE), 0x01);
+        case 2:
+            return _mm256_blend_epi32(moved, _mm256_set1_epi32(GAP_STATE_NONE), 0x03);
+        default:
+            return _mm256_blend_epi32(moved, _mm256_set1_epi32(GAP_STATE_NONE), 0x0F);
+    }
+}
+
+static int avx2AlignBand(const char* str1, int len1, const char* str2, int len2, int center, int costLimit, int* endRow) {
+    // the 7 diagonals of the band and an empty lane are one vector
+    const __m256i none = _mm256_set1_epi32(GAP_STATE_NONE);
+    const __m256i mismatchCost = _mm256_set1_epi32(GAP_MISMATCH);
+    const __m256i openCost = _mm256_set1_epi32(GAP_OPEN);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i bandLanes = _mm256_cmpgt_epi32(_mm256_set1_epi32(OVERLAP_GAP_LANES - 1), lanes);
+    const __m256i afterEnd = _mm256_set1_epi32(len1 + 1);
+    const __m256i down = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 7);
+    const __m256i up1 = _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6);
+    const __m256i up2 = _mm256_setr_epi32(0, 0, 0, 1, 2, 3, 4, 5);
+    const __m256i up4 = _mm256_setr_epi32(0, 0, 0, 0, 0, 1, 2, 3);
+    const __m256i extend1 = _mm256_set1_epi32(GAP_EXTEND);
+    const __m256i extend2 = _mm256_set1_epi32(2 * GAP_EXTEND);
+    const __m256i extend4 = _mm256_set1_epi32(4 * GAP_EXTEND);
+
+    __m256i columns = _mm256_add_epi32(_mm256_set1_epi32(center - OVERLAP_GAP_BAND), lanes);
+    __m256i valid = _mm256_and_si256(bandLanes, _mm256_and_si256(_mm256_cmpgt_epi32(columns, _mm256_setzero_si256()), _mm256_cmpgt_epi32(afterEnd, columns)));
+    __m256i match = _mm256_blendv_epi8(none, columns, valid);
+    __m256i insertion = none;
+    __m256i deletion = none;
+    int end = GAP_STATE_NONE;
+    *endRow = 0;
+    int cells[OVERLAP_GAP_LANES];
+    for(int j=1; j<=len2 && j + center - OVERLAP_GAP_BAND <= len1; j++) {
+        int first = j + center - OVERLAP_GAP_BAND;
+        columns = _mm256_add_epi32(_mm256_set1_epi32(first), lanes);
+        valid = _mm256_and_si256(bandLanes, _mm256_and_si256(_mm256_cmpgt_epi32(columns, _mm256_setzero_si256()), _mm256_cmpgt_epi32(afterEnd, columns)));
+
+        __m256i best = _mm256_min_epi32(_mm256_min_epi32(match, insertion), deletion);
+        __m256i prevInsertion = _mm256_min_epi32(_mm256_add_epi32(_mm256_min_epi32(match, deletion), openCost), _mm256_add_epi32(insertion, extend1));
+        insertion = _mm256_blend_epi32(_mm256_permutevar8x32_epi32(prevInsertion, down), none, 0x80);
+
+        // str1[first - 1, first + 7) is compared with str2[j-1]
+        __m128i bases = _mm_loadl_epi64((const __m128i*)(str1 + first - 1));
+        __m128i same = _mm_cmpeq_epi8(bases, _mm_set1_epi8(str2[j - 1]));
+        match = _mm256_add_epi32(best, _mm256_andnot_si256(_mm256_cvtepi8_epi32(same), mismatchCost));
+        match = _mm256_blendv_epi8(none, _mm256_min_epi32(match, none), valid);
+        insertion = _mm256_blendv_epi8(none, _mm256_min_epi32(insertion, none), valid);
+
+        // the deletions are a prefix scan of the lanes
+        __m256i del = shiftUp(_mm256_add_epi32(_mm256_min_epi32(match, insertion), openCost), up1, 1);
+        del = _mm256_min_epi32(del, _mm256_add_epi32(shiftUp(del, up1, 1), extend1));
+        del = _mm256_min_epi32(del, _mm256_add_epi32(shiftUp(del, up2, 2), extend2));
+        del = _mm256_min_epi32(del, _mm256_add_epi32(shiftUp(del, up4, 4), extend4));
+        deletion = _mm256_blendv_epi8(none, _mm256_min_epi32(del, none), valid);
+
+        __m256i cell = _mm256_min_epi32(_mm256_min_epi32(match, insertion), deletion);
+        int last = len1 - first;
+        if(last < OVERLAP_GAP_LANES - 1) {
+            _mm256_storeu_si256((__m256i*)cells, cell);
+            if(cells[last] < end) {
+                end = cells[last];
+                *endRow = j;
+            }
+        }
+        __m128i rowBest = _mm_min_epi32(_mm256_castsi256_si128(cell), _mm256_extracti128_si256(cell, 1));
+        rowBest = _mm_min_epi32(rowBest, _mm_shuffle_epi32(rowBest, 0x4E));
+        rowBest = _mm_min_epi32(rowBest, _mm_shuffle_epi32(rowBest, 0xB1));
+        if(_mm_cvtsi128_si32(rowBest) / GAP_COST_UNIT > costLimit)
+            break;
+    }
+    return end;
+}
+
+SimdKernels* avx2Kernels() {
+    static SimdKernels kernels = {"avx2", avx2ReverseComplement, avx2Phred64To33, avx2CountBases, avx2FindAdapter, avx2FindOverlap, avx2AlignBand};
+    return &kernels;
+}
+
+#else
+
+SimdKernels* avx2Kernels() {
+    return NULL;
+}
+
+#endif
@@ -0,0 +1,126 @@
+#include "simd.h"
+#include <stddef.h>
+
+// this file is built with -mavx512f -mavx512bw -mpopcnt on x86, and the kernels are only used if the CPU supports them
+#if defined(__AVX512BW__) && defined(__POPCNT__) && defined(__x86_64__)
+#include <immintrin.h>
+#include <string.h>
+
+// ACGT and acgt are complemented, others are N
+static inline __m512i complement64(__m512i bases) {
+    __m512i lower = _mm512_or_si512(bases, _mm512_set1_epi8(0x20));
+    __m512i result = _mm512_set1_epi8('N');
+    result = _mm512_mask_blend_epi8(_mm512_cmpeq_epi8_mask(lower, _mm512_set1_epi8('a')), result, _mm512_set1_epi8('T'));
+    result = _mm512_mask_blend_epi8(_mm512_cmpeq_epi8_mask(lower, _mm512_set1_epi8('t')), result, _mm512_set1_epi8('A'));
+    result = _mm512_mask_blend_epi8(_mm512_cmpeq_epi8_mask(lower, _mm512_set1_epi8('c')), result, _mm512_set1_epi8('G'));
+    result = _mm512_mask_blend_epi8(_mm512_cmpeq_epi8_mask(lower, _mm512_set1_epi8('g')), result, _mm512_set1_epi8('C'));
+    return result;
+}
+
+static inline int count64(__mmask64 mask) {
+    return _mm_popcnt_u64(mask);
+}
+
+static void avx512ReverseComplement(const char* src, char* dst, int len) {
+    // the bytes are reversed in each 128-bit lane, and then the four lanes are reversed
+    const __m512i reverse = _mm512_broadcast_i32x4(_mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+    int i = 0;
+    for(; i + 64 <= len; i += 64) {
+        __m512i bases = _mm512_loadu_si512((const void*)(src + i));
+        __m512i rc = _mm512_shuffle_epi8(complement64(bases), reverse);
+        rc = _mm512_shuffle_i64x2(rc, rc, 0x1B);
+        _mm512_storeu_si512((void*)(dst + len - i - 64), rc);
+    }
+    for(; i<len; i++)
+        dst[len - 1 - i] = complementBase(src[i]);
+}
+
+static void avx512Phred64To33(char* qual, int len) {
+    // the saturated subtraction keeps the bytes >= 128 (negative) at 33 as the scalar one does
+    const __m512i offset = _mm512_set1_epi8(64 - 33);
+    const __m512i minQual = _mm512_set1_epi8(33);
+    int i = 0;
+    for(; i + 64 <= len; i += 64) {
+        __m512i q = _mm512_loadu_si512((const void*)(qual + i));
+        q = _mm512_max_epi8(_mm512_subs_epi8(q, offset), minQual);
+        _mm512_storeu_si512((void*)(qual + i), q);
+    }
+    for(; i<len; i++) {
+        int q = qual[i] - (64 - 33);
+        qual[i] = q < 33 ? 33 : q;
+    }
+}
+
+static void avx512CountBases(const char* seq, const char* qual, int len, char qualifiedQual, BaseCounts* counts) {
+    memset(counts, 0, sizeof(BaseCounts));
+    const __m512i q20 = _mm512_set1_epi8('5' - 1);
+    const __m512i q30 = _mm512_set1_epi8('?' - 1);
+    const __m512i lowQual = _mm512_set1_epi8(qualifiedQual);
+    const __m512i gcBits = _mm512_set1_epi8(0x03);
+    const __m512i baseN = _mm512_set1_epi8('N');
+    const __m512i zero = _mm512_setzero_si512();
+    // the qualities are summed as unsigned bytes, and corrected for the negative ones later
+    __m512i qualSum = zero;
+    long negatives = 0;
+    // the base differences (j, j + 1) are counted for j < diffDone
+    int diffDone = 0;
+    int i = 0;
+    for(; i + 64 <= len; i += 64) {
+        __m512i s = _mm512_loadu_si512((const void*)(seq + i));
+        __m512i q = _mm512_loadu_si512((const void*)(qual + i));
+        counts->q20 += count64(_mm512_cmpgt_epi8_mask(q, q20));
+        counts->q30 += count64(_mm512_cmpgt_epi8_mask(q, q30));
+        counts->gc += count64(_mm512_cmpeq_epi8_mask(_mm512_and_si512(s, gcBits), gcBits));
+        counts->lowQual += count64(_mm512_cmplt_epi8_mask(q, lowQual));
+        counts->nBase += count64(_mm512_cmpeq_epi8_mask(s, baseN));
+        qualSum = _mm512_add_epi64(qualSum, _mm512_sad_epu8(q, zero));
+        negatives += count64(_mm512_movepi8_mask(q));
+        // the base after the block is only read when it's in the read
+        if(i + 64 < len) {
+            __m512i next = _mm512_loadu_si512((const void*)(seq + i + 1));
+            counts->diff += count64(_mm512_cmpneq_epi8_mask(s, next));
+            diffDone = i + 64;
+        }
+    }
+    counts->totalQual = _mm512_reduce_add_epi64(qualSum) - 256 * negatives - 33L * i;
+    countBaseRange(seq, qual, i, len, qualifiedQual, counts);
+    countDiffRange(seq, diffDone, len, counts);
+}
+
+static int avx512CountMismatches(const char* a, const char* b, int len, int limit) {
+    int mismatch = 0;
+    for(int i=0; i<len; i+=64) {
+        // the bytes after len are masked out of the loads, so they are never read
+        __mmask64 valid = len - i >= 64 ? ~0ULL : (1ULL << (len - i)) - 1;
+        __m512i va = _mm512_maskz_loadu_epi8(valid, (const void*)(a + i));
+        __m512i vb = _mm512_maskz_loadu_epi8(valid, (const void*)(b + i));
+        mismatch += count64(_mm512_mask_cmpneq_epi8_mask(valid, va, vb));
+        if(mismatch > limit)
+            return mismatch;
+    }
+    return mismatch;
+}
+
+static int avx512FindAdapter(const char* read, int rlen, const char* adapter, int alen, int start, int end) {
+    return findAdapterRange(avx512CountMismatches, read, rlen, adapter, alen, start, end);
+}
+
+static int avx512FindOverlap(const char* str1, int len1, const char* str2, int len2, int diffLimit, int overlapRequire, double diffPercentLimit,
+                          const int* probes, int probeCount, int* offset, int* overlapLen, int* diff) {
+    return findOverlapRange(avx512CountMismatches, str1, len1, str2, len2, diffLimit, overlapRequire, diffPercentLimit, probes, probeCount, offset, overlapLen, diff);
+}
+
+SimdKernels* avx512Kernels() {
+    // the band of the gapped overlap is one AVX2 vector, so it has no wider kernel
+    static SimdKernels kernels = {"avx512bw", avx512ReverseComplement, avx512Phred64To33, avx512CountBases, avx512FindAdapter, avx512FindOverlap,
+                                  avx2Kernels()->alignBand};
+    return &kernels;
+}
+
+#else
+
+SimdKernels* avx512Kernels() {
+    return NULL;
+}
+
+#endif
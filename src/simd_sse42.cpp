@@ -0,0 +1,227 @@
+#include "simd.h"
+#include <stddef.h>
+
+// this file is built with -msse4.2 -mpopcnt on x86, and the kernels are only used if the CPU supports them
+#if defined(__SSE4_2__) && defined(__POPCNT__)
+#include <immintrin.h>
+#include <string.h>
+
+// ACGT and acgt are complemented, others are N
+static inline __m128i complement16(__m128i bases) {
+    __m128i lower = _mm_or_si128(bases, _mm_set1_epi8(0x20));
+    __m128i result = _mm_set1_epi8('N');
+    result = _mm_blendv_epi8(result, _mm_set1_epi8('T'), _mm_cmpeq_epi8(lower, _mm_set1_epi8('a')));
+    result = _mm_blendv_epi8(result, _mm_set1_epi8('A'), _mm_cmpeq_epi8(lower, _mm_set1_epi8('t')));
+    result = _mm_blendv_epi8(result, _mm_set1_epi8('G'), _mm_cmpeq_epi8(lower, _mm_set1_epi8('c')));
+    result = _mm_blendv_epi8(result, _mm_set1_epi8('C'), _mm_cmpeq_epi8(lower, _mm_set1_epi8('g')));
+    return result;
+}
+
+static inline int count16(__m128i mask) {
+    return _mm_popcnt_u32(_mm_movemask_epi8(mask));
+}
+
+static void sse42ReverseComplement(const char* src, char* dst, int len) {
+    const __m128i reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    int i = 0;
+    for(; i + 16 <= len; i += 16) {
+        __m128i bases = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i rc = _mm_shuffle_epi8(complement16(bases), reverse);
+        _mm_storeu_si128((__m128i*)(dst + len - i - 16), rc);
+    }
+    for(; i<len; i++)
+        dst[len - 1 - i] = complementBase(src[i]);
+}
+
+static void sse42Phred64To33(char* qual, int len) {
+    // the saturated subtraction keeps the bytes >= 128 (negative) at 33 as the scalar one does
+    const __m128i offset = _mm_set1_epi8(64 - 33);
+    const __m128i minQual = _mm_set1_epi8(33);
+    int i = 0;
+    for(; i + 16 <= len; i += 16) {
+        __m128i q = _mm_loadu_si128((const __m128i*)(qual + i));
+        q = _mm_max_epi8(_mm_subs_epi8(q, offset), minQual);
+        _mm_storeu_si128((__m128i*)(qual + i), q);
+    }
+    for(; i<len; i++) {
+        int q = qual[i] - (64 - 33);
+        qual[i] = q < 33 ? 33 : q;
+    }
+}
+
+static void sse42CountBases(const char* seq, const char* qual, int len, char qualifiedQual, BaseCounts* counts) {
+    memset(counts, 0, sizeof(BaseCounts));
+    const __m128i q20 = _mm_set1_epi8('5' - 1);
+    const __m128i q30 = _mm_set1_epi8('?' - 1);
+    const __m128i lowQual = _mm_set1_epi8(qualifiedQual);
+    const __m128i gcBits = _mm_set1_epi8(0x03);
+    const __m128i baseN = _mm_set1_epi8('N');
+    const __m128i zero = _mm_setzero_si128();
+    // the qualities are summed as unsigned bytes, and corrected for the negative ones later
+    __m128i qualSum = zero;
+    long negatives = 0;
+    // the base differences (j, j + 1) are counted for j < diffDone
+    int diffDone = 0;
+    int i = 0;
+    for(; i + 16 <= len; i += 16) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(seq + i));
+        __m128i q = _mm_loadu_si128((const __m128i*)(qual + i));
+        counts->q20 += count16(_mm_cmpgt_epi8(q, q20));
+        counts->q30 += count16(_mm_cmpgt_epi8(q, q30));
+        counts->gc += count16(_mm_cmpeq_epi8(_mm_and_si128(s, gcBits), gcBits));
+        counts->lowQual += count16(_mm_cmplt_epi8(q, lowQual));
+        counts->nBase += count16(_mm_cmpeq_epi8(s, baseN));
+        qualSum = _mm_add_epi64(qualSum, _mm_sad_epu8(q, zero));
+        negatives += count16(q);
+        // the base after the block is only read when it's in the read
+        if(i + 16 < len) {
+            __m128i next = _mm_loadu_si128((const __m128i*)(seq + i + 1));
+            counts->diff += 16 - count16(_mm_cmpeq_epi8(s, next));
+            diffDone = i + 16;
+        }
+    }
+    long long lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, qualSum);
+    counts->totalQual = lanes[0] + lanes[1] - 256 * negatives - 33L * i;
+    countBaseRange(seq, qual, i, len, qualifiedQual, counts);
+    countDiffRange(seq, diffDone, len, counts);
+}
+
+static int sse42CountMismatches(const char* a, const char* b, int len, int limit) {
+    int mismatch = 0;
+    int i = 0;
+    for(; i + 16 <= len; i += 16) {
+        __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(a + i)), _mm_loadu_si128((const __m128i*)(b + i)));
+        mismatch += 16 - count16(eq);
+        if(mismatch > limit)
+            return mismatch;
+    }
+    if(i == len)
+        return mismatch;
+    if(len < 16)
+        return mismatch + countMismatchRange(a + i, b + i, len - i, limit - mismatch);
+    // the last 16 bytes are compared again, and the ones already counted are shifted out
+    __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(a + len - 16)), _mm_loadu_si128((const __m128i*)(b + len - 16)));
+    unsigned int diff = ~_mm_movemask_epi8(eq) & 0xFFFF;
+    return mismatch + _mm_popcnt_u32(diff >> (16 - (len - i)));
+}
+
+static int sse42FindAdapter(const char* read, int rlen, const char* adapter, int alen, int start, int end) {
+    return findAdapterRange(sse42CountMismatches, read, rlen, adapter, alen, start, end);
+}
+
+static int sse42FindOverlap(const char* str1, int len1, const char* str2, int len2, int diffLimit, int overlapRequire, double diffPercentLimit,
+                          const int* probes, int probeCount, int* offset, int* overlapLen, int* diff) {
+    return findOverlapRange(sse42CountMismatches, str1, len1, str2, len2, diffLimit, overlapRequire, diffPercentLimit, probes, probeCount, offset, overlapLen, diff);
+}
+
+// the lanes 0 ~ 3 and 4 ~ 7 of the band
+struct BandLanes {
+    __m128i lo;
+    __m128i hi;
+};
+
+static inline BandLanes bandMin(BandLanes a, BandLanes b) {
+    BandLanes r = {_mm_min_epi32(a.lo, b.lo), _mm_min_epi32(a.hi, b.hi)};
+    return r;
+}
+
+static inline BandLanes bandAdd(BandLanes a, __m128i b) {
+    BandLanes r = {_mm_add_epi32(a.lo, b), _mm_add_epi32(a.hi, b)};
+    return r;
+}
+
+// valid ? min(a, none) : none
+static inline BandLanes bandCap(BandLanes a, BandLanes valid, __m128i none) {
+    BandLanes r = {_mm_blendv_epi8(none, _mm_min_epi32(a.lo, none), valid.lo), _mm_blendv_epi8(none, _mm_min_epi32(a.hi, none), valid.hi)};
+    return r;
+}
+
+static int sse42AlignBand(const char* str1, int len1, const char* str2, int len2, int center, int costLimit, int* endRow) {
+    const __m128i none = _mm_set1_epi32(GAP_STATE_NONE);
+    const __m128i mismatchCost = _mm_set1_epi32(GAP_MISMATCH);
+    const __m128i openCost = _mm_set1_epi32(GAP_OPEN);
+    const __m128i extend1 = _mm_set1_epi32(GAP_EXTEND);
+    const __m128i extend2 = _mm_set1_epi32(2 * GAP_EXTEND);
+    const __m128i extend4 = _mm_set1_epi32(4 * GAP_EXTEND);
+    const __m128i lanesLo = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i lanesHi = _mm_setr_epi32(4, 5, 6, 7);
+    const __m128i bandHi = _mm_setr_epi32(-1, -1, -1, 0);
+    const __m128i afterEnd = _mm_set1_epi32(len1 + 1);
+    const __m128i zero = _mm_setzero_si128();
+
+    __m128i start = _mm_set1_epi32(center - OVERLAP_GAP_BAND);
+    BandLanes columns = {_mm_add_epi32(start, lanesLo), _mm_add_epi32(start, lanesHi)};
+    BandLanes valid = {_mm_and_si128(_mm_cmpgt_epi32(columns.lo, zero), _mm_cmpgt_epi32(afterEnd, columns.lo)),
+                       _mm_and_si128(bandHi, _mm_and_si128(_mm_cmpgt_epi32(columns.hi, zero), _mm_cmpgt_epi32(afterEnd, columns.hi)))};
+    BandLanes match = {_mm_blendv_epi8(none, columns.lo, valid.lo), _mm_blendv_epi8(none, columns.hi, valid.hi)};
+    BandLanes insertion = {none, none};
+    BandLanes deletion = {none, none};
+    int end = GAP_STATE_NONE;
+    *endRow = 0;
+    int cells[OVERLAP_GAP_LANES];
+    for(int j=1; j<=len2 && j + center - OVERLAP_GAP_BAND <= len1; j++) {
+        int first = j + center - OVERLAP_GAP_BAND;
+        __m128i firstColumn = _mm_set1_epi32(first);
+        columns.lo = _mm_add_epi32(firstColumn, lanesLo);
+        columns.hi = _mm_add_epi32(firstColumn, lanesHi);
+        valid.lo = _mm_and_si128(_mm_cmpgt_epi32(columns.lo, zero), _mm_cmpgt_epi32(afterEnd, columns.lo));
+        valid.hi = _mm_and_si128(bandHi, _mm_and_si128(_mm_cmpgt_epi32(columns.hi, zero), _mm_cmpgt_epi32(afterEnd, columns.hi)));
+
+        BandLanes best = bandMin(bandMin(match, insertion), deletion);
+        BandLanes prevInsertion = bandMin(bandAdd(bandMin(match, deletion), openCost), bandAdd(insertion, extend1));
+        // lane k gets lane k + 1
+        insertion.lo = _mm_alignr_epi8(prevInsertion.hi, prevInsertion.lo, 4);
+        insertion.hi = _mm_alignr_epi8(none, prevInsertion.hi, 4);
+
+        // str1[first - 1, first + 7) is compared with str2[j-1]
+        __m128i same = _mm_cmpeq_epi8(_mm_loadl_epi64((const __m128i*)(str1 + first - 1)), _mm_set1_epi8(str2[j - 1]));
+        match.lo = _mm_add_epi32(best.lo, _mm_andnot_si128(_mm_cvtepi8_epi32(same), mismatchCost));
+        match.hi = _mm_add_epi32(best.hi, _mm_andnot_si128(_mm_cvtepi8_epi32(_mm_srli_si128(same, 4)), mismatchCost));
+        match = bandCap(match, valid, none);
+        insertion = bandCap(insertion, valid, none);
+
+        // the deletions are a prefix scan of the lanes, lane k gets lane k - n
+        BandLanes opened = bandAdd(bandMin(match, insertion), openCost);
+        BandLanes del = {_mm_alignr_epi8(opened.lo, none, 12), _mm_alignr_epi8(opened.hi, opened.lo, 12)};
+        BandLanes moved = {_mm_alignr_epi8(del.lo, none, 12), _mm_alignr_epi8(del.hi, del.lo, 12)};
+        del = bandMin(del, bandAdd(moved, extend1));
+        moved.lo = _mm_alignr_epi8(del.lo, none, 8);
+        moved.hi = _mm_alignr_epi8(del.hi, del.lo, 8);
+        del = bandMin(del, bandAdd(moved, extend2));
+        moved.lo = none;
+        moved.hi = del.lo;
+        del = bandMin(del, bandAdd(moved, extend4));
+        deletion = bandCap(del, valid, none);
+
+        BandLanes cell = bandMin(bandMin(match, insertion), deletion);
+        int last = len1 - first;
+        if(last < OVERLAP_GAP_LANES - 1) {
+            _mm_storeu_si128((__m128i*)cells, cell.lo);
+            _mm_storeu_si128((__m128i*)(cells + 4), cell.hi);
+            if(cells[last] < end) {
+                end = cells[last];
+                *endRow = j;
+            }
+        }
+        __m128i rowBest = _mm_min_epi32(cell.lo, cell.hi);
+        rowBest = _mm_min_epi32(rowBest, _mm_shuffle_epi32(rowBest, 0x4E));
+        rowBest = _mm_min_epi32(rowBest, _mm_shuffle_epi32(rowBest, 0xB1));
+        if(_mm_cvtsi128_si32(rowBest) / GAP_COST_UNIT > costLimit)
+            break;
+    }
+    return end;
+}
+
+SimdKernels* sse42Kernels() {
+    static SimdKernels kernels = {"sse4.2", sse42ReverseComplement, sse42Phred64To33, sse42CountBases, sse42FindAdapter, sse42FindOverlap, sse42AlignBand};
+    return &kernels;
+}
+
+#else
+
+SimdKernels* sse42Kernels() {
+    return NULL;
+}
+
+#endif
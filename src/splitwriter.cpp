@@ -0,0 +1,184 @@
+#include "splitwriter.h"
+#include "util.h"
+#include <functional>
+
+SplitWriter::SplitWriter(Options* opt, bool paired){
+    mOptions = opt;
+    mPaired = paired;
+    mSplitSize = max(1L, mOptions->split.size);
+    mBufferPool = new BufferPool(WriterThread::getBufferReserve(opt), OUTPUT_BUFFER_POOL_LIMIT);
+    mWriter1 = NULL;
+    mWriter2 = NULL;
+    mCurrentFile = -1;
+    mCurrentFileRecords = 0;
+    mClosed = false;
+    // the previous files can be still being compressed when the current file is being fed
+    mMaxWorkingFiles = max(2, mOptions->thread);
+
+    // at least one file is written even if there is no output
+    openNextFile();
+}
+
+SplitWriter::~SplitWriter() {
+    close();
+    delete mBufferPool;
+}
+
+string* SplitWriter::getBuffer() {
+    return mBufferPool->get();
+}
+
+void SplitWriter::recycleBuffer(string* data) {
+    mBufferPool->recycle(data);
+}
+
+void SplitWriter::setSplitSize(long size) {
+    mSplitSize = max(1L, size);
+}
+
+long SplitWriter::bufferLength() {
+    long len = 0;
+    mWorkingMtx.lock();
+    for(int i=0; i<mWorkingWriters.size(); i++)
+        len += mWorkingWriters[i]->bufferLength();
+    mWorkingMtx.unlock();
+    return len;
+}
+
+void SplitWriter::input(string* data, const vector<size_t>& ends) {
+    input(data, ends, NULL, ends);
+}
+
+void SplitWriter::input(string* data1, const vector<size_t>& ends1, string* data2, const vector<size_t>& ends2) {
+    size_t units = ends1.size();
+    size_t unit = 0;
+    size_t start1 = 0;
+    size_t start2 = 0;
+    bool handedOver = false;
+    while(unit < units) {
+        // if splitting by file number, the last file takes all the remaining records
+        bool isLastFile = mOptions->split.byFileNumber && mCurrentFile >= mOptions->split.number - 1;
+        if(!isLastFile && mCurrentFileRecords >= mSplitSize) {
+            openNextFile();
+            continue;
+        }
+
+        size_t num = units - unit;
+        if(!isLastFile && mSplitSize - mCurrentFileRecords < num)
+            num = mSplitSize - mCurrentFileRecords;
+
+        // the whole buffer goes to the current file, no copy is needed
+        bool whole = unit == 0 && num == units;
+        size_t end1 = ends1[unit + num - 1];
+        handOff(mWriter1, data1, start1, end1, whole);
+        start1 = end1;
+        if(data2) {
+            size_t end2 = ends2[unit + num - 1];
+            handOff(mWriter2, data2, start2, end2, whole);
+            start2 = end2;
+        }
+        handedOver = whole;
+
+        mCurrentFileRecords += num;
+        unit += num;
+    }
+
+    if(!handedOver) {
+        recycleBuffer(data1);
+        if(data2)
+            recycleBuffer(data2);
+    }
+}
+
+void SplitWriter::handOff(WriterThread* writer, string* data, size_t start, size_t end, bool whole) {
+    if(whole) {
+        if(data->empty())
+            recycleBuffer(data);
+        else
+            writer->input(data);
+    } else if(end > start) {
+        string* piece = getBuffer();
+        piece->append(data->data() + start, end - start);
+        writer->input(piece);
+    }
+}
+
+void SplitWriter::openNextFile() {
+    finishCurrentFile();
+
+    // limit the number of files being written to limit the memory usage
+    int filesPerSplit = mPaired ? 2 : 1;
+    while(mWorkingWriters.size() >= mMaxWorkingFiles * filesPerSplit)
+        waitForOldestFile();
+
+    mCurrentFile++;
+    mCurrentFileRecords = 0;
+    mWriter1 = new WriterThread(mOptions, prefix_number(mOptions->out1, mCurrentFile, mOptions->split.digits), mBufferPool);
+    if(mPaired)
+        mWriter2 = new WriterThread(mOptions, prefix_number(mOptions->out2, mCurrentFile, mOptions->split.digits), mBufferPool);
+
+    mWorkingMtx.lock();
+    mWorkingWriters.push_back(mWriter1);
+    mWorkingThreads.push_back(new std::thread(std::bind(&SplitWriter::writeTask, this, mWriter1)));
+    if(mPaired) {
+        mWorkingWriters.push_back(mWriter2);
+        mWorkingThreads.push_back(new std::thread(std::bind(&SplitWriter::writeTask, this, mWriter2)));
+    }
+    mWorkingMtx.unlock();
+}
+
+void SplitWriter::finishCurrentFile() {
+    if(mWriter1)
+        mWriter1->setInputCompleted();
+    if(mWriter2)
+        mWriter2->setInputCompleted();
+    mWriter1 = NULL;
+    mWriter2 = NULL;
+}
+
+void SplitWriter::waitForOldestFile() {
+    if(mWorkingThreads.empty())
+        return;
+
+    mWorkingThreads[0]->join();
+
+    mWorkingMtx.lock();
+    delete mWorkingThreads[0];
+    delete mWorkingWriters[0];
+    mWorkingThreads.erase(mWorkingThreads.begin());
+    mWorkingWriters.erase(mWorkingWriters.begin());
+    mWorkingMtx.unlock();
+}
+
+void SplitWriter::close() {
+    if(mClosed)
+        return;
+    mClosed = true;
+
+    // if a task of writting N files is specified, but the input file doesn't have so many reads
+    // write some empty files so it will not break following pipelines
+    if(mOptions->split.byFileNumber) {
+        while(mCurrentFile < mOptions->split.number - 1)
+            openNextFile();
+    }
+    finishCurrentFile();
+
+    while(!mWorkingThreads.empty())
+        waitForOldestFile();
+}
+
+void SplitWriter::writeTask(WriterThread* writer) {
+    while(true) {
+        if(writer->isCompleted()){
+            // last check for possible threading related issue
+            writer->output();
+            break;
+        }
+        writer->output();
+    }
+
+    if(mOptions->verbose) {
+        string msg = writer->getFilename() + " writer finished";
+        loginfo(msg);
+    }
+}
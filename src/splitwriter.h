@@ -0,0 +1,74 @@
+#ifndef SPLIT_WRITER_H
+#define SPLIT_WRITER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include "options.h"
+#include "writerthread.h"
+#include "bufferpool.h"
+
+using namespace std;
+
+// write the output to multiple split files
+// the files are rotated by exact record numbers, so the splitting doesn't depend on the worker threads
+// each split file has its own writer thread, so the files can be compressed in parallel
+class SplitWriter{
+public:
+    SplitWriter(Options* opt, bool paired = false);
+    ~SplitWriter();
+
+    // get an empty output buffer, which is recycled from the written ones if possible
+    string* getBuffer();
+    // give back a buffer without writing it
+    void recycleBuffer(string* data);
+
+    // the ownership of data is transferred to this writer
+    // ends[i] is the end offset of the i-th unit in data, a unit is counted as a record when rotating files
+    // a unit can be empty, i.e. a read is counted but not written
+    // this function is not thread-safe, the callers should make sure only one thread calls it at a time
+    void input(string* data, const vector<size_t>& ends);
+    // for paired output, the two buffers should have the same number of units
+    void input(string* data1, const vector<size_t>& ends1, string* data2, const vector<size_t>& ends2);
+
+    // update the number of records of each file, it's applied from the current file
+    void setSplitSize(long size);
+    // the number of buffers that have not been written yet
+    long bufferLength();
+    // finish writing all files, empty files are written if the number of files is specified
+    void close();
+
+private:
+    void openNextFile();
+    void finishCurrentFile();
+    void waitForOldestFile();
+    void writeTask(WriterThread* writer);
+    void handOff(WriterThread* writer, string* data, size_t start, size_t end, bool whole);
+
+private:
+    Options* mOptions;
+    bool mPaired;
+    BufferPool* mBufferPool;
+    atomic_long mSplitSize;
+
+    // the writers of current file
+    WriterThread* mWriter1;
+    WriterThread* mWriter2;
+    // 0-based index of current file, -1 means no file is opened
+    int mCurrentFile;
+    long mCurrentFileRecords;
+    bool mClosed;
+
+    // the writers of the files which are still being written
+    vector<WriterThread*> mWorkingWriters;
+    vector<std::thread*> mWorkingThreads;
+    mutex mWorkingMtx;
+    // how many files can be written at the same time
+    int mMaxWorkingFiles;
+};
+
+#endif
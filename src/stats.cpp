@@ -2,14 +2,27 @@
 #include <memory.h>
 #include <sstream>
 #include "util.h"
+#include "simd.h"
+#include "common.h"
+#include <thread>
 
 #define KMER_LEN 5
+// the narrow histograms are flushed every 1M reads, so neither a bin nor outOfRange can overflow
+#define CYCLE_COUNTER_FLUSH_READS (1<<20)
+
+// the slot of the narrow histograms for ASCII % 8 of a base, the other letters share the last slot
+static const int COUNTER_SLOTS[8] = {5, 0, 5, 1, 2, 5, 3, 4};
+// ASCII % 8 of the base of each slot: A, C, T, N, G
+static const int COUNTER_BASES[CYCLE_COUNTER_BASES] = {1, 3, 4, 6, 7};
 
 Stats::Stats(Options* opt, bool isRead2, int guessedCycles, int bufferMargin){
     mOptions = opt;
     mIsRead2 = isRead2;
     mReads = 0;
     mLengthSum = 0;
+    mMaxLength = 0;
+    mCycleBinShift = 0;
+    memset(mReadQualHist, 0, sizeof(long) * QUAL_HIST_BINS);
 
     mEvaluatedSeqLen = mOptions->seqLen1;
     if(mIsRead2)
@@ -23,24 +36,23 @@ Stats::Stats(Options* opt, bool isRead2, int guessedCycles, int bufferMargin){
     mBases = 0;
     mQ20Total = 0;
     mQ30Total = 0;
+    mUnsampledBases = 0;
+    mUnsampledQ20 = 0;
+    mUnsampledQ30 = 0;
+    mUnsampledGC = 0;
     summarized = false;
     mKmerMin = 0;
     mKmerMax = 0;
 
     // extend the buffer to make sure it's long enough
     mBufLen = guessedCycles + bufferMargin;
+    // the bins are folded instead of extending the buffer for long reads
+    if(mOptions->longRead.enabled)
+        mBufLen = LONG_READ_MAX_BINS;
 
     for(int i=0; i<8; i++){
-        mQ20Bases[i] = 0;
-        mQ30Bases[i] = 0;
         mBaseContents[i] = 0;
 
-        mCycleQ30Bases[i] = new long[mBufLen];
-        memset(mCycleQ30Bases[i], 0, sizeof(long) * mBufLen);
-
-        mCycleQ20Bases[i] = new long[mBufLen];
-        memset(mCycleQ20Bases[i], 0, sizeof(long) * mBufLen);
-
         mCycleBaseContents[i] = new long[mBufLen];
         memset(mCycleBaseContents[i], 0, sizeof(long) * mBufLen);
 
@@ -53,6 +65,16 @@ Stats::Stats(Options* opt, bool isRead2, int guessedCycles, int bufferMargin){
     mCycleTotalQual = new long[mBufLen];
     memset(mCycleTotalQual, 0, sizeof(long)*mBufLen);
 
+    mCycleQualHist = new long[mBufLen * QUAL_HIST_BINS];
+    memset(mCycleQualHist, 0, sizeof(long) * mBufLen * QUAL_HIST_BINS);
+
+    // the narrow histograms are large, so they only cover the cycles really seen
+    mCounterBufLen = mOptions->longRead.enabled ? LONG_READ_MAX_BINS : min(guessedCycles, CYCLE_COUNTER_MAX_CYCLES);
+    mCycleCounters = new CycleQualHist[mCounterBufLen * CYCLE_COUNTER_SLOTS];
+    memset(mCycleCounters, 0, sizeof(CycleQualHist) * mCounterBufLen * CYCLE_COUNTER_SLOTS);
+    mCounterReads = 0;
+    mCounterCycles = 0;
+
     mKmerBufLen = 2<<(KMER_LEN * 2);
     mKmer = new long[mKmerBufLen];
     memset(mKmer, 0, sizeof(long)*mKmerBufLen);
@@ -67,18 +89,6 @@ void Stats::extendBuffer(int newBufLen){
     long* newBuf = NULL;
 
     for(int i=0; i<8; i++){
-        newBuf = new long[newBufLen];
-        memset(newBuf, 0, sizeof(long)*newBufLen);
-        memcpy(newBuf, mCycleQ30Bases[i], sizeof(long) * mBufLen);
-        delete mCycleQ30Bases[i];
-        mCycleQ30Bases[i] = newBuf;
-
-        newBuf = new long[newBufLen];
-        memset(newBuf, 0, sizeof(long)*newBufLen);
-        memcpy(newBuf, mCycleQ20Bases[i], sizeof(long) * mBufLen);
-        delete mCycleQ20Bases[i];
-        mCycleQ20Bases[i] = newBuf;
-
         newBuf = new long[newBufLen];
         memset(newBuf, 0, sizeof(long)*newBufLen);
         memcpy(newBuf, mCycleBaseContents[i], sizeof(long) * mBufLen);
@@ -103,17 +113,17 @@ void Stats::extendBuffer(int newBufLen){
     delete mCycleTotalQual;
     mCycleTotalQual = newBuf;
 
+    newBuf = new long[newBufLen * QUAL_HIST_BINS];
+    memset(newBuf, 0, sizeof(long) * newBufLen * QUAL_HIST_BINS);
+    memcpy(newBuf, mCycleQualHist, sizeof(long) * mBufLen * QUAL_HIST_BINS);
+    delete[] mCycleQualHist;
+    mCycleQualHist = newBuf;
+
     mBufLen = newBufLen;
 }
 
 Stats::~Stats() {
     for(int i=0; i<8; i++){
-        delete mCycleQ30Bases[i];
-        mCycleQ30Bases[i] = NULL;
-
-        delete mCycleQ20Bases[i];
-        mCycleQ20Bases[i] = NULL;
-
         delete mCycleBaseContents[i];
         mCycleBaseContents[i] = NULL;
 
@@ -123,6 +133,8 @@ Stats::~Stats() {
 
     delete mCycleTotalBase;
     delete mCycleTotalQual;
+    delete[] mCycleQualHist;
+    delete[] mCycleCounters;
 
     // delete memory of curves
     map<string, double*>::iterator iter;
@@ -135,12 +147,17 @@ Stats::~Stats() {
     delete mKmer;
 
     deleteOverRepSeqDist();
+    for(int k=0; k<mOverRepSketches.size(); k++) {
+        delete mOverRepSketches[k];
+    }
 }
 
 void Stats::summarize(bool forced) {
     if(summarized && !forced)
         return;
 
+    flushCycleCounters();
+
     // first get the cycle and count total bases
     for(int c=0; c<mBufLen; c++) {
         mBases += mCycleTotalBase[c];
@@ -151,16 +168,25 @@ void Stats::summarize(bool forced) {
     }
     if(mCycleTotalBase[mBufLen-1]>0)
         mCycles = mBufLen;
+    mBases += mUnsampledBases;
 
-    // Q20, Q30, base content
+    // Q20, Q30 from the quality histograms
+    for(int c=0; c<mCycles; c++) {
+        long* hist = mCycleQualHist + c * QUAL_HIST_BINS;
+        for(int q=20; q<QUAL_HIST_BINS; q++) {
+            mQ20Total += hist[q];
+            if(q >= 30)
+                mQ30Total += hist[q];
+        }
+    }
+    mQ20Total += mUnsampledQ20;
+    mQ30Total += mUnsampledQ30;
+
+    // base content
     for(int i=0; i<8; i++) {
         for(int c=0; c<mCycles; c++) {
-            mQ20Bases[i] += mCycleQ20Bases[i][c];
-            mQ30Bases[i] += mCycleQ30Bases[i][c];
             mBaseContents[i] += mCycleBaseContents[i][c];
         }
-        mQ20Total += mQ20Bases[i];
-        mQ30Total += mQ30Bases[i];
     }
 
 
@@ -172,6 +198,16 @@ void Stats::summarize(bool forced) {
     }
     mQualityCurves["mean"] = meanQualCurve;
 
+    // quality quartile curves
+    string quartileNames[3] = {"lower_quartile", "median", "upper_quartile"};
+    for(int i=0; i<3; i++) {
+        double* quartileCurve = new double[mCycles];
+        for(int c=0; c<mCycles; c++) {
+            quartileCurve[c] = getQualQuantile(c, (i+1) * 0.25);
+        }
+        mQualityCurves[quartileNames[i]] = quartileCurve;
+    }
+
     // quality curves and base content curves for different nucleotides
     char alphabets[5] = {'A', 'T', 'C', 'G', 'N'};
     for(int i=0; i<5; i++) {
@@ -215,6 +251,94 @@ void Stats::summarize(bool forced) {
     summarized = true;
 }
 
+void Stats::flushCycleCounters() {
+    for(int c=0; c<mCounterCycles; c++) {
+        long* cycleHist = mCycleQualHist + c * QUAL_HIST_BINS;
+        for(int s=0; s<CYCLE_COUNTER_SLOTS; s++) {
+            CycleQualHist& hist = mCycleCounters[c * CYCLE_COUNTER_SLOTS + s];
+            long count = 0;
+            long qualSum = hist.outOfRange;
+            for(int q=0; q<QUAL_HIST_BINS; q++) {
+                count += hist.bins[q];
+                qualSum += (long)q * hist.bins[q];
+                cycleHist[q] += hist.bins[q];
+            }
+            // the other letters have no curves, so they are only counted in the totals
+            if(s < CYCLE_COUNTER_BASES) {
+                mCycleBaseContents[COUNTER_BASES[s]][c] += count;
+                mCycleBaseQual[COUNTER_BASES[s]][c] += qualSum;
+            }
+            mCycleTotalBase[c] += count;
+            mCycleTotalQual[c] += qualSum;
+        }
+    }
+    memset(mCycleCounters, 0, sizeof(CycleQualHist) * mCounterCycles * CYCLE_COUNTER_SLOTS);
+    mCounterReads = 0;
+    mCounterCycles = 0;
+}
+
+void Stats::extendCycleCounters(int newLen) {
+    // the histograms are empty after flushing, so they are just reallocated
+    flushCycleCounters();
+    delete[] mCycleCounters;
+    mCounterBufLen = newLen;
+    mCycleCounters = new CycleQualHist[mCounterBufLen * CYCLE_COUNTER_SLOTS];
+    memset(mCycleCounters, 0, sizeof(CycleQualHist) * mCounterBufLen * CYCLE_COUNTER_SLOTS);
+}
+
+double Stats::getQualQuantile(int cycle, double quantile) {
+    long total = mCycleTotalBase[cycle];
+    if(total == 0)
+        return 0.0;
+    long* hist = mCycleQualHist + cycle * QUAL_HIST_BINS;
+    long accumulated = 0;
+    for(int q=0; q<QUAL_HIST_BINS; q++) {
+        accumulated += hist[q];
+        if(accumulated >= quantile * total)
+            return q;
+    }
+    return QUAL_HIST_BINS - 1;
+}
+
+void Stats::foldCycles() {
+    // the narrow histograms are flushed, so only the 64-bit arrays are folded
+    flushCycleCounters();
+    int half = mBufLen / 2;
+    for(int c=0; c<half; c++) {
+        for(int i=0; i<8; i++) {
+            mCycleBaseContents[i][c] = mCycleBaseContents[i][c * 2] + mCycleBaseContents[i][c * 2 + 1];
+            mCycleBaseQual[i][c] = mCycleBaseQual[i][c * 2] + mCycleBaseQual[i][c * 2 + 1];
+        }
+        mCycleTotalBase[c] = mCycleTotalBase[c * 2] + mCycleTotalBase[c * 2 + 1];
+        mCycleTotalQual[c] = mCycleTotalQual[c * 2] + mCycleTotalQual[c * 2 + 1];
+        for(int q=0; q<QUAL_HIST_BINS; q++)
+            mCycleQualHist[c * QUAL_HIST_BINS + q] = mCycleQualHist[c * 2 * QUAL_HIST_BINS + q] + mCycleQualHist[(c * 2 + 1) * QUAL_HIST_BINS + q];
+    }
+    for(int i=0; i<8; i++) {
+        memset(mCycleBaseContents[i] + half, 0, sizeof(long) * (mBufLen - half));
+        memset(mCycleBaseQual[i] + half, 0, sizeof(long) * (mBufLen - half));
+    }
+    memset(mCycleTotalBase + half, 0, sizeof(long) * (mBufLen - half));
+    memset(mCycleTotalQual + half, 0, sizeof(long) * (mBufLen - half));
+    memset(mCycleQualHist + half * QUAL_HIST_BINS, 0, sizeof(long) * (mBufLen - half) * QUAL_HIST_BINS);
+    mCycleBinShift++;
+}
+
+void Stats::statLongRead(const char* qualstr, int len) {
+    int lengthBin = len / LONG_READ_LENGTH_BIN;
+    if(lengthBin >= mReadLengthHist.size())
+        mReadLengthHist.resize(lengthBin + 1, 0);
+    mReadLengthHist[lengthBin]++;
+
+    if(len == 0)
+        return;
+    long qualSum = 0;
+    for(int i=0; i<len; i++)
+        qualSum += qualstr[i] - 33;
+    int meanQual = min(max(qualSum / len, 0L), (long)QUAL_HIST_BINS - 1);
+    mReadQualHist[meanQual]++;
+}
+
 int Stats::getMeanLength() {
     if(mReads == 0)
         return 0.0;
@@ -222,42 +346,129 @@ int Stats::getMeanLength() {
         return mLengthSum/mReads;
 }
 
-void Stats::statRead(Read* r) {
-    int len = r->length();
+void Stats::statRead(Read* r, long index) {
+    statRead(r->mSeq.mStr.c_str(), r->mQuality.c_str(), r->length(), index, &r->mProfile);
+}
+
+bool Stats::isSampled(long index) {
+    if(mOptions->stats.byPack)
+        return (index / PACK_SIZE) % mOptions->stats.sampling == 0;
+    return index % mOptions->stats.sampling == 0;
+}
 
+void Stats::statRead(const char* seqstr, const char* qualstr, int len, long index, ReadProfile* profile) {
     mLengthSum += len;
+    mMaxLength = max(mMaxLength, len);
+
+    if(mOptions->longRead.enabled)
+        statLongRead(qualstr, len);
+
+    if(isSampled(index))
+        statCycles(seqstr, qualstr, len, profile);
+    else
+        statUnsampled(seqstr, qualstr, len, profile);
 
-    if(mBufLen < len) {
-        extendBuffer(max(len + 100, (int)(len * 1.5)));
+    // do overrepresentation analysis for 1 of every 100 reads
+    if(mOptions->overRepAnalysis.enabled) {
+        if(mReads % mOptions->overRepAnalysis.sampling == 0) {
+            for(int s=0; s<mOverRepSketches.size(); s++) {
+                mOverRepSketches[s]->add(seqstr, len);
+            }
+            mOverRepSampledBases += len;
+        }
+    }
+
+    mReads++;
+}
+
+void Stats::setProfile(ReadProfile* profile, int len, int lowQual, int nBase, int totalQual, int diff) {
+    profile->valid = true;
+    profile->qualifiedQual = mOptions->qualfilter.qualifiedQual;
+    profile->len = len;
+    profile->lowQual = lowQual;
+    profile->nBase = nBase;
+    profile->totalQual = totalQual;
+    profile->diff = diff;
+}
+
+void Stats::statUnsampled(const char* seqstr, const char* qualstr, int len, ReadProfile* profile) {
+    // the same as counting the quality histograms and base contents, but only the totals are kept
+    BaseCounts counts;
+    Simd::countBases(seqstr, qualstr, len, mOptions->qualfilter.qualifiedQual, &counts);
+    mUnsampledBases += len;
+    mUnsampledQ20 += counts.q20;
+    mUnsampledQ30 += counts.q30;
+    mUnsampledGC += counts.gc;
+    if(profile)
+        setProfile(profile, len, counts.lowQual, counts.nBase, counts.totalQual, counts.diff);
+}
+
+void Stats::statCycles(const char* seqstr, const char* qualstr, int len, ReadProfile* profile) {
+    if(mOptions->longRead.enabled) {
+        while(((len - 1) >> mCycleBinShift) >= mBufLen)
+            foldCycles();
+    } else {
+        if(mBufLen < len) {
+            extendBuffer(max(len + 100, (int)(len * 1.5)));
+        }
+        // the cycles after the narrow histograms are counted in the 64-bit arrays directly
+        if(mCounterBufLen < min(len, CYCLE_COUNTER_MAX_CYCLES)) {
+            extendCycleCounters(min(max(len + 100, (int)(len * 1.5)), CYCLE_COUNTER_MAX_CYCLES));
+        }
+    }
+    int shift = mCycleBinShift;
+    int bins = ((len - 1) >> shift) + 1;
+
+    // a read can add (1 << shift) to a bin of the narrow histograms, so it's counted as (1 << shift) reads
+    if(mCounterReads >= CYCLE_COUNTER_FLUSH_READS)
+        flushCycleCounters();
+    mCounterReads += 1 << shift;
+    if(len > 0)
+        mCounterCycles = max(mCounterCycles, min(bins, mCounterBufLen));
+
+    char qualifiedQual = mOptions->qualfilter.qualifiedQual;
+    int lowQual = 0;
+    int nBase = 0;
+    int totalQual = 0;
+    int diff = 0;
+
+    // the per-cycle quality stats, the bin is clamped and the base is mapped to its slot without branch
+    int counted = min(len, mCounterBufLen << shift);
+    for(int i=0; i<counted; i++) {
+        int q = qualstr[i] - 33;
+        int bin = min(max(q, 0), QUAL_HIST_BINS - 1);
+        CycleQualHist& hist = mCycleCounters[(i >> shift) * CYCLE_COUNTER_SLOTS + COUNTER_SLOTS[seqstr[i] & 0x07]];
+        hist.bins[bin]++;
+        hist.outOfRange += q - bin;
+    }
+    // the cycles after the narrow histograms, only for long reads
+    for(int i=counted; i<len; i++) {
+        int b = seqstr[i] & 0x07;
+        int q = qualstr[i] - 33;
+        int cycle = i >> shift;
+        if(COUNTER_SLOTS[b] < CYCLE_COUNTER_BASES) {
+            mCycleBaseContents[b][cycle]++;
+            mCycleBaseQual[b][cycle] += q;
+        }
+        mCycleTotalBase[cycle]++;
+        mCycleTotalQual[cycle] += q;
+        mCycleQualHist[cycle * QUAL_HIST_BINS + min(max(q, 0), QUAL_HIST_BINS - 1)]++;
     }
-    const char* seqstr = r->mSeq.mStr.c_str();
-    const char* qualstr = r->mQuality.c_str();
 
     int kmer = 0;
     bool needFullCompute = true;
     for(int i=0; i<len; i++) {
         char base = seqstr[i];
         char qual = qualstr[i];
-        // get last 3 bits
-        char b = base & 0x07;
-
-        const char q20 = '5';
-        const char q30 = '?';
+        int q = qual - 33;
 
-        if(qual >= q30) {
-            mCycleQ30Bases[b][i]++;
-            mCycleQ20Bases[b][i]++;
-        } else if(qual >= q20) {
-            mCycleQ20Bases[b][i]++;
-        }
-
-        mCycleBaseContents[b][i]++;
-        mCycleBaseQual[b][i] += (qual-33);
-
-        mCycleTotalBase[i]++;
-        mCycleTotalQual[i] += (qual-33);
+        // the profile for the filters
+        lowQual += qual < qualifiedQual;
+        totalQual += q;
+        diff += i > 0 && base != seqstr[i-1];
 
         if(base == 'N'){
+            nBase++;
             needFullCompute = true;
             continue;
         }
@@ -299,27 +510,8 @@ void Stats::statRead(Read* r) {
 
     }
 
-    // do overrepresentation analysis for 1 of every 100 reads
-    if(mOptions->overRepAnalysis.enabled) {
-        if(mReads % mOptions->overRepAnalysis.sampling == 0) {
-            const int steps[5] = {10, 20, 40, 100, min(150, mEvaluatedSeqLen-2)};
-            for(int s=0; s<5; s++) {
-                int step = steps[s];
-                for(int i=0; i<len-step; i++) {
-                    string seq = r->mSeq.mStr.substr(i, step);
-                    if(mOverRepSeq.count(seq)>0) {
-                        mOverRepSeq[seq]++;
-                        for(int p = i; p < seq.length() + i && p < mEvaluatedSeqLen; p++) {
-                            mOverRepSeqDist[seq][p]++;
-                        }
-                        i+=step;
-                    }
-                }
-            }
-        }
-    }
-
-    mReads++;
+    if(profile)
+        setProfile(profile, len, lowQual, nBase, totalQual, diff);
 }
 
 int Stats::base2val(char base) {
@@ -340,6 +532,9 @@ int Stats::base2val(char base) {
 int Stats::getCycles() {
     if(!summarized)
         summarize();
+    // mCycles is the number of position bins for long reads
+    if(mOptions->longRead.enabled)
+        return mMaxLength;
     return mCycles;
 }
 
@@ -370,7 +565,7 @@ long Stats::getQ30() {
 long Stats::getGCNumber() {
     if(!summarized)
         summarize();
-    return mBaseContents['G' & 0x07] + mBaseContents['C' & 0x07];
+    return mBaseContents['G' & 0x07] + mBaseContents['C' & 0x07] + mUnsampledGC;
 }
 
 void Stats::print() {
@@ -390,7 +585,15 @@ void Stats::reportJson(ofstream& ofs, string padding) {
     ofs << padding << "\t" << "\"total_bases\": " << mBases << "," << endl;
     ofs << padding << "\t" << "\"q20_bases\": " << mQ20Total << "," << endl;
     ofs << padding << "\t" << "\"q30_bases\": " << mQ30Total << "," << endl;
-    ofs << padding << "\t" << "\"total_cycles\": " << mCycles << "," << endl;
+    ofs << padding << "\t" << "\"total_cycles\": " << getCycles() << "," << endl;
+
+    // the curves are binned by position for long reads
+    if(mOptions->longRead.enabled) {
+        ofs << padding << "\t" << "\"cycle_bin_size\": " << (1 << mCycleBinShift) << "," << endl;
+        ofs << padding << "\t" << "\"read_length_bin_size\": " << LONG_READ_LENGTH_BIN << "," << endl;
+        ofs << padding << "\t" << "\"read_length_histogram\": [" << list2string(mReadLengthHist.data(), mReadLengthHist.size()) << "]," << endl;
+        ofs << padding << "\t" << "\"read_mean_quality_histogram\": [" << list2string(mReadQualHist, QUAL_HIST_BINS) << "]," << endl;
+    }
 
     // quality curves
     string qualNames[5] = {"A", "T", "C", "G", "mean"};
@@ -413,6 +616,27 @@ void Stats::reportJson(ofstream& ofs, string padding) {
     }
     ofs << padding << "\t" << "}," << endl;
 
+    // quality quartile curves
+    string quartileNames[3] = {"lower_quartile", "median", "upper_quartile"};
+    ofs << padding << "\t" << "\"quality_quartile_curves\": {" << endl;
+    for(int i=0 ;i<3; i++) {
+        string name=quartileNames[i];
+        double* curve = mQualityCurves[name];
+        ofs << padding << "\t\t" << "\"" << name << "\":[";
+        for(int c = 0; c<mCycles; c++) {
+            ofs << curve[c];
+            // not the end
+            if(c != mCycles - 1)
+                ofs << ",";
+        }
+        ofs << "]";
+        // not the end;
+        if(i != 3-1)
+            ofs << ",";
+        ofs << endl; 
+    }
+    ofs << padding << "\t" << "}," << endl;
+
     // content curves
     string contentNames[6] = {"A", "T", "C", "G", "N", "GC"};
     ofs << padding << "\t" << "\"content_curves\": {" << endl;
@@ -518,7 +742,20 @@ string Stats::list2string(long* list, int size) {
     return ss.str();
 }
 
+string Stats::positions2string(long* x, int size) {
+    stringstream ss;
+    for(int i=0; i<size; i++) {
+        ss << ((x[i] - 1) << mCycleBinShift) + 1;
+        if(i < size-1)
+            ss << ",";
+    }
+    return ss.str();
+}
+
 void Stats::reportHtml(ofstream& ofs, string filteringType, string readName) {
+    if(mOptions->longRead.enabled) {
+        reportHtmlLongRead(ofs, filteringType, readName);
+    }
     reportHtmlQuality(ofs, filteringType, readName);
     reportHtmlContents(ofs, filteringType, readName);
     reportHtmlKMER(ofs, filteringType, readName);
@@ -559,7 +796,7 @@ void Stats::reportHtmlORA(ofstream& ofs, string filteringType, string readName)
     ofs << "<div  id='" << divName << "'>\n";
     ofs << "<div class='sub_section_tips'>Sampling rate: 1 / " << mOptions->overRepAnalysis.sampling << "</div>\n";
     ofs << "<table class='summary_table'>\n";
-    ofs << "<tr style='font-weight:bold;'><td>overrepresented sequence</td><td>count (% of bases)</td><td>distribution: cycle 1 ~ cycle " << mEvaluatedSeqLen << "</td></tr>"<<endl;
+    ofs << "<tr style='font-weight:bold;'><td>overrepresented sequence</td><td>count (% of bases)</td><td>distribution: cycle 1 ~ cycle " << mOverRepDistLen << "</td></tr>"<<endl;
     int found = 0;
     for(iter=mOverRepSeq.begin(); iter!=mOverRepSeq.end(); iter++) {
         string seq = iter->first;
@@ -581,7 +818,7 @@ void Stats::reportHtmlORA(ofstream& ofs, string filteringType, string readName)
 
     // output the JS
     ofs << "<script language='javascript'>" << endl;
-    ofs << "var seqlen = " << mEvaluatedSeqLen << ";" << endl;
+    ofs << "var seqlen = " << mOverRepDistLen << ";" << endl;
     ofs << "var orp_dist = {" << endl;
     bool first = true;
     for(iter=mOverRepSeq.begin(); iter!=mOverRepSeq.end(); iter++) {
@@ -595,7 +832,7 @@ void Stats::reportHtmlORA(ofstream& ofs, string filteringType, string readName)
         } else
             first = false;
         ofs << "\t\"" << divName << "_" << seq << "\":[";
-        for(int i=0; i<mEvaluatedSeqLen; i++){
+        for(int i=0; i<mOverRepDistLen; i++){
             if(i !=0 )
                 ofs << ",";
             ofs << mOverRepSeqDist[seq][i];
@@ -629,7 +866,47 @@ void Stats::reportHtmlORA(ofstream& ofs, string filteringType, string readName)
 }
 
 bool Stats::isLongRead() {
-    return mCycles > 300;
+    return mOptions->longRead.enabled || mCycles > 300;
+}
+
+void Stats::reportHtmlLongRead(ofstream& ofs, string filteringType, string readName) {
+    string subsection = filteringType + ": " + readName + ": read length and quality";
+    string divName = replace(subsection, " ", "_");
+    divName = replace(divName, ":", "_");
+
+    ofs << "<div class='subsection_title'><a title='click to hide/show' onclick=showOrHide('" << divName << "')>" + subsection + "</a></div>\n";
+    ofs << "<div id='" + divName + "'>\n";
+    ofs << "<div class='sub_section_tips'>Read length in " << LONG_READ_LENGTH_BIN << "bp bins, and the mean quality score of reads.</div>\n";
+    ofs << "<div class='figure' id='plot_" + divName + "_length'></div>\n";
+    ofs << "<div class='figure' id='plot_" + divName + "_quality'></div>\n";
+    ofs << "</div>\n";
+
+    long* lengths = new long[mReadLengthHist.size()];
+    for(int i=0; i<mReadLengthHist.size(); i++)
+        lengths[i] = i * LONG_READ_LENGTH_BIN;
+    long quals[QUAL_HIST_BINS];
+    for(int q=0; q<QUAL_HIST_BINS; q++)
+        quals[q] = q;
+
+    ofs << "\n<script type=\"text/javascript\">" << endl;
+    string json_str = "var data=[{";
+    json_str += "x:[" + list2string(lengths, mReadLengthHist.size()) + "],";
+    json_str += "y:[" + list2string(mReadLengthHist.data(), mReadLengthHist.size()) + "],";
+    json_str += "name: 'reads', type:'bar', marker:{color:'rgba(20,20,20,1.0)'}}];\n";
+    json_str += "var layout={title:'', xaxis:{title:'read length'}, yaxis:{title:'reads'}};\n";
+    json_str += "Plotly.newPlot('plot_" + divName + "_length', data, layout);\n";
+
+    json_str += "data=[{";
+    json_str += "x:[" + list2string(quals, QUAL_HIST_BINS) + "],";
+    json_str += "y:[" + list2string(mReadQualHist, QUAL_HIST_BINS) + "],";
+    json_str += "name: 'reads', type:'bar', marker:{color:'rgba(20,20,20,1.0)'}}];\n";
+    json_str += "layout={title:'', xaxis:{title:'mean quality'}, yaxis:{title:'reads'}};\n";
+    json_str += "Plotly.newPlot('plot_" + divName + "_quality', data, layout);\n";
+
+    ofs << json_str;
+    ofs << "</script>" << endl;
+
+    delete[] lengths;
 }
 
 void Stats::reportHtmlKMER(ofstream& ofs, string filteringType, string readName) {
@@ -730,8 +1007,8 @@ void Stats::reportHtmlQuality(ofstream& ofs, string filteringType, string readNa
     ofs << "<div class='figure' id='plot_" + divName + "'></div>\n";
     ofs << "</div>\n";
     
-    string alphabets[5] = {"A", "T", "C", "G", "mean"};
-    string colors[5] = {"rgba(128,128,0,1.0)", "rgba(128,0,128,1.0)", "rgba(0,255,0,1.0)", "rgba(0,0,255,1.0)", "rgba(20,20,20,1.0)"};
+    string alphabets[8] = {"A", "T", "C", "G", "mean", "lower_quartile", "median", "upper_quartile"};
+    string colors[8] = {"rgba(128,128,0,1.0)", "rgba(128,0,128,1.0)", "rgba(0,255,0,1.0)", "rgba(0,0,255,1.0)", "rgba(20,20,20,1.0)", "rgba(160,160,160,1.0)", "rgba(100,100,100,1.0)", "rgba(160,160,160,1.0)"};
     ofs << "\n<script type=\"text/javascript\">" << endl;
     string json_str = "var data=[";
 
@@ -765,15 +1042,19 @@ void Stats::reportHtmlQuality(ofstream& ofs, string filteringType, string readNa
             }
         }
     }
-    // four bases
-    for (int b = 0; b<5; b++) {
+    // four bases, mean and the quartiles
+    for (int b = 0; b<8; b++) {
         string base = alphabets[b];
         json_str += "{";
-        json_str += "x:[" + list2string(x, total) + "],";
+        json_str += "x:[" + positions2string(x, total) + "],";
         json_str += "y:[" + list2string(mQualityCurves[base], total, x) + "],";
         json_str += "name: '" + base + "',";
         json_str += "mode:'lines',";
-        json_str += "line:{color:'" + colors[b] + "', width:1}\n";
+        // the quartiles are dotted
+        if(b >= 5)
+            json_str += "line:{color:'" + colors[b] + "', width:1, dash:'dot'}\n";
+        else
+            json_str += "line:{color:'" + colors[b] + "', width:1}\n";
         json_str += "},";
     }
     json_str += "];\n";
@@ -856,7 +1137,7 @@ void Stats::reportHtmlContents(ofstream& ofs, string filteringType, string readN
         string name = base + "(" + percentage + "%)"; 
 
         json_str += "{";
-        json_str += "x:[" + list2string(x, total) + "],";
+        json_str += "x:[" + positions2string(x, total) + "],";
         json_str += "y:[" + list2string(mContentCurves[base], total, x) + "],";
         json_str += "name: '" + name + "',";
         json_str += "mode:'lines',";
@@ -882,29 +1163,50 @@ Stats* Stats::merge(vector<Stats*>& list) {
     if(list.size() == 0)
         return NULL;
 
+    // the position bins of the threads can have different sizes for long reads
+    int binShift = 0;
+    for(int t=0; t<list.size(); t++) {
+        binShift = max(binShift, list[t]->mCycleBinShift);
+    }
+    for(int t=0; t<list.size(); t++) {
+        while(list[t]->mCycleBinShift < binShift)
+            list[t]->foldCycles();
+    }
+
     //get the most long cycles
     int cycles = 0;
     for(int t=0; t<list.size(); t++) {
         list[t]->summarize();
-        cycles = max(cycles, list[t]->getCycles());
+        cycles = max(cycles, list[t]->mCycles);
     }
 
     Stats* s = new Stats(list[0]->mOptions, list[0]->mIsRead2, cycles, 0);
-
-    // init overrepresented seq maps
-    map<string, long>::iterator iter;
+    s->mCycleBinShift = binShift;
 
     for(int t=0; t<list.size(); t++) {
-        int curCycles =  list[t]->getCycles();
+        int curCycles =  list[t]->mCycles;
         // merge read number
         s->mReads += list[t]->mReads;
         s->mLengthSum += list[t]->mLengthSum;
+        s->mMaxLength = max(s->mMaxLength, list[t]->mMaxLength);
+
+        // merge long read histograms
+        if(s->mReadLengthHist.size() < list[t]->mReadLengthHist.size())
+            s->mReadLengthHist.resize(list[t]->mReadLengthHist.size(), 0);
+        for(int i=0; i<list[t]->mReadLengthHist.size(); i++) {
+            s->mReadLengthHist[i] += list[t]->mReadLengthHist[i];
+        }
+        for(int q=0; q<QUAL_HIST_BINS; q++) {
+            s->mReadQualHist[q] += list[t]->mReadQualHist[q];
+        }
+        s->mUnsampledBases += list[t]->mUnsampledBases;
+        s->mUnsampledQ20 += list[t]->mUnsampledQ20;
+        s->mUnsampledQ30 += list[t]->mUnsampledQ30;
+        s->mUnsampledGC += list[t]->mUnsampledGC;
 
         // merge per cycle counting for different bases
         for(int i=0; i<8; i++){
             for(int j=0; j<cycles && j<curCycles; j++) {
-                s->mCycleQ30Bases[i][j] += list[t]->mCycleQ30Bases[i][j];
-                s->mCycleQ20Bases[i][j] += list[t]->mCycleQ20Bases[i][j];
                 s->mCycleBaseContents[i][j] += list[t]->mCycleBaseContents[i][j];
                 s->mCycleBaseQual[i][j] += list[t]->mCycleBaseQual[i][j];
             }
@@ -916,42 +1218,142 @@ Stats* Stats::merge(vector<Stats*>& list) {
             s->mCycleTotalQual[j] += list[t]->mCycleTotalQual[j];
         }
 
+        // merge quality histograms
+        for(int j=0; j<cycles * QUAL_HIST_BINS && j<curCycles * QUAL_HIST_BINS; j++) {
+            s->mCycleQualHist[j] += list[t]->mCycleQualHist[j];
+        }
+
         // merge kMer
         for(int i=0; i<s->mKmerBufLen; i++) {
             s->mKmer[i] += list[t]->mKmer[i];
         }
 
-        // merge over rep seq
-        for(iter = s->mOverRepSeq.begin(); iter != s->mOverRepSeq.end(); iter++) {
-            string seq = iter->first;
-            s->mOverRepSeq[seq] += list[t]->mOverRepSeq[seq];
-            if(s->mIsRead2 != list[t]->mIsRead2 || list[t]->mOverRepSeqDist[seq] == NULL)
-                cerr << t <<seq<< ":" << (s->mIsRead2?2:1 ) << "," << (list[t]->mIsRead2?2:1 ) <<endl;
-            for(int i=0; i<s->mEvaluatedSeqLen; i++) {
-                s->mOverRepSeqDist[seq][i] += list[t]->mOverRepSeqDist[seq][i];
-            }
+        // merge over rep seq sketches, they are created with the same lengths
+        for(int k=0; k<s->mOverRepSketches.size(); k++) {
+            s->mOverRepSketches[k]->merge(list[t]->mOverRepSketches[k]);
         }
+        s->mOverRepSampledBases += list[t]->mOverRepSampledBases;
     }
 
+    if(s->mOptions->overRepAnalysis.enabled)
+        s->selectOverRepSeqs();
+
     s->summarize();
 
     return s;
 }
 
 void Stats::initOverRepSeq() {
-    map<string, long> overRepSeq;
-    if(mIsRead2)
-        overRepSeq = mOptions->overRepSeqs2;
-    else
-        overRepSeq = mOptions->overRepSeqs1;
+    mOverRepSampledBases = 0;
+    mOverRepDistLen = min(mEvaluatedSeqLen, OVER_REP_MAX_DIST_LEN);
+    if(!mOptions->overRepAnalysis.enabled)
+        return;
 
+    // 10, 20, 40, 100, 150 or (cycles - 2)
+    const int steps[5] = {10, 20, 40, 100, min(150, mEvaluatedSeqLen-2)};
+    for(int s=0; s<5; s++) {
+        bool duplicated = false;
+        for(int k=0; k<mOverRepSketches.size(); k++) {
+            if(mOverRepSketches[k]->seqLen() == steps[s])
+                duplicated = true;
+        }
+        if(steps[s] >= 10 && !duplicated)
+            mOverRepSketches.push_back(new OverRepSketch(steps[s], mOverRepDistLen));
+    }
+}
+
+void Stats::selectOverRepSeqs() {
+    // the count thresholds were for about 10K reads of 151 bp, now they are scaled to the sampled bases
+    double scale = max(1.0, mOverRepSampledBases / (151.0 * 10000));
+    map<string, long> hotSeqs;
+    map<string, long*> hotSeqDists;
+    for(int s=0; s<mOverRepSketches.size(); s++) {
+        OverRepSketch* sketch = mOverRepSketches[s];
+        int seqLen = sketch->seqLen();
+        long minCount;
+        if(seqLen >= mEvaluatedSeqLen-1)
+            minCount = 3;
+        else if(seqLen >= 100)
+            minCount = 5;
+        else if(seqLen >= 40)
+            minCount = 20;
+        else if(seqLen >= 20)
+            minCount = 100;
+        else
+            minCount = 500;
+
+        for(int i=0; i<sketch->size(); i++) {
+            long count = sketch->getCount(i);
+            if(count < minCount * scale)
+                continue;
+            string seq = sketch->getSeq(i);
+            hotSeqs[seq] = count;
+            long* dist = new long[mOverRepDistLen];
+            sketch->getDist(i, dist);
+            hotSeqDists[seq] = dist;
+        }
+    }
+
+    // remove substrings
+    vector<string> seqs;
+    vector<long> counts;
     map<string, long>::iterator iter;
-    for(iter = overRepSeq.begin(); iter!=overRepSeq.end(); iter++) {
-        string seq = iter->first;
-        mOverRepSeq[seq] = 0;
-        long* distBuf = new long[mEvaluatedSeqLen];
-        memset(distBuf, 0, sizeof(long)*mEvaluatedSeqLen);
-        mOverRepSeqDist[seq] = distBuf;
+    for(iter = hotSeqs.begin(); iter!=hotSeqs.end(); iter++) {
+        seqs.push_back(iter->first);
+        counts.push_back(iter->second);
+    }
+    vector<vector<int>> containers;
+    findContainers(seqs, containers);
+
+    // like the sequences are removed one by one in order, only the containers not removed yet are used
+    vector<bool> removed(seqs.size(), false);
+    for(int i=0; i<seqs.size(); i++) {
+        for(int c=0; c<containers[i].size(); c++) {
+            int container = containers[i][c];
+            if(!removed[container] && counts[i] / counts[container] < 10) {
+                removed[i] = true;
+                break;
+            }
+        }
+        if(removed[i]) {
+            delete[] hotSeqDists[seqs[i]];
+        } else {
+            mOverRepSeq[seqs[i]] = counts[i];
+            mOverRepSeqDist[seqs[i]] = hotSeqDists[seqs[i]];
+        }
+    }
+}
+
+void Stats::findContainers(vector<string>& seqs, vector<vector<int>>& containers) {
+    OverRepIndex index;
+    for(int i=0; i<seqs.size(); i++)
+        index.add(seqs[i], i);
+    vector<int> lengths = index.lengths();
+
+    // each longer sequence is scanned with the index, and the scanning is split across threads
+    int threads = min(mOptions->thread, (int)seqs.size() / 256 + 1);
+    vector<vector<pair<int, int>>> found(threads);
+    vector<std::thread*> workers;
+    for(int t=0; t<threads; t++) {
+        workers.push_back(new std::thread([&, t](){
+            vector<OverRepHit> hits;
+            for(int s=t; s<seqs.size(); s+=threads) {
+                for(int l=0; l<lengths.size() && lengths[l] < seqs[s].length(); l++) {
+                    index.match(seqs[s].c_str(), seqs[s].length(), lengths[l], hits, true);
+                    for(int h=0; h<hits.size(); h++)
+                        found[t].push_back(make_pair(hits[h].id, s));
+                }
+            }
+        }));
+    }
+
+    containers.clear();
+    containers.resize(seqs.size());
+    for(int t=0; t<threads; t++) {
+        workers[t]->join();
+        delete workers[t];
+        for(int f=0; f<found[t].size(); f++)
+            containers[found[t][f].first].push_back(found[t][f].second);
     }
 }
 
@@ -964,3 +1366,113 @@ void Stats::deleteOverRepSeqDist() {
     }
 }
 
+
+bool Stats::test() {
+    Options opt;
+    opt.stats.sampling = 7;
+    unsigned int seed = 1;
+    const char bases[5] = {'A', 'C', 'G', 'T', 'N'};
+    vector<string> seqs;
+    vector<string> quals;
+    for(int i=0; i<5 * PACK_SIZE + 123; i++) {
+        string seq(100, 'A');
+        string qual(100, 'I');
+        for(int c=0; c<100; c++) {
+            seed = seed * 1103515245 + 12345;
+            seq[c] = bases[(seed >> 16) % 5];
+            qual[c] = 33 + (seed >> 20) % 42;
+        }
+        seqs.push_back(seq);
+        quals.push_back(qual);
+    }
+
+    for(int byPack=0; byPack<2; byPack++) {
+        opt.stats.byPack = byPack == 1;
+        // one thread reads all the packs in order, and four threads get the packs in the reverse order randomly
+        vector<Stats*> single;
+        vector<Stats*> threads;
+        single.push_back(new Stats(&opt));
+        for(int t=0; t<4; t++)
+            threads.push_back(new Stats(&opt));
+        int packs = (seqs.size() + PACK_SIZE - 1) / PACK_SIZE;
+        for(int p=0; p<packs; p++) {
+            int shuffled = packs - 1 - p;
+            seed = seed * 1103515245 + 12345;
+            Stats* thread = threads[(seed >> 16) % 4];
+            for(long i=p * PACK_SIZE; i<seqs.size() && i<(p + 1) * PACK_SIZE; i++)
+                single[0]->statRead(seqs[i].c_str(), quals[i].c_str(), 100, i);
+            for(long i=shuffled * PACK_SIZE; i<seqs.size() && i<(shuffled + 1) * PACK_SIZE; i++)
+                thread->statRead(seqs[i].c_str(), quals[i].c_str(), 100, i);
+        }
+        Stats* s1 = merge(single);
+        Stats* s4 = merge(threads);
+        bool same = s1->mReads == s4->mReads && s1->mQ30Total == s4->mQ30Total && s1->mCycles == s4->mCycles;
+        for(int b=0; b<8 && same; b++) {
+            for(int c=0; c<s1->mCycles; c++)
+                same &= s1->mCycleBaseContents[b][c] == s4->mCycleBaseContents[b][c] && s1->mCycleBaseQual[b][c] == s4->mCycleBaseQual[b][c];
+        }
+        for(int i=0; i<s1->mCycles * QUAL_HIST_BINS && same; i++)
+            same &= s1->mCycleQualHist[i] == s4->mCycleQualHist[i];
+        for(int i=0; i<s1->mKmerBufLen && same; i++)
+            same &= s1->mKmer[i] == s4->mKmer[i];
+        // only the sampled reads are counted for the curves
+        long sampled = 0;
+        for(int b=0; b<8; b++)
+            sampled += s1->mCycleBaseContents[b][0];
+        long expected = 0;
+        for(long i=0; i<seqs.size(); i++)
+            expected += s1->isSampled(i);
+        same &= sampled == expected && expected < (long)seqs.size() / 5;
+
+        delete s1;
+        delete s4;
+        for(int t=0; t<single.size(); t++)
+            delete single[t];
+        for(int t=0; t<threads.size(); t++)
+            delete threads[t];
+        if(!same)
+            return false;
+    }
+
+    // the long reads with other letters, whose later cycles skip the narrow histograms, and the other letters are only in the totals
+    opt.stats.sampling = 1;
+    opt.stats.byPack = false;
+    const char letters[] = "ACGTNacgtnRYKMSW";
+    const int longLen = CYCLE_COUNTER_MAX_CYCLES * 3 + 17;
+    Stats* longStats = new Stats(&opt, false, 150);
+    vector<long> contents(8 * longLen, 0);
+    vector<long> qualSums(8 * longLen, 0);
+    vector<long> qualHist(QUAL_HIST_BINS * longLen, 0);
+    vector<long> totalBases(longLen, 0);
+    vector<long> totalQuals(longLen, 0);
+    for(int r=0; r<20; r++) {
+        string seq(longLen, 'A');
+        string qual(longLen, 'I');
+        for(int c=0; c<longLen; c++) {
+            seed = seed * 1103515245 + 12345;
+            seq[c] = letters[(seed >> 16) % 16];
+            qual[c] = 30 + (seed >> 20) % 50;
+            int b = seq[c] & 0x07;
+            if(COUNTER_SLOTS[b] < CYCLE_COUNTER_BASES) {
+                contents[b * longLen + c]++;
+                qualSums[b * longLen + c] += qual[c] - 33;
+            }
+            totalBases[c]++;
+            totalQuals[c] += qual[c] - 33;
+            qualHist[c * QUAL_HIST_BINS + min(max(qual[c] - 33, 0), QUAL_HIST_BINS - 1)]++;
+        }
+        longStats->statRead(seq.c_str(), qual.c_str(), longLen, r);
+    }
+    longStats->summarize();
+    bool same = longStats->mCounterBufLen == CYCLE_COUNTER_MAX_CYCLES;
+    for(int b=0; b<8 && same; b++) {
+        for(int c=0; c<longLen; c++)
+            same &= longStats->mCycleBaseContents[b][c] == contents[b * longLen + c] && longStats->mCycleBaseQual[b][c] == qualSums[b * longLen + c];
+    }
+    for(int c=0; c<longLen && same; c++)
+        same &= longStats->mCycleTotalBase[c] == totalBases[c] && longStats->mCycleTotalQual[c] == totalQuals[c];
+    for(int i=0; i<longLen * QUAL_HIST_BINS && same; i++)
+        same &= longStats->mCycleQualHist[i] == qualHist[i];
+    delete longStats;
+    return same;
+}
@@ -3,14 +3,42 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string>
 #include <vector>
 #include <map>
 #include "read.h"
 #include "options.h"
+#include "overrepsketch.h"
+#include "overrepindex.h"
 
 using namespace std;
 
+// quality scores 0 ~ 41 have their own bins, the lower or higher ones are counted in the first or last bin
+#define QUAL_HIST_BINS 42
+
+// in long read mode, the per-cycle stats have at most this number of position bins
+#define LONG_READ_MAX_BINS 1024
+// the distribution of overrepresented sequences only covers the first cycles, since each tracked sequence has one
+#define OVER_REP_MAX_DIST_LEN 1000
+// the bin size of the read length histogram in long read mode
+#define LONG_READ_LENGTH_BIN 100
+
+// the narrow histograms are kept for A, C, T, N and G (and their lowercase), and the other letters share the last slot
+#define CYCLE_COUNTER_BASES 5
+#define CYCLE_COUNTER_SLOTS (CYCLE_COUNTER_BASES + 1)
+// the narrow histograms cover at most this number of cycles (or position bins), the later cycles of long reads
+// are counted in the 64-bit arrays, so the histograms are never larger than the arrays they are flushed to
+#define CYCLE_COUNTER_MAX_CYCLES 1024
+
+// narrow quality histogram of one base at one cycle, statRead() increases only one bin per base
+// the histograms are flushed to the 64-bit per-cycle arrays periodically so they never overflow
+struct CycleQualHist {
+    uint32_t bins[QUAL_HIST_BINS];
+    // sum of (quality - bin) of the out-of-range qualities, to keep the quality sum exact
+    int32_t outOfRange;
+};
+
 class Stats{
 public:
     // this @guessedCycles parameter should be calculated using the first several records
@@ -23,7 +51,14 @@ public:
     long getQ30();
     long getGCNumber();
     // by default the qualified qual score is Q20 ('5')
-    void statRead(Read* r);
+    // the profile of the read for the filters is counted in the same pass
+    // index is the position of the read (pair) in the input, it decides if the read is sampled for the per-cycle stats,
+    // so the sample doesn't depend on which thread the read is given to
+    void statRead(Read* r, long index);
+    // the same as statRead(Read*), for a record not parsed to Read, the qualities should be phred33
+    void statRead(const char* seqstr, const char* qualstr, int len, long index, ReadProfile* profile = NULL);
+    // the read (pair) at the index of the input is sampled for the per-cycle stats
+    bool isSampled(long index);
 
     static Stats* merge(vector<Stats*>& list);
     void print();
@@ -39,6 +74,7 @@ public:
     bool isLongRead();
     void initOverRepSeq();
     int getMeanLength();
+    static bool test();
 
 public:
     static string list2string(double* list, int size);
@@ -48,11 +84,29 @@ public:
 
 private:
     void extendBuffer(int newBufLen);
+    // the per-cycle stats and k-mers of a sampled read
+    void statCycles(const char* seqstr, const char* qualstr, int len, ReadProfile* profile);
+    // only the totals of a read not sampled for per-cycle stats
+    void statUnsampled(const char* seqstr, const char* qualstr, int len, ReadProfile* profile);
+    void setProfile(ReadProfile* profile, int len, int lowQual, int nBase, int totalQual, int diff);
+    void flushCycleCounters();
+    void extendCycleCounters(int newLen);
+    // double the size of the position bins, two neighbor bins are summed into one
+    void foldCycles();
+    // the read length and mean quality histograms of long reads
+    void statLongRead(const char* qualstr, int len);
+    void reportHtmlLongRead(ofstream& ofs, string filteringType, string readName);
+    // the first positions of the bins in the plot coordinates, which are 1-based bin indexes
+    string positions2string(long* x, int size);
+    double getQualQuantile(int cycle, double quantile);
     string makeKmerTD(int i, int j);
     string kmer3(int val);
     string kmer2(int val);
     void deleteOverRepSeqDist();
     bool overRepPassed(string& seq, long count);
+    void selectOverRepSeqs();
+    // containers[i] are the indexes of the longer sequences containing seqs[i]
+    void findContainers(vector<string>& seqs, vector<vector<int>>& containers);
 
 private:
     Options* mOptions;
@@ -68,33 +122,53 @@ private:
     'G' % 8 = 7
     'N' % 8 = 6
     */
-    long *mCycleQ30Bases[8];
-    long *mCycleQ20Bases[8];
     long *mCycleBaseContents[8];
     long *mCycleBaseQual[8];
     long *mCycleTotalBase;
     long *mCycleTotalQual;
+    // mBufLen * QUAL_HIST_BINS, quality histograms of all bases, the histogram of cycle c starts at c * QUAL_HIST_BINS
+    long *mCycleQualHist;
     long *mKmer;
+    // mCounterBufLen * CYCLE_COUNTER_SLOTS histograms, the one of cycle c and base slot s is at c * CYCLE_COUNTER_SLOTS + s
+    CycleQualHist *mCycleCounters;
+    int mCounterBufLen;
+    // reads and the max cycle counted since last flushing
+    int mCounterReads;
+    int mCounterCycles;
 
     map<string, double*> mQualityCurves;
     map<string, double*> mContentCurves;
     map<string, long> mOverRepSeq;
     map<string, long*> mOverRepSeqDist;
+    // a sketch for each length of overrepresented sequences, mOverRepSeq is selected from them after merging
+    vector<OverRepSketch*> mOverRepSketches;
+    long mOverRepSampledBases;
 
 
     int mCycles;
     int mBufLen;
     long mBases;
-    long mQ20Bases[8];
-    long mQ30Bases[8];
     long mBaseContents[8];
     long mQ20Total;
     long mQ30Total;
+    // the bases, Q20/Q30 bases and GC bases of the reads not sampled for per-cycle stats
+    long mUnsampledBases;
+    long mUnsampledQ20;
+    long mUnsampledQ30;
+    long mUnsampledGC;
     bool summarized;
     long mKmerMax;
     long mKmerMin;
     int mKmerBufLen;
     long mLengthSum;
+    int mMaxLength;
+    // a bin of the per-cycle stats has (1 << mCycleBinShift) cycles, only long read mode has bins larger than 1
+    int mCycleBinShift;
+    // the read length histogram (LONG_READ_LENGTH_BIN per bin) and read mean quality histogram for long read mode
+    vector<long> mReadLengthHist;
+    long mReadQualHist[QUAL_HIST_BINS];
+    // the cycles covered by the distribution of overrepresented sequences
+    int mOverRepDistLen;
 };
 
 #endif
\ No newline at end of file
@@ -6,9 +6,11 @@
 #include <string>
 #include <vector>
 #include "stats.h"
-#include "writer.h"
 #include "options.h"
 #include "filterresult.h"
+#include "dupsketch.h"
+#include "overlapanalysis.h"
+#include "adapterindex.h"
 
 using namespace std;
 
@@ -20,47 +22,32 @@ public:
     inline Stats* getPostStats1() {return mPostStats1;}
     inline Stats* getPreStats2() {return mPreStats2;}
     inline Stats* getPostStats2() {return mPostStats2;}
-    inline Writer* getWriter1() {return mWriter1;}
-    inline Writer* getWriter2() {return mWriter2;}
     inline FilterResult* getFilterResult() {return mFilterResult;}
-
-    void initWriter(string filename1);
-    void initWriter(string filename1, string filename2);
-    void initWriter(ofstream* stream);
-    void initWriter(ofstream* stream1, ofstream* stream2);
-    void initWriter(gzFile gzfile);
-    void initWriter(gzFile gzfile1, gzFile gzfile2);
+    inline DupSketch* getDupSketch() {return mDupSketch;}
+    // the insert sizes of the pairs counted by this thread, the last bin is the pairs not overlapped. NULL if not paired
+    inline long* getInsertSizeHist() {return mInsertSizeHist;}
+    // the buffers of the gapped overlap analysis, NULL if not paired
+    inline OverlapGapBuffer* getOverlapGapBuffer() {return mOverlapGapBuffer;}
+    // the 4-mer positions of a read for the adapters of --adapter_fasta, NULL if they are not given
+    inline ReadSeeds* getReadSeeds() {return mReadSeeds;}
 
     void addFilterResult(int result, int readNum);
     void addMergedPairs(int pairs);
 
     int getThreadId() {return mThreadId;}
-    // for splitting output
-    // increase mCurrentSplitReads by readNum, and check it with options->split.size;
-    void markProcessed(long readNum);
-    void initWriterForSplit();
-    bool canBeStopped();
-    void cleanup();
-
-private:
-    void deleteWriter();
-    void writeEmptyFilesForSplitting();
 
 private:
     Stats* mPreStats1;
     Stats* mPostStats1;
     Stats* mPreStats2;
     Stats* mPostStats2;
-    Writer* mWriter1;
-    Writer* mWriter2;
     Options* mOptions;
     FilterResult* mFilterResult;
-
-    // for spliting output
+    DupSketch* mDupSketch;
+    long* mInsertSizeHist;
+    OverlapGapBuffer* mOverlapGapBuffer;
+    ReadSeeds* mReadSeeds;
     int mThreadId;
-    int mWorkingSplit;
-    long mCurrentSplitReads;
-    bool mCanBeStopped;
 };
 
 #endif
\ No newline at end of file
@@ -5,10 +5,21 @@
 #include "overlapanalysis.h"
 #include "filter.h"
 #include "adaptertrimmer.h"
+#include "adapterindex.h"
 #include "basecorrector.h"
 #include "polyx.h"
 #include "nucleotidetree.h"
 #include "evaluator.h"
+#include "partitionwriter.h"
+#include "shmring.h"
+#include "overrepindex.h"
+#include "overrepsketch.h"
+#include "stats.h"
+#include "qcprocessor.h"
+#include "duplicate.h"
+#include "dedupset.h"
+#include "dupsketch.h"
+#include "simd.h"
 #include <time.h>
 
 UnitTest::UnitTest(){
@@ -17,15 +28,28 @@ UnitTest::UnitTest(){
 
 void UnitTest::run(){
     bool passed = true;
+    passed &= report(Simd::test(), "Simd::test");
     passed &= report(Sequence::test(), "Sequence::test");
     passed &= report(Read::test(), "Read::test");
     passed &= report(OverlapAnalysis::test(), "OverlapAnalysis::test");
+    passed &= report(OverlapContext::test(), "OverlapContext::test");
+    passed &= report(OverlapPrior::test(), "OverlapPrior::test");
     passed &= report(Filter::test(), "Filter::test");
     passed &= report(AdapterTrimmer::test(), "AdapterTrimmer::test");
+    passed &= report(AdapterIndex::test(), "AdapterIndex::test");
     passed &= report(BaseCorrector::test(), "BaseCorrector::test");
     passed &= report(PolyX::test(), "PolyX::test");
     passed &= report(NucleotideTree::test(), "NucleotideTree::test");
     passed &= report(Evaluator::test(), "Evaluator::test");
+    passed &= report(PartitionWriter::test(), "PartitionWriter::test");
+    passed &= report(ShmRing::test(), "ShmRing::test");
+    passed &= report(OverRepIndex::test(), "OverRepIndex::test");
+    passed &= report(OverRepSketch::test(), "OverRepSketch::test");
+    passed &= report(Stats::test(), "Stats::test");
+    passed &= report(QCProcessor::test(), "QCProcessor::test");
+    passed &= report(Duplicate::test(), "Duplicate::test");
+    passed &= report(DedupSet::test(), "DedupSet::test");
+    passed &= report(DupSketch::test(), "DupSketch::test");
     printf("\n==========================\n");
     printf("%s\n\n", passed?"ALL PASSED":"FAILED");
 }
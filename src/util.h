@@ -143,6 +143,15 @@ inline string joinpath(const string& dirname, const string& basename){
     }
 }
 
+// add a 1-based sequential number prefix to the file name, like dir/0001.out.fq
+inline string prefix_number(const string& filename, int index, int digits){
+    string num = to_string(index + 1);
+    // padding for digits like 0001
+    while(num.size() < digits)
+        num = "0" + num;
+    return joinpath(dirname(filename), num + "." + basename(filename));
+}
+
 //Check if a string is a file or directory
 inline bool file_exists(const  string& s)
 {
@@ -2,11 +2,19 @@
 #include "util.h"
 #include "fastqreader.h"
 #include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 
 Writer::Writer(string filename, int compression){
 	mCompression = compression;
 	mFilename = filename;
 	mZipFile = NULL;
+	mOutStream = NULL;
+	mFd = -1;
+	mShmRing = NULL;
 	mZipped = false;
 	haveToClose = true;
 	init();
@@ -14,6 +22,8 @@ Writer::Writer(string filename, int compression){
 
 Writer::Writer(ofstream* stream) {
 	mZipFile = NULL;
+	mFd = -1;
+	mShmRing = NULL;
 	mZipped = false;
 	mOutStream = stream;
 	haveToClose = false;
@@ -21,11 +31,33 @@ Writer::Writer(ofstream* stream) {
 
 Writer::Writer(gzFile gzfile) {
 	mOutStream = NULL;
+	mFd = -1;
+	mShmRing = NULL;
 	mZipFile = gzfile;
 	mZipped = true;
 	haveToClose = false;
 }
 
+Writer::Writer(int fd, bool zipped, int compression) {
+	mCompression = compression;
+	mOutStream = NULL;
+	mZipFile = NULL;
+	mFd = -1;
+	mShmRing = NULL;
+	mZipped = zipped;
+	enlargePipe(fd);
+	if(mZipped) {
+		// gzclose is still required to finish the gzip stream
+		mZipFile = gzdopen(dup(fd), "w");
+		gzsetparams(mZipFile, mCompression, Z_DEFAULT_STRATEGY);
+		gzbuffer(mZipFile, 1024*1024);
+		haveToClose = true;
+	} else {
+		mFd = fd;
+		haveToClose = false;
+	}
+}
+
 Writer::~Writer(){
 	if(haveToClose) {
 		close();
@@ -50,12 +82,54 @@ void Writer::init(){
 	}
 }
 
+Writer::Writer(ShmRing* ring) {
+	mOutStream = NULL;
+	mZipFile = NULL;
+	mFd = -1;
+	mShmRing = ring;
+	mZipped = false;
+	haveToClose = true;
+}
+
+// a larger pipe buffer lets the downstream program read in larger chunks, so the writer blocks less
+void Writer::enlargePipe(int fd) {
+#ifdef F_SETPIPE_SZ
+	struct stat st;
+	if(fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode)) {
+		// it can fail if the size exceeds /proc/sys/fs/pipe-max-size, then the default size is kept
+		fcntl(fd, F_SETPIPE_SZ, STDOUT_PIPE_SIZE);
+	}
+#endif
+}
+
+bool Writer::writeFd(const char* strdata, size_t size) {
+	// a write to a pipe can be partial
+	while(size > 0) {
+		ssize_t written = ::write(mFd, strdata, size);
+		if(written < 0) {
+			if(errno == EINTR)
+				continue;
+			return false;
+		}
+		strdata += written;
+		size -= written;
+	}
+	return true;
+}
+
 bool Writer::writeLine(string& linestr){
 	const char* line = linestr.c_str();
 	size_t size = linestr.length();
 	size_t written;
 	bool status;
-	if(mZipped){
+	if(mShmRing) {
+		string record = linestr + "\n";
+		status = mShmRing->publish(record.c_str(), record.length());
+	}
+	else if(mFd >= 0) {
+		status = writeFd(line, size) && writeFd("\n", 1);
+	}
+	else if(mZipped){
 		written = gzwrite(mZipFile, line, size);
 		gzputc(mZipFile, '\n');
 		status = size == written;
@@ -74,7 +148,13 @@ bool Writer::writeString(string& str){
 	size_t size = str.length();
 	size_t written;
 	bool status;
-	if(mZipped){
+	if(mShmRing) {
+		status = mShmRing->publish(strdata, size);
+	}
+	else if(mFd >= 0) {
+		status = writeFd(strdata, size);
+	}
+	else if(mZipped){
 		written = gzwrite(mZipFile, strdata, size);
 		status = size == written;
 	}
@@ -86,11 +166,18 @@ bool Writer::writeString(string& str){
 	return status;
 }
 
-bool Writer::write(char* strdata, size_t size) {
+bool Writer::write(const char* strdata, size_t size) {
 	size_t written;
 	bool status;
 	
-	if(mZipped){
+	if(mShmRing) {
+		// each buffer is a pack, which is published to a slot
+		status = mShmRing->publish(strdata, size);
+	}
+	else if(mFd >= 0) {
+		status = writeFd(strdata, size);
+	}
+	else if(mZipped){
 		written = gzwrite(mZipFile, strdata, size);
 		status = size == written;
 	}
@@ -101,8 +188,56 @@ bool Writer::write(char* strdata, size_t size) {
 	return status;
 }
 
+bool Writer::write(string** buffers, int count) {
+	if(mFd < 0) {
+		bool status = true;
+		for(int i=0; i<count; i++)
+			status &= write(buffers[i]->data(), buffers[i]->size());
+		return status;
+	}
+
+	// gather the buffers to one writev call, and continue with the remaining if it's partially written
+	struct iovec iov[WRITER_IOV_LIMIT];
+	int i = 0;
+	while(i < count) {
+		int num = 0;
+		size_t total = 0;
+		while(i + num < count && num < WRITER_IOV_LIMIT) {
+			iov[num].iov_base = (void*)buffers[i + num]->data();
+			iov[num].iov_len = buffers[i + num]->size();
+			total += iov[num].iov_len;
+			num++;
+		}
+		ssize_t written = writev(mFd, iov, num);
+		if(written < 0) {
+			if(errno == EINTR)
+				continue;
+			return false;
+		}
+		if(written < total) {
+			// write the rest one by one
+			for(int k=0; k<num; k++) {
+				if(written >= iov[k].iov_len) {
+					written -= iov[k].iov_len;
+					continue;
+				}
+				if(!writeFd((const char*)iov[k].iov_base + written, iov[k].iov_len - written))
+					return false;
+				written = 0;
+			}
+		}
+		i += num;
+	}
+	return true;
+}
+
 void Writer::close(){
-	if (mZipped){
+	if(mShmRing) {
+		mShmRing->finish();
+		delete mShmRing;
+		mShmRing = NULL;
+	}
+	else if (mZipped){
 		if (mZipFile){
 			gzflush(mZipFile, Z_FINISH);
 			gzclose(mZipFile);
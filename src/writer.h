@@ -9,6 +9,7 @@
   #include "zlib/zlib.h"
 #endif
 #include "common.h"
+#include "shmring.h"
 #include <iostream>
 #include <fstream>
 
@@ -19,11 +20,17 @@ public:
 	Writer(string filename, int compression = 3);
 	Writer(ofstream* stream);
 	Writer(gzFile gzfile);
+	// write to a file descriptor like STDOUT, which is not closed by this writer
+	Writer(int fd, bool zipped, int compression = 3);
+	// publish to a shared memory ring, the ring is owned by this writer
+	Writer(ShmRing* ring);
 	~Writer();
 	bool isZipped();
 	bool writeString(string& s);
 	bool writeLine(string& linestr);
-	bool write(char* strdata, size_t size);
+	bool write(const char* strdata, size_t size);
+	// write several buffers at once, they are coalesced to one system call when possible
+	bool write(string** buffers, int count);
 	string filename();
 
 public:
@@ -32,11 +39,16 @@ public:
 private:
 	void init();
 	void close();
+	void enlargePipe(int fd);
+	bool writeFd(const char* strdata, size_t size);
 
 private:
 	string mFilename;
 	gzFile mZipFile;
 	ofstream* mOutStream;
+	// -1 if not writing to a file descriptor directly
+	int mFd;
+	ShmRing* mShmRing;
 	bool mZipped;
 	int mCompression;
 	bool haveToClose;
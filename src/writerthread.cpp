@@ -3,7 +3,7 @@
 #include <memory.h>
 #include <unistd.h>
 
-WriterThread::WriterThread(Options* opt, string filename){
+WriterThread::WriterThread(Options* opt, string filename, BufferPool* pool){
     mOptions = opt;
 
     mWriter1 = NULL;
@@ -13,16 +13,30 @@ WriterThread::WriterThread(Options* opt, string filename){
     mInputCompleted = false;
     mFilename = filename;
 
-    mRingBuffer = new char*[PACK_NUM_LIMIT];
-    memset(mRingBuffer, 0, sizeof(char*) * PACK_NUM_LIMIT);
-    mRingBufferSizes = new size_t[PACK_NUM_LIMIT];
-    memset(mRingBufferSizes, 0, sizeof(size_t) * PACK_NUM_LIMIT);
+    // the slots are always assigned before being read, so they don't need to be initialized
+    // and the memory of the slots that are never used will not be touched
+    mRingBuffer = new string*[PACK_NUM_LIMIT];
+
+    if(pool) {
+        mBufferPool = pool;
+        mOwnBufferPool = false;
+    } else {
+        mBufferPool = new BufferPool(getBufferReserve(opt), OUTPUT_BUFFER_POOL_LIMIT);
+        mOwnBufferPool = true;
+    }
     initWriter(filename);
 }
 
 WriterThread::~WriterThread() {
     cleanup();
-    delete mRingBuffer;
+    if(mOwnBufferPool)
+        delete mBufferPool;
+    delete[] mRingBuffer;
+}
+
+size_t WriterThread::getBufferReserve(Options* opt) {
+    // a pack of records, each record has name, sequence, strand and quality
+    return PACK_SIZE * (max(opt->seqLen1, opt->seqLen2) * 2 + 128);
 }
 
 bool WriterThread::isCompleted() 
@@ -39,21 +53,48 @@ void WriterThread::output(){
     if(mOutputCounter >= mInputCounter) {
         usleep(100);
     }
-    while( mOutputCounter < mInputCounter) 
+    // write all the pending buffers together, so they can be coalesced
+    long inputCounter = mInputCounter;
+    if(mOutputCounter < inputCounter) {
+        mWriter1->write(mRingBuffer + mOutputCounter, inputCounter - mOutputCounter);
+    }
+    while( mOutputCounter < inputCounter) 
     {
-        mWriter1->write(mRingBuffer[mOutputCounter], mRingBufferSizes[mOutputCounter]);
-        delete mRingBuffer[mOutputCounter];
+        string* data = mRingBuffer[mOutputCounter];
         mRingBuffer[mOutputCounter] = NULL;
+        recycleBuffer(data);
         mOutputCounter++;
     }
 }
 
-void  WriterThread::input(char* data, size_t size){
+void  WriterThread::input(string* data){
     mRingBuffer[mInputCounter] = data;
-    mRingBufferSizes[mInputCounter] = size;
     mInputCounter++;
 }
 
+string* WriterThread::getBuffer() {
+    return mBufferPool->get();
+}
+
+void WriterThread::recycleBuffer(string* data) {
+    mBufferPool->recycle(data);
+}
+
+string* WriterThread::getOutputBuffer(WriterThread* writer) {
+    if(writer == NULL)
+        return NULL;
+    return writer->getBuffer();
+}
+
+void WriterThread::outputBuffer(WriterThread* writer, string* data) {
+    if(data == NULL)
+        return;
+    if(data->empty())
+        writer->recycleBuffer(data);
+    else
+        writer->input(data);
+}
+
 void WriterThread::cleanup() {
     deleteWriter();
 }
@@ -67,7 +108,12 @@ void WriterThread::deleteWriter() {
 
 void WriterThread::initWriter(string filename1) {
     deleteWriter();
-    mWriter1 = new Writer(filename1, mOptions->compression);
+    if(filename1 == "/dev/stdout")
+        mWriter1 = new Writer(STDOUT_FILENO, mOptions->compressSTDOUT, mOptions->compression);
+    else if(mOptions->shm.enabled && filename1 == mOptions->shm.name)
+        mWriter1 = new Writer(createShmRing());
+    else
+        mWriter1 = new Writer(filename1, mOptions->compression);
 }
 
 void WriterThread::initWriter(ofstream* stream) {
@@ -80,6 +126,13 @@ void WriterThread::initWriter(gzFile gzfile) {
     mWriter1 = new Writer(gzfile);
 }
 
+ShmRing* WriterThread::createShmRing() {
+    ShmRing* ring = new ShmRing();
+    if(!ring->create(mOptions->shm.name, mOptions->shm.slots, (uint64_t)mOptions->shm.slotSize * 1024 * 1024))
+        error_exit("failed to create the shared memory output " + mOptions->shm.name);
+    return ring;
+}
+
 long WriterThread::bufferLength(){
     return mInputCounter - mOutputCounter;
 }
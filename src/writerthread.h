@@ -7,6 +7,7 @@
 #include <vector>
 #include "writer.h"
 #include "options.h"
+#include "bufferpool.h"
 #include <atomic>
 #include <mutex>
 
@@ -14,7 +15,8 @@ using namespace std;
 
 class WriterThread{
 public:
-    WriterThread(Options* opt, string filename);
+    // the buffers can be shared by several writers through pool, otherwise this writer has its own pool
+    WriterThread(Options* opt, string filename, BufferPool* pool = NULL);
     ~WriterThread();
 
     void initWriter(string filename1);
@@ -25,14 +27,28 @@ public:
 
     bool isCompleted();
     void output();
-    void input(char* data, size_t size);
+    // the ownership of data is transferred to this writer, it will be recycled after written
+    void input(string* data);
     bool setInputCompleted();
 
+    // get an empty output buffer, which is recycled from the written ones if possible
+    string* getBuffer();
+    // give back a buffer without writing it
+    void recycleBuffer(string* data);
+
+    // a buffer from the pool of writer, or NULL if there is no such writer, so the records of a disabled output are skipped
+    static string* getOutputBuffer(WriterThread* writer);
+    // hand over the buffer to its writer, an empty one is recycled
+    static void outputBuffer(WriterThread* writer, string* data);
+
     long bufferLength();
+    // the memory to reserve for a new buffer, which is enough to hold a pack of records
+    static size_t getBufferReserve(Options* opt);
     string getFilename() {return mFilename;}
 
 private:
     void deleteWriter();
+    ShmRing* createShmRing();
 
 private:
     Writer* mWriter1;
@@ -43,8 +59,10 @@ private:
     bool mInputCompleted;
     atomic_long mInputCounter;
     atomic_long mOutputCounter;
-    char** mRingBuffer;
-    size_t* mRingBufferSizes;
+    string** mRingBuffer;
+
+    BufferPool* mBufferPool;
+    bool mOwnBufferPool;
 
     mutex mtx;
 
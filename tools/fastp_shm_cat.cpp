@@ -0,0 +1,42 @@
+// the reference consumer of fastp shared memory output (--shm_out)
+// it reads the packs from the ring, writes them to STDOUT as FASTQ, and removes the ring at the end
+// usage: fastp_shm_cat /fastp_out | bwa mem -p ref.fa -
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "shmring.h"
+
+int main(int argc, char* argv[]){
+    if(argc != 2) {
+        fprintf(stderr, "usage: %s <shm_name>\n", argv[0]);
+        return 1;
+    }
+    string name = argv[1];
+
+    // fastp can be started later than this tool, so wait for the ring to be ready.
+    // a ring left by a crashed run can be attached before the new run replaces it, then the new one is attached
+    while(true) {
+        ShmRing ring;
+        while(!ring.attach(name))
+            usleep(100000);
+
+        const char* data;
+        size_t size;
+        while(ring.next(data, size)) {
+            // the payload is written from the shared memory directly
+            if(fwrite(data, 1, size, stdout) != size) {
+                fprintf(stderr, "failed to write STDOUT\n");
+                return 1;
+            }
+            ring.release();
+        }
+        if(!ring.stale())
+            break;
+        fprintf(stderr, "the ring %s is left by an earlier run, waiting for the new one\n", name.c_str());
+    }
+    fflush(stdout);
+
+    shm_unlink(name.c_str());
+    return 0;
+}